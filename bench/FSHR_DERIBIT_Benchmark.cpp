@@ -0,0 +1,1039 @@
+#include "FSHR_DERIBIT_OrderGenerator.h"
+#include "FSHR_DERIBIT_OrderProcessor.h"
+#include "FSHR_DERIBIT_OrderBatch.h"
+#include "FSHR_DERIBIT_EmissionPacer.h"
+#include "FSHR_DERIBIT_ResponseTracker.h"
+#include "FSHR_DERIBIT_NumberFormat.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_AllocationCounter.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace fischer::deribit;
+
+COUNT_GLOBAL_ALLOCATIONS();
+
+namespace
+{
+    // Keeps the compiler from discarding a result that is otherwise unused
+    template<typename T>
+    inline void DoNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    struct BenchmarkOptions
+    {
+        bench::GeneratorOptions m_Generator;
+        uint64_t m_Repetitions{7};
+        uint64_t m_MicroRows{4096};         // rows kept resident for the micro-benchmarks
+        uint64_t m_MicroOperations{2000000};
+        uint64_t m_MicroResponses{4096};    // synthetic responses when none are recorded
+        std::string m_ResponsesFile;        // recorded responses, one per line
+        std::string m_OutputFile;
+    };
+
+    struct BenchmarkResult
+    {
+        std::string m_Name;
+        uint64_t m_Operations{0};           // per repetition
+        uint64_t m_Allocations{0};          // heap allocations per repetition
+        std::vector<double> m_NsPerOperation;
+
+        double GetMin() const { return *std::min_element(m_NsPerOperation.begin(), m_NsPerOperation.end()); }
+
+        double GetMedian() const
+        {
+            std::vector<double> sorted(m_NsPerOperation);
+            std::sort(sorted.begin(), sorted.end());
+            return sorted[sorted.size() / 2];
+        }
+    };
+
+    // Exposes the protected building blocks that are timed in isolation
+    template<typename Traits>
+    class ParserProbe : public CsvParser<Traits>
+    {
+    public:
+        using CsvParser<Traits>::GetFieldIndex;
+        using CsvParser<Traits>::ParseDataLine;
+        using CsvParser<Traits>::SplitLine;
+    };
+
+    template<typename Traits>
+    class BuilderProbe : public JsonBuilder<Traits>
+    {
+    public:
+        using JsonBuilder<Traits>::EnsureCapacity;
+        using JsonBuilder<Traits>::AppendDouble;
+        using JsonBuilder<Traits>::AppendInt64;
+    };
+
+    // Runs `pass` (which performs `operationsPerPass` operations) often enough
+    // to reach roughly `targetOperations`, once per repetition
+    template<typename Function>
+    BenchmarkResult Measure(std::string name, uint64_t operationsPerPass, uint64_t targetOperations,
+                            uint64_t repetitions, Function pass)
+    {
+        const uint64_t passes = std::max<uint64_t>(1, targetOperations / std::max<uint64_t>(1, operationsPerPass));
+
+        BenchmarkResult result;
+        result.m_Name = std::move(name);
+        result.m_Operations = passes * operationsPerPass;
+        result.m_NsPerOperation.reserve(repetitions);
+
+        pass();  // warm caches and buffers
+
+        const AllocationCounter::Snapshot allocationStart = AllocationCounter::Read();
+        for (uint64_t repetition = 0; repetition < repetitions; ++repetition)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (uint64_t index = 0; index < passes; ++index)
+            {
+                pass();
+            }
+            const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+            result.m_NsPerOperation.push_back(elapsed.count() / static_cast<double>(result.m_Operations));
+        }
+        result.m_Allocations = (AllocationCounter::Read() - allocationStart).m_Allocations /
+                               std::max<uint64_t>(1, repetitions);
+
+        return result;
+    }
+
+    // The default number format must render exactly as the printf call it
+    // replaced: compares the two on raw bit patterns (NaNs, infinities and
+    // subnormals included), two- and four-decimal prices, integers, negative
+    // prices and tiny values; false on the first difference
+    bool CheckNumberFormat(const BenchmarkOptions& options)
+    {
+        constexpr uint64_t CorpusSize = 1 << 20;
+        constexpr int Precision = DeribitTraits::DoublePrecision;
+        bench::SplitMix64 random(options.m_Generator.m_Seed);
+        char compatible[DeribitTraits::MaxDoubleStringLength];
+        char reference[DeribitTraits::MaxDoubleStringLength];
+
+        for (uint64_t index = 0; index < CorpusSize; ++index)
+        {
+            double value = 0.0;
+            switch (index % 6)
+            {
+            case 0: value = std::bit_cast<double>(random.Next()); break;
+            case 1: value = static_cast<double>(random.Below(10000000000)) / 100.0; break;
+            case 2: value = static_cast<double>(random.Below(10000000000)) / 10000.0; break;
+            case 3: value = static_cast<double>(static_cast<int64_t>(random.Next() >> random.Below(64))); break;
+            case 4: value = -static_cast<double>(random.Below(100000000)) / 100.0; break;
+            default: value = random.Unit() * std::pow(10.0, -static_cast<double>(random.Below(320))); break;
+            }
+
+            const size_t length = utils::FormatDouble(compatible, sizeof(compatible), value,
+                                                      NumberFormat::Compatible, Precision);
+            const int referenceLength = std::snprintf(reference, sizeof(reference), "%.*g", Precision, value);
+            if (std::string_view(compatible, length) != std::string_view(reference, static_cast<size_t>(referenceLength)))
+            {
+                std::fprintf(stderr, "FormatDouble differs from %%.%dg for %a: %.*s, expected %s\n", Precision, value,
+                             static_cast<int>(length), compatible, reference);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Texts render as the same valid JSON whether they are copied from the
+    // row, from an interned fragment, or from the row past a full intern
+    // table: builds rows holding quotes, backslashes and control bytes the
+    // three ways; false on the first difference
+    bool CheckEscaping()
+    {
+        using Traits = DeribitTraits;
+        const std::string csv = "id,direction,amount,instrument_name,label,advanced\n"
+                                "1,buy,10,BTC\"X,lab\"el,a\\b\n"
+                                "2,se\tll,10,ET\x01H\\,x\x1Fy,\"q\"\n";
+        const std::string firstId = std::to_string(Traits::InitialMessageId);
+        const std::string secondId = std::to_string(Traits::InitialMessageId + 1);
+        const std::string expected =
+            "{\"id\":" + firstId + ",\"jsonrpc\":\"2.0\",\"method\":\"private/buy\",\"params\":{\"amount\":10,"
+            "\"instrument_name\":\"BTC\\\"X\",\"label\":\"lab\\\"el\",\"advanced\":\"a\\\\b\"}}\n"
+            "{\"id\":" + secondId + ",\"jsonrpc\":\"2.0\",\"method\":\"private/se\\u0009ll\",\"params\":{\"amount\":10,"
+            "\"instrument_name\":\"ET\\u0001H\\\\\",\"label\":\"x\\u001fy\",\"advanced\":\"\\\"q\\\"\"}}\n";
+
+        const char* dataBegin = csv.data() + csv.find('\n') + 1;
+        const char* dataEnd = csv.data() + csv.size();
+
+        MessageFragments<Traits> fragments;
+        MessageFragments<Traits> fullFragments;
+        for (uint32_t index = 0; index < Traits::InternTableCapacity; ++index)
+        {
+            const std::string filler = "filler_" + std::to_string(index);
+            fullFragments.m_Methods.Intern(filler);
+            fullFragments.m_Instruments.Intern(filler);
+        }
+
+        const std::pair<const char*, MessageFragments<Traits>*> modes[] = {
+            {"raw", nullptr}, {"interned", &fragments}, {"full table", &fullFragments}};
+        for (const auto& [name, modeFragments] : modes)
+        {
+            ParserProbe<Traits> parser;
+            parser.ParseHeaders(csv.data(), dataBegin - 1);
+            parser.SetFragments(modeFragments);
+            OrderVector<Traits> orders;
+            parser.ParseLines(dataBegin, dataEnd, orders);
+
+            JsonBuilder<Traits> builder;
+            builder.SetFragments(modeFragments);
+            typename Traits::MessageIdType messageId = Traits::InitialMessageId;
+            for (const Order<Traits>& order : orders)
+            {
+                builder.BuildOrderMessage(order, messageId++);
+            }
+
+            if (builder.GetView() != expected)
+            {
+                std::fprintf(stderr, "Escaped output from the %s path differs:\n%.*s", name,
+                             static_cast<int>(builder.GetView().size()), builder.GetView().data());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // False if a self-check of the timed code failed
+    template<typename Traits>
+    bool RunMicroBenchmarks(const BenchmarkOptions& options, const std::string& csv,
+                            std::vector<BenchmarkResult>& results)
+    {
+        using SizeType = typename Traits::SizeType;
+        using OrderType = Order<Traits>;
+
+        struct SplitRow
+        {
+            const char* m_Start;
+            typename CsvParser<Traits>::FieldBoundaries m_FieldEnds;
+            SizeType m_FieldCount;
+        };
+
+        const char* dataBegin = csv.data() + csv.find('\n') + 1;
+        const char* dataEnd = csv.data() + csv.size();
+
+        ParserProbe<Traits> parser;
+        parser.ParseHeaders(csv.data(), dataBegin - 1);
+
+        // GetFieldIndex: every known column name plus two misses
+        std::vector<std::string_view> names;
+        for (const FieldDescriptor& field : FieldTable)
+        {
+            names.push_back(field.m_Name);
+        }
+        names.push_back("unknown_column");
+        names.push_back("x");
+
+        results.push_back(Measure("GetFieldIndex", names.size(), options.m_MicroOperations * 10,
+                                  options.m_Repetitions, [&]
+        {
+            for (std::string_view name : names)
+            {
+                DoNotOptimize(parser.GetFieldIndex(name));
+            }
+        }));
+
+        // ParseDataLine over rows that were split once up front
+        std::vector<SplitRow> rows;
+        {
+            StructuralScanner<Traits> scanner(dataBegin, dataEnd);
+            const char* current = dataBegin;
+            while (current < dataEnd)
+            {
+                SplitRow row{current, {}, 0};
+                const char* lineEnd = parser.SplitLine(scanner, row.m_FieldEnds, row.m_FieldCount);
+                if (lineEnd > current)
+                {
+                    rows.push_back(row);
+                }
+                current = lineEnd + 1;
+            }
+        }
+
+        results.push_back(Measure("ParseDataLine", rows.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            for (const SplitRow& row : rows)
+            {
+                OrderType order;
+                DoNotOptimize(parser.ParseDataLine(row.m_Start, row.m_FieldEnds, row.m_FieldCount, order));
+                DoNotOptimize(order);
+            }
+        }));
+
+        // The same rows with interning: one hash and probe per instrument and direction
+        ParserProbe<Traits> internParser;
+        MessageFragments<Traits> fragments;
+        internParser.ParseHeaders(csv.data(), dataBegin - 1);
+        internParser.SetFragments(&fragments);
+
+        results.push_back(Measure("ParseDataLine (interned)", rows.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            for (const SplitRow& row : rows)
+            {
+                OrderType order;
+                DoNotOptimize(internParser.ParseDataLine(row.m_Start, row.m_FieldEnds, row.m_FieldCount, order));
+                DoNotOptimize(order);
+            }
+        }));
+
+        // Number formatting, on values shaped like the generated prices and ids
+        constexpr size_t ValueBatch = 1024;
+        bench::SplitMix64 random(options.m_Generator.m_Seed);
+        std::vector<double> doubles(ValueBatch);
+        std::vector<int64_t> integers(ValueBatch);
+        for (size_t index = 0; index < ValueBatch; ++index)
+        {
+            doubles[index] = static_cast<double>(1 + random.Below(1000000000)) /
+                             static_cast<double>(uint64_t{1} << (2 * random.Below(7)));
+            integers[index] = static_cast<int64_t>(random.Below(uint64_t{1} << (random.Below(63) + 1)));
+        }
+
+        BuilderProbe<Traits> builder;
+        results.push_back(Measure("AppendDouble", ValueBatch, options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            builder.Reset();
+            builder.EnsureCapacity(ValueBatch * Traits::MaxDoubleStringLength);
+            for (double value : doubles)
+            {
+                builder.AppendDouble(value);
+            }
+            DoNotOptimize(builder.GetBufferPosition());
+        }));
+
+        results.push_back(Measure("AppendInt64", ValueBatch, options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            builder.Reset();
+            builder.EnsureCapacity(ValueBatch * Traits::MaxInt64StringLength);
+            for (int64_t value : integers)
+            {
+                builder.AppendInt64(value);
+            }
+            DoNotOptimize(builder.GetBufferPosition());
+        }));
+
+        // BuildOrderMessage over the parsed rows
+        OrderVector<Traits> orders;
+        parser.ParseLines(dataBegin, dataEnd, orders);
+
+        JsonBuilder<Traits> messageBuilder;
+        results.push_back(Measure("BuildOrderMessage", orders.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            messageBuilder.Reset();
+            typename Traits::MessageIdType messageId = Traits::InitialMessageId;
+            for (const OrderType& order : orders)
+            {
+                messageBuilder.BuildOrderMessage(order, messageId++);
+            }
+            DoNotOptimize(messageBuilder.GetBufferPosition());
+        }));
+
+        // The same orders with the envelope and instrument copied from fragments
+        OrderVector<Traits> internedOrders;
+        internParser.ParseLines(dataBegin, dataEnd, internedOrders);
+
+        JsonBuilder<Traits> fragmentBuilder;
+        fragmentBuilder.SetFragments(&fragments);
+        results.push_back(Measure("BuildOrderMessage (interned)", internedOrders.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            fragmentBuilder.Reset();
+            typename Traits::MessageIdType messageId = Traits::InitialMessageId;
+            for (const OrderType& order : internedOrders)
+            {
+                fragmentBuilder.BuildOrderMessage(order, messageId++);
+            }
+            DoNotOptimize(fragmentBuilder.GetBufferPosition());
+        }));
+
+        // Validation without reference data; each pass restores the batch the
+        // previous pass compacted, so a 128-byte copy per order is included
+        OrderValidator<Traits> validator(nullptr, &fragments);
+        OrderVector<Traits> batch;
+        std::vector<Reject> rejects;
+        results.push_back(Measure("ValidateOrders", internedOrders.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            batch.assign(internedOrders.begin(), internedOrders.end());
+            rejects.clear();
+            validator.Validate(batch, rejects);
+            DoNotOptimize(batch.size());
+        }));
+
+        // Pacing bookkeeping per message on a simulated clock, so nothing is
+        // spent waiting. Each send costs a third of the refill interval, which
+        // mixes grouped, immediate and delayed releases; by any release the
+        // schedule must have let out no more than the burst plus one message
+        // per elapsed interval.
+        constexpr SizeType PacedMessages = 4096;
+        constexpr SizeType PacingBurst = 16;
+        constexpr int64_t PacingInterval = 10000;
+        bool conforming = true;
+
+        results.push_back(Measure("EmissionPacer (simulated)", PacedMessages, options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            EmissionPacer<Traits, SimulatedPacingClock> pacer(1e9 / PacingInterval, PacingBurst);
+            SimulatedPacingClock& clock = pacer.GetClock();
+            SizeType released = 0;
+
+            pacer.Release(PacedMessages, [&](SizeType count)
+            {
+                released += count;
+                conforming &= released <= PacingBurst + static_cast<SizeType>(clock.Now() / PacingInterval);
+                clock.Advance(PacingInterval / 3);
+            });
+            DoNotOptimize(pacer.GetAchievedRate());
+        }));
+
+        if (false == conforming)
+        {
+            std::fprintf(stderr, "EmissionPacer (simulated) released more than its token bucket allows\n");
+        }
+        return conforming;
+    }
+
+    // A response shaped like the exchange's answer to an order request: most
+    // rest as open or partially filled orders, some come back filled with
+    // their trades listed, and the rest are errors
+    void AppendSyntheticResponse(std::string& out, bench::SplitMix64& random, int64_t id)
+    {
+        static constexpr std::string_view States[] = {"open", "open", "open", "filled", "cancelled", "untriggered"};
+        const std::string ids = std::to_string(id);
+        const std::string timestamp = std::to_string(1700000000000 + random.Below(100000000));
+        const uint64_t received = 1700000000000000 + random.Below(100000000000);
+        const uint64_t kind = random.Below(100);
+
+        out.append("{\"jsonrpc\":\"2.0\",\"id\":").append(ids);
+        if (85 <= kind)
+        {
+            out.append(",\"error\":{\"message\":\"not_enough_funds\",\"data\":{\"reason\":\"insufficient margin\","
+                       "\"param\":\"amount\"},\"code\":10009}");
+        }
+        else
+        {
+            const bool filled = 60 <= kind;
+            out.append(",\"result\":{\"trades\":[");
+            for (uint64_t trade = 0, tradeCount = true == filled ? 1 + random.Below(3) : 0; trade < tradeCount; ++trade)
+            {
+                out.append(0 == trade ? "" : ",").append("{\"trade_seq\":").append(std::to_string(random.Below(1000000)))
+                   .append(",\"trade_id\":\"ETH-").append(std::to_string(random.Below(100000000)))
+                   .append("\",\"timestamp\":").append(timestamp).append(",\"tick_direction\":")
+                   .append(std::to_string(random.Below(4))).append(",\"state\":\"filled\",\"price\":")
+                   .append(std::to_string(1000 + random.Below(3000))).append(".5,\"order_type\":\"market\","
+                   "\"fee_currency\":\"ETH\",\"fee\":0.0000105,\"direction\":\"buy\",\"amount\":1.0}");
+            }
+            out.append("],\"order\":{\"web\":false,\"time_in_force\":\"good_til_cancelled\",\"replaced\":false,"
+                       "\"reduce_only\":false,\"price\":").append(std::to_string(1000 + random.Below(3000)))
+               .append(".25,\"post_only\":false,\"order_type\":\"").append(true == filled ? "market" : "limit")
+               .append("\",\"order_state\":\"").append(true == filled ? "filled" : States[random.Below(std::size(States))])
+               .append("\",\"order_id\":\"ETH-").append(std::to_string(random.Below(10000000000)))
+               .append("\",\"max_show\":10.0,\"last_update_timestamp\":").append(timestamp)
+               .append(",\"label\":\"market0000234\",\"is_liquidation\":false,\"instrument_name\":\"ETH-PERPETUAL\","
+                       "\"filled_amount\":").append(true == filled ? "10.0" : "0.0")
+               .append(",\"direction\":\"buy\",\"creation_timestamp\":").append(timestamp)
+               .append(",\"average_price\":0.0,\"api\":true,\"amount\":10.0}}");
+        }
+        out.append(",\"usIn\":").append(std::to_string(received)).append(",\"usOut\":")
+           .append(std::to_string(received + 120)).append(",\"usDiff\":120,\"testnet\":true}");
+    }
+
+    // The recorded responses, one per line, or synthetic ones answering
+    // consecutive requests; false if the file cannot be read
+    bool LoadResponses(const BenchmarkOptions& options, std::string& text, std::vector<std::string_view>& responses)
+    {
+        if (true == options.m_ResponsesFile.empty())
+        {
+            bench::SplitMix64 random(options.m_Generator.m_Seed);
+            for (uint64_t index = 0; index < options.m_MicroResponses; ++index)
+            {
+                AppendSyntheticResponse(text, random, DeribitTraits::InitialMessageId + static_cast<int64_t>(index));
+                text.push_back('\n');
+            }
+        }
+        else
+        {
+            std::ifstream file(options.m_ResponsesFile, std::ios::binary);
+            if (false == file.is_open())
+            {
+                return false;
+            }
+            text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        for (size_t start = 0; start < text.size();)
+        {
+            const size_t end = std::min(text.find('\n', start), text.size());
+            if (end > start)
+            {
+                responses.emplace_back(text.data() + start, end - start);
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    // Response ingest: the scan alone, then the scan with the tracker's
+    // lookup and bookkeeping. Every request the responses answer is marked
+    // sent before each pass, so each response finds an outstanding entry;
+    // false if one with an id was not matched.
+    template<typename Traits>
+    bool RunResponseBenchmarks(const std::vector<std::string_view>& responses, const BenchmarkOptions& options,
+                               std::vector<BenchmarkResult>& results)
+    {
+        using ParserType = ResponseParser<Traits>;
+        using MessageIdType = typename Traits::MessageIdType;
+
+        MessageIdType firstId = std::numeric_limits<MessageIdType>::max();
+        MessageIdType lastId = std::numeric_limits<MessageIdType>::min();
+        uint64_t recognized = 0;
+        for (std::string_view text : responses)
+        {
+            typename ParserType::Response response;
+            if (true == ParserType::Parse(text, response) && true == response.m_HasId)
+            {
+                firstId = std::min(firstId, response.m_Id);
+                lastId = std::max(lastId, response.m_Id);
+                recognized++;
+            }
+        }
+
+        results.push_back(Measure("ParseResponse", responses.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            for (std::string_view text : responses)
+            {
+                typename ParserType::Response response;
+                DoNotOptimize(ParserType::Parse(text, response));
+                DoNotOptimize(response);
+            }
+        }));
+
+        // IDs scattered far apart would need a table of the whole span; those
+        // beyond a few times the response count are left unmatched
+        const uint64_t span = 0 == recognized ? 0 : std::min<uint64_t>(static_cast<uint64_t>(lastId - firstId) + 1,
+                                                                        4 * responses.size());
+        ResponseTracker<Traits> tracker;
+        results.push_back(Measure("MatchResponse", responses.size(), options.m_MicroOperations,
+                                  options.m_Repetitions, [&]
+        {
+            tracker.Start(firstId, span);
+            tracker.OnSent(span, 1);
+            uint64_t ticks = 1;
+            for (std::string_view text : responses)
+            {
+                tracker.OnMessage(text, ticks += 1000);
+            }
+            DoNotOptimize(tracker.GetMatchedCount());
+        }));
+
+        if (recognized != tracker.GetMatchedCount())
+        {
+            std::fprintf(stderr, "MatchResponse matched %llu of %llu responses with an id; repeated or scattered ids stay unmatched\n",
+                         static_cast<unsigned long long>(tracker.GetMatchedCount()),
+                         static_cast<unsigned long long>(recognized));
+        }
+        return recognized == tracker.GetMatchedCount();
+    }
+
+    template<typename Traits>
+    void RunEndToEnd(std::string name, const BenchmarkOptions& options, const ProcessorOptions<Traits>& processorOptions,
+                     const std::string& inputFile, const std::string& outputFile,
+                     std::vector<BenchmarkResult>& results)
+    {
+        BenchmarkResult result;
+        result.m_Name = std::move(name);
+
+        for (uint64_t repetition = 0; repetition <= options.m_Repetitions; ++repetition)
+        {
+            OrderProcessor<Traits> processor(processorOptions);
+
+            const auto start = std::chrono::steady_clock::now();
+            processor.ProcessOrders(inputFile, outputFile);
+            const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+            result.m_Operations = processor.GetProcessedOrderCount();
+            result.m_Allocations = processor.GetAllocations().m_Allocations;
+            if (0 < repetition && 0 < result.m_Operations)
+            {
+                // The first run only warms the page cache
+                result.m_NsPerOperation.push_back(elapsed.count() / static_cast<double>(result.m_Operations));
+            }
+        }
+
+        if (false == result.m_NsPerOperation.empty())
+        {
+            results.push_back(std::move(result));
+        }
+        else
+        {
+            std::fprintf(stderr, "%s processed no orders\n", result.m_Name.c_str());
+        }
+    }
+
+    template<typename Traits>
+    void RunEndToEndSuite(std::string_view prefix, const BenchmarkOptions& options, const std::string& inputFile,
+                          const std::string& binaryFile, const std::string& outputFile,
+                          std::vector<BenchmarkResult>& results)
+    {
+        ProcessorOptions<Traits> serial;
+        serial.m_ThreadCount = 1;
+        RunEndToEnd(std::string(prefix) + "/serial", options, serial, inputFile, outputFile, results);
+
+        ProcessorOptions<Traits> parallel;
+        parallel.m_ThreadCount = 0;
+        RunEndToEnd(std::string(prefix) + "/threads", options, parallel, inputFile, outputFile, results);
+
+        ProcessorOptions<Traits> streaming;
+        streaming.m_StreamWindowRows = Traits::DefaultStreamWindowRows;
+        RunEndToEnd(std::string(prefix) + "/stream", options, streaming, inputFile, outputFile, results);
+
+        // The conversion's output is the binary run's input
+        ProcessorOptions<Traits> convert;
+        convert.m_OutputFormat = OutputFormat::Binary;
+        RunEndToEnd(std::string(prefix) + "/convert", options, convert, inputFile, binaryFile, results);
+
+        ProcessorOptions<Traits> binary;
+        binary.m_InputFormat = InputFormat::Binary;
+        RunEndToEnd(std::string(prefix) + "/binary", options, binary, binaryFile, outputFile, results);
+
+        // The warm-up run fills the encode cache, so the measured runs are
+        // reruns over unchanged input
+        ProcessorOptions<Traits> incremental;
+        incremental.m_EnableIncremental = true;
+        RunEndToEnd(std::string(prefix) + "/incremental", options, incremental, inputFile, outputFile, results);
+        std::filesystem::remove(outputFile + std::string(CacheFileSuffix));
+    }
+
+    // The generated rows as one file holding half of them and
+    // BatchSmallFiles files sharing the rest, the shape a batch mixing
+    // large and small inputs plans for
+    constexpr uint64_t BatchSmallFiles = 31;
+
+    bool WriteBatchInputs(const BenchmarkOptions& options, const std::filesystem::path& directory,
+                          std::vector<std::string>& inputFiles)
+    {
+        std::filesystem::create_directories(directory);
+        bench::OrderGenerator generator(options.m_Generator);
+        const uint64_t rows = options.m_Generator.m_Rows;
+        uint64_t row = 0;
+
+        for (uint64_t file = 0; file <= BatchSmallFiles; ++file)
+        {
+            const uint64_t end = 0 == file ? rows / 2 : rows / 2 + (rows - rows / 2) * file / BatchSmallFiles;
+            const std::string name = (directory / ("batch_" + std::to_string(file) + ".csv")).string();
+
+            std::string buffer;
+            generator.AppendHeader(buffer);
+            for (; row < end; ++row)
+            {
+                generator.AppendRow(buffer, row);
+            }
+
+            std::ofstream input(name, std::ios::binary | std::ios::trunc);
+            input.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (false == input.good())
+            {
+                std::fprintf(stderr, "Failed to write benchmark input: %s\n", name.c_str());
+                return false;
+            }
+            inputFiles.push_back(name);
+        }
+
+        return true;
+    }
+
+    template<typename Traits>
+    void RunBatchEndToEnd(std::string name, const BenchmarkOptions& options,
+                          const ProcessorOptions<Traits>& processorOptions, const std::vector<std::string>& inputFiles,
+                          std::vector<BenchmarkResult>& results)
+    {
+        BenchmarkResult result;
+        result.m_Name = std::move(name);
+
+        for (uint64_t repetition = 0; repetition <= options.m_Repetitions; ++repetition)
+        {
+            OrderBatch<Traits> batch(processorOptions);
+
+            const auto start = std::chrono::steady_clock::now();
+            batch.ProcessFiles(inputFiles);
+            const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+
+            result.m_Operations = batch.GetProcessedOrderCount();
+            result.m_Allocations = batch.GetAllocations().m_Allocations;
+            if (0 < repetition && 0 < result.m_Operations)
+            {
+                result.m_NsPerOperation.push_back(elapsed.count() / static_cast<double>(result.m_Operations));
+            }
+        }
+
+        if (false == result.m_NsPerOperation.empty())
+        {
+            results.push_back(std::move(result));
+        }
+        else
+        {
+            std::fprintf(stderr, "%s processed no orders\n", result.m_Name.c_str());
+        }
+    }
+
+    bool ReadWholeFile(const std::string& name, std::string& text)
+    {
+        std::ifstream file(name, std::ios::binary);
+        text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return false == file.bad() && true == file.is_open();
+    }
+
+    // A batch must write what one serial run of its files joined end to end
+    // writes: small files before, between and after files large enough to
+    // be split, on one and on four workers; false on the first difference
+    bool CheckBatchPlanning(const BenchmarkOptions& options, const std::filesystem::path& directory)
+    {
+        // Rows per file, 0 for a file past three parallel chunks
+        constexpr uint64_t FileRows[] = {40, 0, 40, 1, 0, 40};
+        std::filesystem::create_directories(directory);
+        bench::OrderGenerator generator(options.m_Generator);
+        std::vector<std::string> inputFiles;
+        std::string joined;
+        generator.AppendHeader(joined);
+        uint64_t row = 0;
+
+        for (uint64_t file = 0; file < std::size(FileRows); ++file)
+        {
+            std::string buffer;
+            generator.AppendHeader(buffer);
+            const size_t headerSize = buffer.size();
+            for (uint64_t count = 0; 0 == FileRows[file] ? buffer.size() <= 3 * DeribitTraits::MinParallelChunkSize
+                                                         : count < FileRows[file]; ++count, ++row)
+            {
+                generator.AppendRow(buffer, row);
+            }
+            joined.append(buffer, headerSize);
+
+            const std::string name = (directory / ("check_" + std::to_string(file) + ".csv")).string();
+            std::ofstream input(name, std::ios::binary | std::ios::trunc);
+            input.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            if (false == input.good())
+            {
+                std::fprintf(stderr, "Failed to write benchmark input: %s\n", name.c_str());
+                return false;
+            }
+            inputFiles.push_back(name);
+        }
+
+        const std::string joinedInput = (directory / "joined.csv").string();
+        const std::string joinedOutput = (directory / "joined.json").string();
+        {
+            std::ofstream input(joinedInput, std::ios::binary | std::ios::trunc);
+            input.write(joined.data(), static_cast<std::streamsize>(joined.size()));
+        }
+
+        ProcessorOptions<DeribitTraits> serial;
+        serial.m_ThreadCount = 1;
+        OrderProcessor<DeribitTraits>(serial).ProcessOrders(joinedInput, joinedOutput);
+        std::string expected;
+        if (false == ReadWholeFile(joinedOutput, expected))
+        {
+            std::fprintf(stderr, "Failed to read serial output: %s\n", joinedOutput.c_str());
+            return false;
+        }
+
+        for (const DeribitTraits::SizeType workers : {1, 4})
+        {
+            ProcessorOptions<DeribitTraits> batch;
+            batch.m_ThreadCount = workers;
+            batch.m_OutputDirectory = (directory / "out").string();
+            OrderBatch<DeribitTraits>(batch).ProcessFiles(inputFiles);
+
+            std::string actual;
+            for (const std::string& input : inputFiles)
+            {
+                std::string text;
+                const std::filesystem::path output =
+                    std::filesystem::path(batch.m_OutputDirectory) / std::filesystem::path(input).stem();
+                if (false == ReadWholeFile(output.string() + ".json", text))
+                {
+                    std::fprintf(stderr, "Failed to read batch output: %s.json\n", output.string().c_str());
+                    return false;
+                }
+                actual.append(text);
+            }
+
+            if (actual != expected)
+            {
+                std::fprintf(stderr, "Batch output on %llu workers differs from the serial run\n",
+                             static_cast<unsigned long long>(workers));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void AppendJsonString(std::string& out, std::string_view text)
+    {
+        out.push_back('"');
+        out.append(text);
+        out.push_back('"');
+    }
+
+    template<typename T>
+    void AppendJsonNumber(std::string& out, T value)
+    {
+        char digits[32];
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+    std::string BuildJsonReport(const BenchmarkOptions& options, const std::vector<BenchmarkResult>& results)
+    {
+        const bench::GeneratorOptions& generator = options.m_Generator;
+        std::string out;
+
+        out.append("{\"config\":{\"rows\":");
+        AppendJsonNumber(out, generator.m_Rows);
+        out.append(",\"seed\":");
+        AppendJsonNumber(out, generator.m_Seed);
+        out.append(",\"sparsity\":");
+        AppendJsonNumber(out, generator.m_Sparsity);
+        out.append(",\"min_label_length\":");
+        AppendJsonNumber(out, generator.m_MinLabelLength);
+        out.append(",\"max_label_length\":");
+        AppendJsonNumber(out, generator.m_MaxLabelLength);
+        out.append(",\"instruments\":");
+        AppendJsonNumber(out, generator.m_InstrumentCount);
+        out.append(",\"repetitions\":");
+        AppendJsonNumber(out, options.m_Repetitions);
+        out.append("},\"benchmarks\":[");
+
+        for (size_t index = 0; index < results.size(); ++index)
+        {
+            const BenchmarkResult& result = results[index];
+            out.append(0 == index ? "{\"name\":" : ",{\"name\":");
+            AppendJsonString(out, result.m_Name);
+            out.append(",\"operations\":");
+            AppendJsonNumber(out, result.m_Operations);
+            out.append(",\"allocations\":");
+            AppendJsonNumber(out, result.m_Allocations);
+            out.append(",\"min_ns_per_op\":");
+            AppendJsonNumber(out, result.GetMin());
+            out.append(",\"median_ns_per_op\":");
+            AppendJsonNumber(out, result.GetMedian());
+            out.append(",\"ops_per_second\":");
+            AppendJsonNumber(out, static_cast<uint64_t>(1e9 / result.GetMedian()));
+            out.append("}");
+        }
+
+        out.append("]}\n");
+        return out;
+    }
+
+    template<typename T>
+    bool ParseValue(std::string_view argument, T& value)
+    {
+        const std::string_view text = argument.substr(argument.find('=') + 1);
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return std::errc{} == error && text.data() + text.size() == end;
+    }
+
+    bool ParseCommandLine(int argc, char* argv[], BenchmarkOptions& options)
+    {
+        options.m_Generator.m_Rows = 1000000;
+
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string_view argument(argv[i]);
+            bool valid = true;
+
+            if (true == argument.starts_with("--rows="))
+            {
+                valid = ParseValue(argument, options.m_Generator.m_Rows) && 0 < options.m_Generator.m_Rows;
+            }
+            else if (true == argument.starts_with("--seed="))
+            {
+                valid = ParseValue(argument, options.m_Generator.m_Seed);
+            }
+            else if (true == argument.starts_with("--sparsity="))
+            {
+                valid = ParseValue(argument, options.m_Generator.m_Sparsity);
+            }
+            else if (true == argument.starts_with("--instruments="))
+            {
+                valid = ParseValue(argument, options.m_Generator.m_InstrumentCount);
+            }
+            else if (true == argument.starts_with("--repetitions="))
+            {
+                valid = ParseValue(argument, options.m_Repetitions) && 0 < options.m_Repetitions;
+            }
+            else if (true == argument.starts_with("--responses="))
+            {
+                options.m_ResponsesFile = std::string(argument.substr(argument.find('=') + 1));
+            }
+            else if (true == argument.starts_with("--output="))
+            {
+                options.m_OutputFile = std::string(argument.substr(argument.find('=') + 1));
+            }
+            else
+            {
+                valid = false;
+            }
+
+            if (false == valid)
+            {
+                std::fprintf(stderr, "Invalid argument: %s\n", argv[i]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+// Usage: deribit_benchmark [--rows=N] [--seed=S] [--sparsity=P] [--instruments=K]
+//        [--repetitions=R] [--responses=FILE] [--output=results.json]
+// Micro-benchmarks run on a small resident sample of the generated input;
+// the end-to-end runs process a generated file of --rows rows. Response
+// ingest is timed on the exchange responses recorded in --responses, one
+// per line, or on synthetic ones. Exits non-zero if a self-check of the
+// benchmarked code fails, after reporting the results.
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    if (false == ParseCommandLine(argc, argv, options))
+    {
+        return 1;
+    }
+
+    // Keep logging off the measured paths
+    Logger<DeribitTraits>::GetInstance().Initialize("", LogLevel::Error, false, false, false);
+
+    std::vector<BenchmarkResult> results;
+    bool checksPassed = CheckNumberFormat(options);
+    checksPassed &= CheckEscaping();
+
+    {
+        bench::GeneratorOptions sampleOptions = options.m_Generator;
+        sampleOptions.m_Rows = options.m_MicroRows;
+        bench::OrderGenerator generator(sampleOptions);
+
+        std::string sample;
+        generator.AppendHeader(sample);
+        for (uint64_t row = 0; row < sampleOptions.m_Rows; ++row)
+        {
+            generator.AppendRow(sample, row);
+        }
+
+        checksPassed &= RunMicroBenchmarks<DeribitTraits>(options, sample, results);
+    }
+
+    {
+        std::string text;
+        std::vector<std::string_view> responses;
+        if (false == LoadResponses(options, text, responses))
+        {
+            std::fprintf(stderr, "Cannot read responses from %s\n", options.m_ResponsesFile.c_str());
+            return 1;
+        }
+        if (false == responses.empty())
+        {
+            checksPassed &= RunResponseBenchmarks<DeribitTraits>(responses, options, results);
+        }
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path();
+    const std::string inputFile = (directory / "deribit_benchmark_input.csv").string();
+    const std::string binaryFile = (directory / "deribit_benchmark_input.bin").string();
+    const std::string outputFile = (directory / "deribit_benchmark_output.json").string();
+
+    {
+        std::ofstream input(inputFile, std::ios::binary | std::ios::trunc);
+        bench::OrderGenerator generator(options.m_Generator);
+        std::string buffer;
+        generator.AppendHeader(buffer);
+
+        for (uint64_t row = 0; row < options.m_Generator.m_Rows; ++row)
+        {
+            generator.AppendRow(buffer, row);
+            if (1 << 20 <= buffer.size())
+            {
+                input.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                buffer.clear();
+            }
+        }
+        input.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+        if (false == input.good())
+        {
+            std::fprintf(stderr, "Failed to write benchmark input: %s\n", inputFile.c_str());
+            return 1;
+        }
+    }
+
+    RunEndToEndSuite<DeribitTraits>("ProcessOrders", options, inputFile, binaryFile, outputFile, results);
+    RunEndToEndSuite<DeribitFixedPointTraits>("ProcessOrders/decimal", options, inputFile, binaryFile, outputFile,
+                                              results);
+
+    {
+        const std::filesystem::path batchDirectory = directory / "deribit_benchmark_batch";
+        std::vector<std::string> batchFiles;
+        if (false == WriteBatchInputs(options, batchDirectory, batchFiles))
+        {
+            return 1;
+        }
+
+        checksPassed &= CheckBatchPlanning(options, batchDirectory / "check");
+
+        ProcessorOptions<DeribitTraits> batch;
+        batch.m_ThreadCount = 0;
+        batch.m_OutputDirectory = (batchDirectory / "out").string();
+        RunBatchEndToEnd("ProcessFiles/batch", options, batch, batchFiles, results);
+        std::filesystem::remove_all(batchDirectory);
+    }
+
+    std::filesystem::remove(inputFile);
+    std::filesystem::remove(binaryFile);
+    std::filesystem::remove(outputFile);
+
+    Logger<DeribitTraits>::GetInstance().Shutdown();
+
+    std::printf("%-32s %14s %12s %14s %14s\n", "benchmark", "operations", "allocations", "min ns/op",
+                "median ns/op");
+    for (const BenchmarkResult& result : results)
+    {
+        std::printf("%-32s %14llu %12llu %14.2f %14.2f\n", result.m_Name.c_str(),
+                    static_cast<unsigned long long>(result.m_Operations),
+                    static_cast<unsigned long long>(result.m_Allocations), result.GetMin(), result.GetMedian());
+    }
+
+    if (false == options.m_OutputFile.empty())
+    {
+        std::ofstream output(options.m_OutputFile, std::ios::binary | std::ios::trunc);
+        output << BuildJsonReport(options, results);
+
+        if (false == output.good())
+        {
+            std::fprintf(stderr, "Failed to write results: %s\n", options.m_OutputFile.c_str());
+            return 1;
+        }
+    }
+
+    return true == checksPassed ? 0 : 1;
+}
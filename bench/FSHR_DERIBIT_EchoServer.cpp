@@ -0,0 +1,359 @@
+#include "FSHR_DERIBIT_WebSocket.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace fischer::deribit;
+
+// Local stand-in for the exchange endpoint: accepts WebSocket clients one at
+// a time and answers every text frame with {"ts":<ns>,"echo":<payload>},
+// where ts is the CLOCK_REALTIME nanosecond at which the read that completed
+// the frame returned. With --reply=deribit it answers as the exchange does
+// instead: a JSON-RPC response carrying the request's id and the order as
+// accepted, or every --reject-every=N-th request an error.
+namespace
+{
+    constexpr uint16_t DefaultPort = 9000;
+    constexpr size_t ReceiveSize = 64 * 1024;
+
+    struct ServerOptions
+    {
+        uint16_t m_Port{DefaultPort};
+        uint64_t m_Connections{0};      // 0 serves until killed
+        bool m_DeribitReplies{false};
+        uint64_t m_RejectEvery{0};      // 0 accepts every order
+    };
+
+    template<typename T>
+    bool ParseValue(std::string_view text, T& value)
+    {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return std::errc{} == error && text.data() + text.size() == end;
+    }
+
+    bool ParseOption(std::string_view argument, ServerOptions& options)
+    {
+        const std::string_view value = argument.substr(argument.find('=') + 1);
+
+        if (true == argument.starts_with("--port="))
+        {
+            return ParseValue(value, options.m_Port);
+        }
+        if (true == argument.starts_with("--connections="))
+        {
+            return ParseValue(value, options.m_Connections);
+        }
+        if (true == argument.starts_with("--reply="))
+        {
+            options.m_DeribitReplies = "deribit" == value;
+            return "deribit" == value || "echo" == value;
+        }
+        if (true == argument.starts_with("--reject-every="))
+        {
+            return ParseValue(value, options.m_RejectEvery);
+        }
+        return false;
+    }
+
+    uint64_t RealtimeNanoseconds()
+    {
+        timespec now{};
+        ::clock_gettime(CLOCK_REALTIME, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+    }
+
+    // The text of a request's member up to the next delimiter, or the
+    // contents of a string member when name ends with its opening quote
+    std::string_view FindMember(std::string_view request, std::string_view name)
+    {
+        const size_t start = request.find(name);
+        if (std::string_view::npos == start)
+        {
+            return {};
+        }
+
+        const std::string_view rest = request.substr(start + name.size());
+        return rest.substr(0, '"' == name.back() ? rest.find('"') : rest.find_first_of(",}"));
+    }
+
+    // A response shaped like the exchange's answer to private/buy and
+    // private/sell: market orders come back filled with one trade, others
+    // open, and every rejectEvery-th request is refused for lack of funds
+    void AppendDeribitReply(std::string& reply, std::string_view request, uint64_t sequence,
+                            const ServerOptions& options)
+    {
+        const uint64_t received = RealtimeNanoseconds() / 1000;
+        const std::string_view id = FindMember(request, "\"id\":");
+        const std::string_view instrument = FindMember(request, "\"instrument_name\":\"");
+        const std::string_view currency = instrument.substr(0, instrument.find('-'));
+        const std::string orderId = std::string(true == currency.empty() ? "ETH" : currency) + "-" +
+                                    std::to_string(sequence);
+        const std::string milliseconds = std::to_string(received / 1000);
+
+        reply.assign("{\"jsonrpc\":\"2.0\",\"id\":").append(true == id.empty() ? "null" : id);
+
+        if (0 < options.m_RejectEvery && 0 == sequence % options.m_RejectEvery)
+        {
+            reply.append(",\"error\":{\"message\":\"not_enough_funds\",\"data\":{\"reason\":\"insufficient margin\"},"
+                         "\"code\":10009}");
+        }
+        else
+        {
+            const bool market = std::string_view::npos != request.find("\"type\":\"market\"");
+            const std::string_view direction = std::string_view::npos != request.find("private/sell") ? "sell" : "buy";
+            const std::string_view amount = FindMember(request, "\"amount\":");
+
+            reply.append(",\"result\":{\"trades\":[");
+            if (true == market)
+            {
+                reply.append("{\"trade_seq\":").append(std::to_string(sequence)).append(",\"trade_id\":\"")
+                     .append(orderId).append("\",\"timestamp\":").append(milliseconds)
+                     .append(",\"tick_direction\":0,\"state\":\"filled\",\"order_id\":\"").append(orderId)
+                     .append("\",\"fee\":0,\"direction\":\"").append(direction).append("\"}");
+            }
+            reply.append("],\"order\":{\"web\":false,\"time_in_force\":\"good_til_cancelled\",\"replaced\":false,"
+                         "\"reduce_only\":false,\"post_only\":false,\"order_type\":\"")
+                 .append(true == market ? "market" : "limit").append("\",\"order_state\":\"")
+                 .append(true == market ? "filled" : "open").append("\",\"order_id\":\"").append(orderId)
+                 .append("\",\"last_update_timestamp\":").append(milliseconds)
+                 .append(",\"label\":\"\",\"is_liquidation\":false,\"instrument_name\":\"").append(instrument)
+                 .append("\",\"filled_amount\":").append(true == market && false == amount.empty() ? amount : "0")
+                 .append(",\"direction\":\"").append(direction).append("\",\"creation_timestamp\":").append(milliseconds)
+                 .append(",\"api\":true,\"average_price\":0,\"amount\":").append(true == amount.empty() ? "0" : amount)
+                 .append("}}");
+        }
+
+        const uint64_t sent = RealtimeNanoseconds() / 1000;
+        reply.append(",\"usIn\":").append(std::to_string(received)).append(",\"usOut\":").append(std::to_string(sent))
+             .append(",\"usDiff\":").append(std::to_string(sent - received)).append(",\"testnet\":true}");
+    }
+
+    bool SendAll(int descriptor, const char* data, size_t size)
+    {
+        while (0 < size)
+        {
+            const ssize_t sent = ::send(descriptor, data, size, MSG_NOSIGNAL);
+            if (0 > sent)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Server frames are not masked
+    void AppendFrame(std::string& out, websocket::Opcode opcode, std::string_view payload, std::string_view prefix = {},
+                     std::string_view suffix = {})
+    {
+        char header[websocket::MaxClientHeaderSize];
+        char* end = header + sizeof(header);
+        const uint64_t length = prefix.size() + payload.size() + suffix.size();
+        const char* begin = websocket::WriteHeaderBefore(end, length, opcode, false, 0);
+
+        out.append(begin, static_cast<size_t>(end - begin));
+        out.append(prefix).append(payload).append(suffix);
+    }
+
+    bool Upgrade(int descriptor, std::vector<char>& buffer, size_t& size)
+    {
+        constexpr std::string_view HeaderEnd = "\r\n\r\n";
+        size_t headerEnd = std::string_view::npos;
+
+        while (std::string_view::npos == headerEnd)
+        {
+            buffer.resize(size + ReceiveSize);
+            const ssize_t count = ::recv(descriptor, buffer.data() + size, ReceiveSize, 0);
+            if (0 >= count)
+            {
+                return false;
+            }
+            size += static_cast<size_t>(count);
+            headerEnd = std::string_view(buffer.data(), size).find(HeaderEnd);
+        }
+
+        const std::string_view request(buffer.data(), headerEnd + HeaderEnd.size());
+        const std::string_view key = websocket::FindHttpHeader(request, "Sec-WebSocket-Key");
+        if (true == key.empty())
+        {
+            const std::string_view refusal = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n";
+            SendAll(descriptor, refusal.data(), refusal.size());
+            return false;
+        }
+
+        std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n";
+        response.append("Sec-WebSocket-Accept: ").append(websocket::ComputeAcceptKey(key)).append("\r\n\r\n");
+
+        size -= request.size();
+        std::memmove(buffer.data(), buffer.data() + request.size(), size);
+        return SendAll(descriptor, response.data(), response.size());
+    }
+
+    void Serve(int descriptor, const ServerOptions& options)
+    {
+        std::vector<char> buffer;
+        size_t size = 0;
+
+        if (false == Upgrade(descriptor, buffer, size))
+        {
+            std::fprintf(stderr, "Handshake failed\n");
+            return;
+        }
+
+        uint64_t frames = 0;
+        uint64_t bytes = 0;
+        const uint64_t start = RealtimeNanoseconds();
+        bool open = true;
+        std::string out;
+        std::string reply;
+
+        for (bool first = true; true == open; first = false)
+        {
+            // Frames that arrived with the handshake are answered first
+            if (false == first || 0 == size)
+            {
+                buffer.resize(size + ReceiveSize);
+                const ssize_t count = ::recv(descriptor, buffer.data() + size, ReceiveSize, 0);
+                if (0 >= count)
+                {
+                    break;
+                }
+                size += static_cast<size_t>(count);
+            }
+
+            char timestamp[32];
+            const std::string_view prefix = [&timestamp]
+            {
+                char* end = std::to_chars(timestamp + 6, timestamp + sizeof(timestamp), RealtimeNanoseconds()).ptr;
+                std::memcpy(timestamp, "{\"ts\":", 6);
+                std::memcpy(end, ",\"echo\":", 8);
+                return std::string_view(timestamp, static_cast<size_t>(end + 8 - timestamp));
+            }();
+
+            out.clear();
+            size_t offset = 0;
+            websocket::Frame frame;
+
+            while (true == open && true == websocket::ParseFrame(buffer.data() + offset, size - offset, frame))
+            {
+                char* payload = buffer.data() + offset + frame.m_HeaderSize;
+                const size_t length = static_cast<size_t>(frame.m_PayloadLength);
+                if (true == frame.m_Masked)
+                {
+                    websocket::ApplyMask(payload, length, frame.m_MaskKey);
+                }
+
+                const std::string_view body(payload, length);
+                if (websocket::Opcode::Text == frame.m_Opcode)
+                {
+                    frames++;
+                    bytes += length;
+
+                    if (true == options.m_DeribitReplies)
+                    {
+                        AppendDeribitReply(reply, body, frames, options);
+                        AppendFrame(out, websocket::Opcode::Text, reply);
+                    }
+                    else
+                    {
+                        AppendFrame(out, websocket::Opcode::Text, body, prefix, "}");
+                    }
+                }
+                else if (websocket::Opcode::Ping == frame.m_Opcode)
+                {
+                    AppendFrame(out, websocket::Opcode::Pong, body);
+                }
+                else if (websocket::Opcode::Close == frame.m_Opcode)
+                {
+                    AppendFrame(out, websocket::Opcode::Close, body);
+                    open = false;
+                }
+
+                offset += frame.m_HeaderSize + length;
+            }
+
+            size -= offset;
+            std::memmove(buffer.data(), buffer.data() + offset, size);
+
+            if (false == SendAll(descriptor, out.data(), out.size()))
+            {
+                break;
+            }
+        }
+
+        const double seconds = static_cast<double>(RealtimeNanoseconds() - start) / 1e9;
+        std::fprintf(stderr, "Connection closed: %llu frames, %llu payload bytes, %.3f s\n",
+                     static_cast<unsigned long long>(frames), static_cast<unsigned long long>(bytes), seconds);
+    }
+}
+
+// Usage: deribit_echo_server [--port=N] [--connections=N] [--reply=echo|deribit] [--reject-every=N]
+int main(int argc, char* argv[])
+{
+    ServerOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (false == ParseOption(argv[i], options))
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    const int listener = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    const int enable = 1;
+    ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.m_Port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (0 > listener || 0 != ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) ||
+        0 != ::listen(listener, 1))
+    {
+        std::fprintf(stderr, "Failed to listen on port %u: %s\n", options.m_Port, std::strerror(errno));
+        return 1;
+    }
+
+    std::fprintf(stderr, "Listening on ws://127.0.0.1:%u/\n", options.m_Port);
+
+    for (uint64_t served = 0; 0 == options.m_Connections || served < options.m_Connections; ++served)
+    {
+        const int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (0 > client)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            std::fprintf(stderr, "Failed to accept: %s\n", std::strerror(errno));
+            break;
+        }
+
+        ::setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        Serve(client, options);
+        ::close(client);
+    }
+
+    ::close(listener);
+    return 0;
+}
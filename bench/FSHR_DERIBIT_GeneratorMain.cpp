@@ -0,0 +1,119 @@
+#include "FSHR_DERIBIT_OrderGenerator.h"
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+using namespace fischer::deribit;
+
+namespace
+{
+    constexpr size_t FlushThreshold = 1 << 20;
+
+    template<typename T>
+    bool ParseValue(std::string_view text, T& value)
+    {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return std::errc{} == error && text.data() + text.size() == end;
+    }
+
+    bool ParseOption(std::string_view argument, bench::GeneratorOptions& options, std::string& outputFile)
+    {
+        const std::string_view value = argument.substr(argument.find('=') + 1);
+
+        if (true == argument.starts_with("--rows="))
+        {
+            return ParseValue(value, options.m_Rows);
+        }
+        if (true == argument.starts_with("--seed="))
+        {
+            return ParseValue(value, options.m_Seed);
+        }
+        if (true == argument.starts_with("--sparsity="))
+        {
+            return ParseValue(value, options.m_Sparsity) && 0.0 <= options.m_Sparsity && 1.0 >= options.m_Sparsity;
+        }
+        if (true == argument.starts_with("--instruments="))
+        {
+            return ParseValue(value, options.m_InstrumentCount) && 0 < options.m_InstrumentCount;
+        }
+        if (true == argument.starts_with("--label-length="))
+        {
+            // MIN:MAX, or a single fixed length
+            const size_t separator = value.find(':');
+            if (std::string_view::npos == separator)
+            {
+                return ParseValue(value, options.m_MinLabelLength) &&
+                       ParseValue(value, options.m_MaxLabelLength);
+            }
+            return ParseValue(value.substr(0, separator), options.m_MinLabelLength) &&
+                   ParseValue(value.substr(separator + 1), options.m_MaxLabelLength) &&
+                   options.m_MinLabelLength <= options.m_MaxLabelLength;
+        }
+        if (false == argument.starts_with("--") && true == outputFile.empty())
+        {
+            outputFile = std::string(argument);
+            return true;
+        }
+        return false;
+    }
+}
+
+// Usage: deribit_order_generator [--rows=N] [--seed=S] [--sparsity=P]
+//        [--label-length=MIN:MAX] [--instruments=K] [output.csv]
+// Writes to stdout when no output file is given.
+int main(int argc, char* argv[])
+{
+    bench::GeneratorOptions options;
+    std::string outputFile;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (false == ParseOption(argv[i], options, outputFile))
+        {
+            std::fprintf(stderr, "Invalid argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    std::FILE* output = true == outputFile.empty() ? stdout : std::fopen(outputFile.c_str(), "wb");
+    if (nullptr == output)
+    {
+        std::fprintf(stderr, "Failed to open output file: %s\n", outputFile.c_str());
+        return 1;
+    }
+
+    bench::OrderGenerator generator(options);
+    std::string buffer;
+    buffer.reserve(FlushThreshold * 2);
+    generator.AppendHeader(buffer);
+
+    bool success = true;
+    for (uint64_t row = 0; row < options.m_Rows && true == success; ++row)
+    {
+        generator.AppendRow(buffer, row);
+
+        if (FlushThreshold <= buffer.size())
+        {
+            success = buffer.size() == std::fwrite(buffer.data(), 1, buffer.size(), output);
+            buffer.clear();
+        }
+    }
+
+    success = success && buffer.size() == std::fwrite(buffer.data(), 1, buffer.size(), output);
+    success = 0 == std::fflush(output) && success;
+
+    if (stdout != output)
+    {
+        success = 0 == std::fclose(output) && success;
+    }
+
+    if (false == success)
+    {
+        std::fprintf(stderr, "Failed to write output\n");
+        return 1;
+    }
+
+    return 0;
+}
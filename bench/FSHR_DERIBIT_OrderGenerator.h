@@ -0,0 +1,216 @@
+#pragma once
+
+#include "FSHR_DERIBIT_FieldTable.h"
+#include "FSHR_DERIBIT_NumberFormat.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fischer::deribit::bench
+{
+    struct GeneratorOptions
+    {
+        uint64_t m_Rows{100000};
+        uint64_t m_Seed{5275};
+        double m_Sparsity{0.3};             // chance that an optional cell is empty
+        size_t m_MinLabelLength{4};
+        size_t m_MaxLabelLength{24};
+        size_t m_InstrumentCount{64};       // distinct instrument names
+    };
+
+    // splitmix64: fixed output for a given seed on every platform, unlike the
+    // standard distributions
+    class SplitMix64
+    {
+    public:
+        explicit SplitMix64(uint64_t seed) noexcept : m_State{seed} {}
+
+        uint64_t Next() noexcept
+        {
+            uint64_t value = (m_State += 0x9E3779B97F4A7C15ULL);
+            value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+            return value ^ (value >> 31);
+        }
+
+        uint64_t Below(uint64_t bound) noexcept { return 0 == bound ? 0 : Next() % bound; }
+        double Unit() noexcept { return static_cast<double>(Next() >> 11) * 0x1.0p-53; }
+
+    private:
+        uint64_t m_State;
+    };
+
+    // Deterministic CSV order generator covering every column in FieldTable.
+    // id, direction and amount are always present so every row encodes;
+    // every other cell is left empty with probability m_Sparsity.
+    class OrderGenerator
+    {
+    public:
+        explicit OrderGenerator(const GeneratorOptions& options)
+            : m_Options{options}
+            , m_Random{options.m_Seed}
+        {
+            m_Instruments.reserve(m_Options.m_InstrumentCount);
+            for (size_t index = 0; index < std::max<size_t>(1, m_Options.m_InstrumentCount); ++index)
+            {
+                static constexpr std::array<std::string_view, 3> Currencies{"BTC", "ETH", "SOL"};
+                std::string name(Currencies[index % Currencies.size()]);
+                name.push_back('-');
+                name.append(0 == index / Currencies.size() ? std::string("PERPETUAL")
+                                                           : std::to_string(index / Currencies.size()));
+                m_Instruments.push_back(std::move(name));
+            }
+        }
+
+        void AppendHeader(std::string& out) const
+        {
+            for (size_t slot = 0; slot < FieldTable.size(); ++slot)
+            {
+                out.append(0 == slot ? "" : ",");
+                out.append(FieldTable[slot].m_Name);
+            }
+            out.push_back('\n');
+        }
+
+        void AppendRow(std::string& out, uint64_t row)
+        {
+            for (size_t slot = 0; slot < FieldTable.size(); ++slot)
+            {
+                if (0 != slot)
+                {
+                    out.push_back(',');
+                }
+
+                const FieldIndex field = FieldTable[slot].m_Index;
+                const bool required = FieldIndex::Id == field || FieldIndex::Direction == field ||
+                                      FieldIndex::Amount == field;
+
+                if (false == required && m_Random.Unit() < m_Options.m_Sparsity)
+                {
+                    continue;
+                }
+
+                AppendValue(out, FieldTable[slot], row);
+            }
+            out.push_back('\n');
+        }
+
+    private:
+        void AppendValue(std::string& out, const FieldDescriptor& field, uint64_t row)
+        {
+            switch (field.m_Index)
+            {
+            case FieldIndex::Id:
+                AppendUnsigned(out, row + 1);
+                return;
+            case FieldIndex::ValidUntil:
+                AppendUnsigned(out, 1700000000000ULL + row);
+                return;
+            case FieldIndex::InstrumentName:
+                out.append(m_Instruments[m_Random.Below(m_Instruments.size())]);
+                return;
+            case FieldIndex::Label:
+                AppendLabel(out);
+                return;
+            default:
+                break;
+            }
+
+            switch (field.m_Encoding)
+            {
+            case FieldEncoding::Number:
+                AppendPrice(out);
+                return;
+            case FieldEncoding::Boolean:
+            {
+                static constexpr std::array<std::string_view, 6> Booleans{"true", "false", "t", "f", "1", "0"};
+                out.append(Booleans[m_Random.Below(Booleans.size())]);
+                return;
+            }
+            case FieldEncoding::Enum:
+                out.append(PickEnumText(field.m_Index));
+                return;
+            default:
+                AppendUnsigned(out, m_Random.Below(1000000));
+                return;
+            }
+        }
+
+        std::string_view PickEnumText(FieldIndex field)
+        {
+            static constexpr std::array<std::string_view, 2> Directions{"buy", "sell"};
+            static constexpr std::array<std::string_view, 8> Types{
+                "limit", "market", "stop_limit", "stop_market", "take_limit", "take_market",
+                "market_limit", "trailing_stop"};
+            static constexpr std::array<std::string_view, 5> TimesInForce{
+                "good_til_cancelled", "good_til_day", "fill_or_kill", "immediate_or_cancel", "GTC"};
+            static constexpr std::array<std::string_view, 3> Triggers{"index_price", "mark_price", "last_price"};
+            static constexpr std::array<std::string_view, 2> Advanced{"usd", "implv"};
+            static constexpr std::array<std::string_view, 3> Linked{
+                "one_triggers_other", "one_cancels_other", "one_triggers_one_cancels_other"};
+            static constexpr std::array<std::string_view, 3> FillConditions{
+                "first_hit", "complete_fill", "incremental"};
+
+            switch (field)
+            {
+            case FieldIndex::Direction: return Directions[m_Random.Below(Directions.size())];
+            case FieldIndex::Type: return Types[m_Random.Below(Types.size())];
+            case FieldIndex::TimeInForce: return TimesInForce[m_Random.Below(TimesInForce.size())];
+            case FieldIndex::Trigger: return Triggers[m_Random.Below(Triggers.size())];
+            case FieldIndex::Advanced: return Advanced[m_Random.Below(Advanced.size())];
+            case FieldIndex::LinkedOrderType: return Linked[m_Random.Below(Linked.size())];
+            case FieldIndex::TriggerFillCondition: return FillConditions[m_Random.Below(FillConditions.size())];
+            default: return {};
+            }
+        }
+
+        // Prices with 0 to 4 decimals, so both integral and fractional
+        // renderings are exercised
+        void AppendPrice(std::string& out)
+        {
+            static constexpr std::array<uint64_t, 5> Scales{1, 10, 100, 1000, 10000};
+
+            const size_t decimals = m_Random.Below(Scales.size());
+            const uint64_t mantissa = 1 + m_Random.Below(100000 * Scales[decimals]);
+
+            AppendUnsigned(out, mantissa / Scales[decimals]);
+            if (0 < decimals)
+            {
+                // Adding the scale keeps the leading zeros: 7 at 3 decimals -> "1007"
+                char digits[utils::MaxUInt64Digits];
+                const size_t length = utils::FormatUInt64(digits, mantissa % Scales[decimals] + Scales[decimals]);
+                out.push_back('.');
+                out.append(digits + 1, length - 1);
+            }
+        }
+
+        void AppendLabel(std::string& out)
+        {
+            static constexpr std::string_view Alphabet = "abcdefghijklmnopqrstuvwxyz0123456789_";
+
+            const size_t span = m_Options.m_MaxLabelLength - std::min(m_Options.m_MinLabelLength,
+                                                                      m_Options.m_MaxLabelLength);
+            const size_t length = m_Options.m_MinLabelLength + m_Random.Below(span + 1);
+            for (size_t index = 0; index < length; ++index)
+            {
+                out.push_back(Alphabet[m_Random.Below(Alphabet.size())]);
+            }
+        }
+
+        static void AppendUnsigned(std::string& out, uint64_t value)
+        {
+            char digits[utils::MaxUInt64Digits];
+            out.append(digits, utils::FormatUInt64(digits, value));
+        }
+
+    private:
+        GeneratorOptions m_Options;
+        SplitMix64 m_Random;
+        std::vector<std::string> m_Instruments;
+    };
+}
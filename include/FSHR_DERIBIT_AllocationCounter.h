@@ -0,0 +1,109 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace fischer::deribit
+{
+    // Process-wide count of global operator new calls and the bytes they
+    // asked for. The counts are only kept in an executable that replaces
+    // the global allocation functions with COUNT_GLOBAL_ALLOCATIONS();
+    // elsewhere they stay zero and IsInstalled() is false.
+    class AllocationCounter
+    {
+    public:
+        struct Snapshot
+        {
+            uint64_t m_Allocations{0};
+            uint64_t m_Bytes{0};
+
+            Snapshot operator-(const Snapshot& other) const noexcept
+            {
+                return Snapshot{m_Allocations - other.m_Allocations, m_Bytes - other.m_Bytes};
+            }
+        };
+
+        static Snapshot Read() noexcept
+        {
+            return Snapshot{s_Allocations.load(std::memory_order_relaxed), s_Bytes.load(std::memory_order_relaxed)};
+        }
+
+        static bool IsInstalled() noexcept { return s_Installed; }
+        static bool Install() noexcept { return s_Installed = DeribitTraits::EnableAllocationCounters; }
+
+        static void Record(std::size_t size) noexcept
+        {
+            if constexpr (true == DeribitTraits::EnableAllocationCounters)
+            {
+                s_Allocations.fetch_add(1, std::memory_order_relaxed);
+                s_Bytes.fetch_add(size, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        static inline std::atomic<uint64_t> s_Allocations{0};
+        static inline std::atomic<uint64_t> s_Bytes{0};
+        static inline bool s_Installed{false};
+    };
+
+    // Replaces the global allocation functions with counting ones that
+    // allocate through malloc
+    inline void* CountedAllocate(std::size_t size)
+    {
+        AllocationCounter::Record(size);
+        if (void* pointer = std::malloc(0 == size ? 1 : size))
+        {
+            return pointer;
+        }
+        throw std::bad_alloc();
+    }
+
+    inline void* CountedAllocate(std::size_t size, std::align_val_t alignment)
+    {
+        AllocationCounter::Record(size);
+        const std::size_t align = static_cast<std::size_t>(alignment);
+        if (void* pointer = std::aligned_alloc(align, (0 == size ? align : (size + align - 1) / align * align)))
+        {
+            return pointer;
+        }
+        throw std::bad_alloc();
+    }
+}
+
+// Expands to the replacement allocation functions; use it once, at global
+// scope, in the executable's translation unit. Every form is replaced, so no
+// block from another allocator ever reaches the free() in operator delete.
+#define COUNT_GLOBAL_ALLOCATIONS()                                                                          \
+    void* operator new(std::size_t size) { return fischer::deribit::CountedAllocate(size); }               \
+    void* operator new[](std::size_t size) { return fischer::deribit::CountedAllocate(size); }             \
+    void* operator new(std::size_t size, std::align_val_t alignment)                                      \
+    {                                                                                                       \
+        return fischer::deribit::CountedAllocate(size, alignment);                                        \
+    }                                                                                                       \
+    void* operator new[](std::size_t size, std::align_val_t alignment)                                    \
+    {                                                                                                       \
+        return fischer::deribit::CountedAllocate(size, alignment);                                        \
+    }                                                                                                       \
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept                                  \
+    {                                                                                                       \
+        try { return fischer::deribit::CountedAllocate(size); } catch (...) { return nullptr; }          \
+    }                                                                                                       \
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept                                \
+    {                                                                                                       \
+        try { return fischer::deribit::CountedAllocate(size); } catch (...) { return nullptr; }          \
+    }                                                                                                       \
+    void operator delete(void* pointer) noexcept { std::free(pointer); }                                  \
+    void operator delete[](void* pointer) noexcept { std::free(pointer); }                                \
+    void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }                     \
+    void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }                   \
+    void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }                \
+    void operator delete[](void* pointer, std::align_val_t) noexcept { std::free(pointer); }              \
+    void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }   \
+    void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); } \
+    void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }           \
+    void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }         \
+    static const bool g_AllocationCounterInstalled = fischer::deribit::AllocationCounter::Install()
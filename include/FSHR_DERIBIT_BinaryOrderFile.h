@@ -0,0 +1,144 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_MappedFile.h"
+#include "FSHR_DERIBIT_InternTable.h"
+
+#include <bit>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Version 1 of the binary order file, little-endian throughout:
+    //
+    //   FileHeader    64 bytes at offset 0
+    //   Record        m_RecordCount records of m_RecordSize bytes at m_RecordsOffset
+    //   strings       m_StringsSize bytes at m_StringsOffset
+    //
+    // A record holds every field of an Order. Its text fields form an offset
+    // table into the record's own slice of the string section, so a record is
+    // decoded by copying numbers and offsets - there is no text to parse.
+    // Readers accept larger headers and records than they know, so later
+    // versions can append fields.
+    namespace binary
+    {
+        static_assert(std::endian::little == std::endian::native, "Binary order files are little-endian");
+
+        constexpr char Magic[8] = {'F', 'S', 'H', 'R', 'O', 'R', 'D', '\0'};
+        constexpr uint16_t FormatVersion = 1;
+        constexpr size_t TextFieldCount = 9;
+
+        // Prices and amounts are stored as the 64-bit image of the traits'
+        // AmountType: an IEEE double, or a Decimal (mantissa in the low 58
+        // bits, scale in the top 6). Files are read with matching traits.
+        enum class NumberEncoding : uint8_t
+        {
+            Double = 0,
+            Decimal = 1
+        };
+
+        struct FileHeader
+        {
+            char m_Magic[8];
+            uint16_t m_Version;
+            uint16_t m_HeaderSize;
+            uint16_t m_RecordSize;
+            uint8_t m_NumberEncoding;
+            uint8_t m_Reserved0;
+            uint64_t m_RecordCount;
+            uint64_t m_RecordsOffset;
+            uint64_t m_StringsOffset;
+            uint64_t m_StringsSize;
+            uint8_t m_Reserved[16];
+        };
+
+        struct Record
+        {
+            uint64_t m_TextOffset;          // start of this record's texts in the string section
+            int64_t m_Id;
+            uint64_t m_Amount;
+            uint64_t m_Contracts;
+            uint64_t m_Price;
+            uint64_t m_TriggerPrice;
+            uint64_t m_TriggerOffset;
+            uint64_t m_DisplayAmount;
+            int64_t m_ValidUntil;
+            uint32_t m_Presence;            // Order::m_Presence, one bit per FieldIndex
+            TextRef m_Texts[TextFieldCount];
+            uint8_t m_Direction;
+            uint8_t m_Type;
+            uint8_t m_TimeInForce;
+            uint8_t m_Trigger;
+            uint8_t m_Advanced;
+            uint8_t m_LinkedOrderType;
+            uint8_t m_TriggerFillCondition;
+            uint8_t m_Flags;
+            uint8_t m_Reserved[8];
+        };
+
+        static_assert(sizeof(FileHeader) == 64, "Header layout is part of the file format");
+        static_assert(sizeof(Record) == 128, "Record layout is part of the file format");
+        static_assert(std::is_trivially_copyable_v<Record>, "Records are copied as bytes");
+
+        template<typename Traits>
+        constexpr NumberEncoding GetNumberEncoding() noexcept
+        {
+            return std::is_same_v<typename Traits::AmountType, Decimal> ? NumberEncoding::Decimal
+                                                                        : NumberEncoding::Double;
+        }
+    }
+
+    // Reads and writes binary order files. Decoded orders point into the
+    // mapped string section, so the file must outlive them, like the
+    // parser's buffer for CSV input.
+    template<typename Traits = DeribitTraits>
+    class BinaryOrderFile
+    {
+    public:
+        using OrderType = Order<Traits>;
+        using OrderVectorType = OrderVector<Traits>;
+        using SizeType = typename Traits::SizeType;
+
+        BinaryOrderFile() = default;
+        RULE_OF_FIVE_MOVABLE(BinaryOrderFile);
+
+        // Maps the file and checks its header; throws if the file cannot be
+        // mapped, is not a binary order file, or was written for other traits
+        void Open(const std::string& filename);
+
+        // Decodes every record into a vector from resource; with fragments,
+        // directions and instrument names are interned as the CSV parser would
+        OrderVectorType ReadOrders(MessageFragments<Traits>* fragments,
+                                   std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+        SizeType GetRecordCount() const { return static_cast<SizeType>(m_Header.m_RecordCount); }
+
+        static void Write(const std::string& filename, std::span<const OrderType> orders);
+
+    protected:
+        // Order text fields in the order of Record::m_Texts
+        static constexpr TextRef OrderType::* TextFields[binary::TextFieldCount] = {
+            &OrderType::m_InstrumentName, &OrderType::m_Label, &OrderType::m_DirectionText,
+            &OrderType::m_TypeText, &OrderType::m_TimeInForceText, &OrderType::m_TriggerText,
+            &OrderType::m_AdvancedText, &OrderType::m_LinkedOrderTypeText, &OrderType::m_TriggerFillConditionText};
+
+        static void FillRecord(const OrderType& order, binary::Record& record, std::string& strings);
+        bool DecodeRecord(const binary::Record& record, OrderType& order) const noexcept;
+
+    private:
+        MappedFile m_File;
+        binary::FileHeader m_Header{};
+        const char* m_Records{nullptr};
+        const char* m_Strings{nullptr};
+    };
+}
+
+#include <FSHR_DERIBIT_BinaryOrderFile.hxx>
@@ -0,0 +1,235 @@
+#include "FSHR_DERIBIT_BinaryOrderFile.h"
+#include "FSHR_DERIBIT_Logger.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace fischer::deribit
+{
+    template<typename Traits>
+    void BinaryOrderFile<Traits>::Open(const std::string& filename)
+    {
+        if (false == m_File.Open(filename))
+        {
+            LOG_ERROR("Failed to map binary order file:", filename);
+            throw std::runtime_error("Failed to load binary order file");
+        }
+
+        const char* data = m_File.GetData();
+        const uint64_t fileSize = m_File.GetSize();
+
+        if (sizeof(binary::FileHeader) > fileSize ||
+            0 != std::memcmp(data, binary::Magic, sizeof(binary::Magic)))
+        {
+            LOG_ERROR("Not a binary order file:", filename);
+            throw std::runtime_error("Failed to load binary order file");
+        }
+
+        std::memcpy(&m_Header, data, sizeof(m_Header));
+
+        if (0 == m_Header.m_Version || binary::FormatVersion < m_Header.m_Version)
+        {
+            LOG_ERROR("Unsupported binary order file version:", m_Header.m_Version, "in", filename);
+            throw std::runtime_error("Failed to load binary order file");
+        }
+
+        if (binary::GetNumberEncoding<Traits>() != static_cast<binary::NumberEncoding>(m_Header.m_NumberEncoding))
+        {
+            LOG_ERROR("Binary order file", filename, "was written",
+                      binary::NumberEncoding::Decimal == binary::GetNumberEncoding<Traits>() ? "without" : "with",
+                      "--decimal; read it the same way");
+            throw std::runtime_error("Failed to load binary order file");
+        }
+
+        // Every section must lie inside the file
+        const uint64_t recordSize = m_Header.m_RecordSize;
+        if (sizeof(binary::FileHeader) > m_Header.m_HeaderSize || sizeof(binary::Record) > recordSize ||
+            fileSize < m_Header.m_RecordsOffset ||
+            (fileSize - m_Header.m_RecordsOffset) / recordSize < m_Header.m_RecordCount ||
+            fileSize < m_Header.m_StringsOffset || fileSize - m_Header.m_StringsOffset < m_Header.m_StringsSize)
+        {
+            LOG_ERROR("Malformed binary order file header:", filename);
+            throw std::runtime_error("Failed to load binary order file");
+        }
+
+        m_Records = data + m_Header.m_RecordsOffset;
+        m_Strings = data + m_Header.m_StringsOffset;
+
+        LOG_DEBUG("Binary order file mapped. Records:", m_Header.m_RecordCount, "Version:", m_Header.m_Version);
+    }
+
+    template<typename Traits>
+    typename BinaryOrderFile<Traits>::OrderVectorType
+    BinaryOrderFile<Traits>::ReadOrders(MessageFragments<Traits>* fragments, std::pmr::memory_resource* resource) const
+    {
+        const SizeType recordCount = GetRecordCount();
+        OrderVectorType orders(recordCount, resource);
+
+        for (SizeType index = 0; index < recordCount; ++index)
+        {
+            // Records of a later version may be longer; the known prefix is read
+            binary::Record record;
+            std::memcpy(&record, m_Records + index * m_Header.m_RecordSize, sizeof(record));
+
+            if (false == DecodeRecord(record, orders[index]))
+            {
+                LOG_ERROR("Malformed binary order record:", index);
+                throw std::runtime_error("Malformed binary order file");
+            }
+
+            if (nullptr != fragments)
+            {
+                fragments->Intern(orders[index]);
+            }
+        }
+
+        LOG_INFO("Read", recordCount, "orders from binary file");
+        return orders;
+    }
+
+    template<typename Traits>
+    bool BinaryOrderFile<Traits>::DecodeRecord(const binary::Record& record, OrderType& order) const noexcept
+    {
+        const uint64_t stringsSize = m_Header.m_StringsSize;
+        if (stringsSize < record.m_TextOffset)
+        {
+            return false;
+        }
+
+        for (const TextRef& text : record.m_Texts)
+        {
+            if (stringsSize - record.m_TextOffset < uint64_t{text.m_Offset} + text.m_Length)
+            {
+                return false;
+            }
+        }
+
+        // Enumerations index lookup tables in the builder
+        if (static_cast<uint8_t>(OrderDirection::Sell) < record.m_Direction ||
+            static_cast<uint8_t>(deribit::OrderType::TrailingStop) < record.m_Type ||
+            static_cast<uint8_t>(TimeInForce::ImmediateOrCancel) < record.m_TimeInForce ||
+            static_cast<uint8_t>(TriggerType::LastPrice) < record.m_Trigger ||
+            static_cast<uint8_t>(AdvancedType::ImpliedVolatility) < record.m_Advanced ||
+            static_cast<uint8_t>(LinkedOrderType::OneTriggersOneCancelsOther) < record.m_LinkedOrderType ||
+            static_cast<uint8_t>(TriggerFillCondition::Incremental) < record.m_TriggerFillCondition)
+        {
+            return false;
+        }
+
+        using AmountType = typename Traits::AmountType;
+        using PriceType = typename Traits::PriceType;
+
+        order.m_Source = m_Strings + record.m_TextOffset;
+        order.m_Id = static_cast<typename OrderType::OrderIdType>(record.m_Id);
+        order.m_Amount = std::bit_cast<AmountType>(record.m_Amount);
+        order.m_Contracts = std::bit_cast<AmountType>(record.m_Contracts);
+        order.m_Price = std::bit_cast<PriceType>(record.m_Price);
+        order.m_TriggerPrice = std::bit_cast<PriceType>(record.m_TriggerPrice);
+        order.m_TriggerOffset = std::bit_cast<PriceType>(record.m_TriggerOffset);
+        order.m_DisplayAmount = std::bit_cast<AmountType>(record.m_DisplayAmount);
+        order.m_ValidUntil = record.m_ValidUntil;
+        order.m_Presence = record.m_Presence & (OrderType::PresenceBit(FieldIndex::MaxFields) - 1);
+
+        for (size_t field = 0; field < binary::TextFieldCount; ++field)
+        {
+            order.*TextFields[field] = record.m_Texts[field];
+        }
+
+        order.m_Direction = static_cast<OrderDirection>(record.m_Direction);
+        order.m_Type = static_cast<deribit::OrderType>(record.m_Type);
+        order.m_TimeInForce = static_cast<TimeInForce>(record.m_TimeInForce);
+        order.m_Trigger = static_cast<TriggerType>(record.m_Trigger);
+        order.m_Advanced = static_cast<AdvancedType>(record.m_Advanced);
+        order.m_LinkedOrderType = static_cast<LinkedOrderType>(record.m_LinkedOrderType);
+        order.m_TriggerFillCondition = static_cast<TriggerFillCondition>(record.m_TriggerFillCondition);
+        order.m_Flags = static_cast<uint8_t>(record.m_Flags & ~OrderType::LongTextFlag);
+        return true;
+    }
+
+    template<typename Traits>
+    void BinaryOrderFile<Traits>::FillRecord(const OrderType& order, binary::Record& record, std::string& strings)
+    {
+        record = binary::Record{};
+        record.m_TextOffset = strings.size();
+        record.m_Id = static_cast<int64_t>(order.m_Id);
+        record.m_Amount = std::bit_cast<uint64_t>(order.m_Amount);
+        record.m_Contracts = std::bit_cast<uint64_t>(order.m_Contracts);
+        record.m_Price = std::bit_cast<uint64_t>(order.m_Price);
+        record.m_TriggerPrice = std::bit_cast<uint64_t>(order.m_TriggerPrice);
+        record.m_TriggerOffset = std::bit_cast<uint64_t>(order.m_TriggerOffset);
+        record.m_DisplayAmount = std::bit_cast<uint64_t>(order.m_DisplayAmount);
+        record.m_ValidUntil = order.m_ValidUntil;
+        record.m_Presence = order.m_Presence;
+
+        // A record's texts are addressed with 16-bit offsets, like a row's
+        if (order.GetTextLength() > MaxTextRefOffset)
+        {
+            LOG_ERROR("Order", order.m_Id, "has more than", MaxTextRefOffset, "bytes of text for a binary record");
+            throw std::runtime_error("Order text too long for the binary format");
+        }
+
+        for (size_t field = 0; field < binary::TextFieldCount; ++field)
+        {
+            const std::string_view text = order.GetText(order.*TextFields[field]);
+            record.m_Texts[field] = TextRef{static_cast<uint16_t>(strings.size() - record.m_TextOffset),
+                                            static_cast<uint16_t>(text.size())};
+            strings.append(text);
+        }
+
+        record.m_Direction = static_cast<uint8_t>(order.m_Direction);
+        record.m_Type = static_cast<uint8_t>(order.m_Type);
+        record.m_TimeInForce = static_cast<uint8_t>(order.m_TimeInForce);
+        record.m_Trigger = static_cast<uint8_t>(order.m_Trigger);
+        record.m_Advanced = static_cast<uint8_t>(order.m_Advanced);
+        record.m_LinkedOrderType = static_cast<uint8_t>(order.m_LinkedOrderType);
+        record.m_TriggerFillCondition = static_cast<uint8_t>(order.m_TriggerFillCondition);
+        record.m_Flags = static_cast<uint8_t>(order.m_Flags & ~OrderType::LongTextFlag);
+    }
+
+    template<typename Traits>
+    void BinaryOrderFile<Traits>::Write(const std::string& filename, std::span<const OrderType> orders)
+    {
+        std::vector<binary::Record> records(orders.size());
+        std::string strings;
+
+        for (SizeType index = 0; index < orders.size(); ++index)
+        {
+            FillRecord(orders[index], records[index], strings);
+        }
+
+        binary::FileHeader header{};
+        std::memcpy(header.m_Magic, binary::Magic, sizeof(header.m_Magic));
+        header.m_Version = binary::FormatVersion;
+        header.m_HeaderSize = sizeof(binary::FileHeader);
+        header.m_RecordSize = sizeof(binary::Record);
+        header.m_NumberEncoding = static_cast<uint8_t>(binary::GetNumberEncoding<Traits>());
+        header.m_RecordCount = records.size();
+        header.m_RecordsOffset = sizeof(binary::FileHeader);
+        header.m_StringsOffset = header.m_RecordsOffset + records.size() * sizeof(binary::Record);
+        header.m_StringsSize = strings.size();
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (false == file.is_open())
+        {
+            LOG_ERROR("Failed to open binary order file:", filename);
+            throw std::runtime_error("Failed to open binary order file");
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()),
+                   static_cast<std::streamsize>(records.size() * sizeof(binary::Record)));
+        file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+        if (false == file.good())
+        {
+            LOG_ERROR("Failed to write binary order file:", filename);
+            throw std::runtime_error("Failed to write binary order file");
+        }
+
+        LOG_INFO("Wrote", records.size(), "orders to binary file:", filename);
+    }
+
+    template class BinaryOrderFile<DeribitTraits>;
+    template class BinaryOrderFile<DeribitFixedPointTraits>;
+}
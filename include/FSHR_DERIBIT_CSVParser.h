@@ -4,11 +4,21 @@
 #include "FSHR_DERIBIT_Enums.h"
 #include "FSHR_DERIBIT_ProtocolTraits.h"
 #include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_MappedFile.h"
+#include "FSHR_DERIBIT_StructuralScanner.h"
+#include "FSHR_DERIBIT_LatencyHistogram.h"
+#include "FSHR_DERIBIT_InternTable.h"
+#include "FSHR_DERIBIT_PageBuffer.h"
 
+#include <deque>
 #include <string>
 #include <vector>
 #include <string_view>
 #include <memory>
+#include <memory_resource>
+#include <array>
+#include <limits>
+#include <utility>
 
 namespace fischer::deribit
 {
@@ -17,31 +27,81 @@ namespace fischer::deribit
     {
     public:
         using OrderType = Order<Traits>;
+        using OrderVectorType = OrderVector<Traits>;
         using SizeType = typename Traits::SizeType;
+        using FieldBoundaries = std::array<const char*, Traits::MaxFieldCount>;
+        using HistogramType = LatencyHistogram<Traits>;
+
+        // Specialized routine that parses one trimmed, non-empty cell of a
+        // known column into the order
+        using ColumnParser = void (*)(OrderType& order, const char* value, SizeType length) noexcept;
 
         CsvParser();
         RULE_OF_FIVE_MOVABLE(CsvParser);
 
         bool LoadFile(const std::string& filename);
-        std::vector<OrderType> ParseOrders();
 
-        bool IsFileLoaded() const { return nullptr != m_FileBuffer; }
+        // Parses the whole file into a vector from resource, reserved for
+        // every line of the data section
+        OrderVectorType ParseOrders(HistogramType* latency = nullptr,
+                                    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        // Building blocks for parsing a loaded file in several ranges: the
+        // header is parsed once, then any newline-aligned range of the data
+        // section can be parsed by a parser that adopted the same header.
+        // When a histogram is given, ParseLines records each row's parse time
+        // in TscClock ticks.
+        bool ParseHeader();
+        void ParseHeaders(const char* start, const char* end);
+        const char* ParseLines(const char* begin, const char* end, OrderVectorType& orders,
+                               SizeType maxOrders = std::numeric_limits<SizeType>::max(),
+                               HistogramType* latency = nullptr);
+        // Drops the input before position, and the out-of-line texts of rows
+        // there, once no order parsed from them is in use
+        void ReleaseConsumed(const char* position);
+
+        // Lines in [begin, end), counting an unterminated last one: no range
+        // holds more rows
+        static SizeType CountLines(const char* begin, const char* end) noexcept;
+
+        void SetMemoryMapping(bool enable) { m_UseMemoryMapping = enable; }
+        bool IsMemoryMapped() const { return m_MappedFile.IsOpen(); }
+        bool IsFileLoaded() const { return nullptr != m_Data; }
         SizeType GetFileSize() const { return m_FileSize; }
         ParserState GetState() const { return m_State; }
+        std::string_view GetHeaderLine() const { return m_HeaderLine; }
+        const char* GetDataBegin() const { return m_DataBegin; }
+        const char* GetDataEnd() const { return m_Data + m_FileSize; }
+
+        // Interns every row's direction and instrument name into fragments;
+        // nullptr (the default) leaves the fragment IDs at 0
+        void SetFragments(MessageFragments<Traits>* fragments) { m_Fragments = fragments; }
+        MessageFragments<Traits>* GetFragments() const { return m_Fragments; }
 
     protected:
-        void ParseHeaders(const char* start, const char* end);
-        bool ParseDataLine(const char* start, const char* end, OrderType& order);
-        void AssignFieldValue(OrderType& order, std::string_view fieldName,
-                              const char* value, SizeType length);
+        bool ReadFile(const std::string& filename);
+        const char* SplitLine(StructuralScanner<Traits>& scanner, FieldBoundaries& fieldEnds,
+                              SizeType& fieldCount) const noexcept;
+        bool ParseDataLine(const char* start, const FieldBoundaries& fieldEnds,
+                           SizeType fieldCount, OrderType& order);
+        template<FieldIndex Field>
+        static void ParseColumn(OrderType& order, const char* value, SizeType length) noexcept;
+        static ColumnParser GetColumnParser(FieldIndex field) noexcept;
         FieldIndex GetFieldIndex(std::string_view fieldName) const noexcept;
 
     private:
-        std::unique_ptr<char[]> m_FileBuffer;
+        PageBuffer m_FileBuffer;
+        MappedFile m_MappedFile;
+        const char* m_Data;
+        const char* m_DataBegin;
         SizeType m_FileSize;
+        bool m_UseMemoryMapping;
         ParserState m_State;
+        std::string_view m_HeaderLine;
         std::vector<std::string_view> m_Headers;
-        std::array<FieldIndex, Traits::MaxFieldCount> m_FieldMapping;
+        std::array<ColumnParser, Traits::MaxFieldCount> m_ColumnPlan;
+        MessageFragments<Traits>* m_Fragments;
+        std::deque<LongRowTexts<Traits>> m_LongRows;     // stable addresses; orders point into it
     };
 } 
 
@@ -1,7 +1,9 @@
 #include "FSHR_DERIBIT_CSVParser.h"
 #include "FSHR_DERIBIT_Logger.h"
 #include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_FieldTable.h"
 #include "FSHR_DERIBIT_Utils.h"
+#include "FSHR_DERIBIT_TscClock.h"
 
 #include <fstream>
 #include <cstring>
@@ -12,19 +14,42 @@ namespace fischer::deribit
 {
     template<typename Traits>
     CsvParser<Traits>::CsvParser()
-        : m_FileBuffer{nullptr}
+        : m_Data{nullptr}
+        , m_DataBegin{nullptr}
         , m_FileSize{0}
+        , m_UseMemoryMapping{Traits::EnableMemoryMapping}
         , m_State{ParserState::NotLoaded}
+        , m_Fragments{nullptr}
     {
         m_Headers.reserve(Traits::MaxFieldCount);
-        m_FieldMapping.fill(FieldIndex::None);
+        m_ColumnPlan.fill(nullptr);
     }
 
     template<typename Traits>
     bool CsvParser<Traits>::LoadFile(const std::string& filename)
     {
         m_State = ParserState::Loading;
+        m_FileBuffer.Reset();
+        m_MappedFile.Close();
+        m_Data = nullptr;
+        m_DataBegin = nullptr;
+        m_FileSize = 0;
 
+        if (true == m_UseMemoryMapping && true == m_MappedFile.Open(filename))
+        {
+            m_Data = m_MappedFile.GetData();
+            m_FileSize = static_cast<SizeType>(m_MappedFile.GetSize());
+            m_State = ParserState::Loaded;
+            LOG_DEBUG("CSV file mapped successfully. Size:", m_FileSize, "bytes");
+            return true;
+        }
+
+        return ReadFile(filename);
+    }
+
+    template<typename Traits>
+    bool CsvParser<Traits>::ReadFile(const std::string& filename)
+    {
         std::ifstream file(filename, std::ios::binary | std::ios::ate);
         if (false == file.is_open())
         {
@@ -36,9 +61,8 @@ namespace fischer::deribit
         m_FileSize = static_cast<SizeType>(file.tellg());
         file.seekg(0);
 
-        m_FileBuffer = std::make_unique<char[]>(m_FileSize + 1);
-        file.read(m_FileBuffer.get(), static_cast<std::streamsize>(m_FileSize));
-        m_FileBuffer[m_FileSize] = NullTerminator;
+        m_FileBuffer = PageBuffer(m_FileSize);
+        file.read(m_FileBuffer.Get(), static_cast<std::streamsize>(m_FileSize));
 
         if (false == file.good())
         {
@@ -47,13 +71,15 @@ namespace fischer::deribit
             return false;
         }
 
+        m_Data = m_FileBuffer.Get();
         m_State = ParserState::Loaded;
         LOG_DEBUG("CSV file loaded successfully. Size:", m_FileSize, "bytes");
         return true;
     }
 
     template<typename Traits>
-    std::vector<typename CsvParser<Traits>::OrderType> CsvParser<Traits>::ParseOrders()
+    typename CsvParser<Traits>::OrderVectorType
+    CsvParser<Traits>::ParseOrders(HistogramType* latency, std::pmr::memory_resource* resource)
     {
         if (ParserState::Loaded != m_State)
         {
@@ -63,63 +89,126 @@ namespace fischer::deribit
 
         m_State = ParserState::Parsing;
 
-        std::vector<OrderType> orders;
-        orders.reserve(Traits::MaxOrderCount);
+        OrderVectorType orders(resource);
+
+        if (false == ParseHeader())
+        {
+            return orders;
+        }
+
+        // One allocation for the whole file, never regrown
+        orders.reserve(true == Traits::EnableVectorReserve ? CountLines(m_DataBegin, GetDataEnd())
+                                                           : Traits::MaxOrderCount);
+
+        ParseLines(m_DataBegin, GetDataEnd(), orders, std::numeric_limits<SizeType>::max(), latency);
+
+        m_State = ParserState::Complete;
+        LOG_INFO("Parsed", orders.size(), "orders from CSV");
+        return orders;
+    }
 
-        const char* current = m_FileBuffer.get();
-        const char* end = m_FileBuffer.get() + m_FileSize;
+    template<typename Traits>
+    bool CsvParser<Traits>::ParseHeader()
+    {
+        const char* current = m_Data;
+        const char* end = GetDataEnd();
 
-        // Parse header line
-        const char* lineEnd = std::strchr(current, LineDelimiter);
+        // The buffer is not NUL-terminated, so every search is bounded by the
+        // end of the buffer
+        const char* lineEnd = (nullptr == current) ? nullptr : static_cast<const char*>(
+            std::memchr(current, LineDelimiter, static_cast<SizeType>(end - current)));
         if (nullptr == lineEnd)
         {
             LOG_ERROR("No header line found in CSV");
             m_State = ParserState::Error;
-            return orders;
+            return false;
         }
 
+        m_HeaderLine = std::string_view(current, static_cast<SizeType>(lineEnd - current));
         ParseHeaders(current, lineEnd);
-        current = lineEnd + 1;
+        m_DataBegin = lineEnd + 1;
+        return true;
+    }
 
-        // Parse data lines
-        while (current < end)
+    template<typename Traits>
+    const char* CsvParser<Traits>::ParseLines(const char* begin, const char* end,
+                                              OrderVectorType& orders, SizeType maxOrders,
+                                              HistogramType* latency)
+    {
+        // Delimiters come from the block-wise structural scanner instead of
+        // one library search per field
+        StructuralScanner<Traits> scanner(begin, end);
+        FieldBoundaries fieldEnds;
+        const char* current = begin;
+        SizeType parsedCount = 0;
+
+        while (current < end && parsedCount < maxOrders)
         {
-            lineEnd = std::strchr(current, LineDelimiter);
-            if (nullptr == lineEnd)
-            {
-                lineEnd = end;
-            }
+            const uint64_t rowStart = (nullptr != latency) ? TscClock::Now() : 0;
+            SizeType fieldCount = 0;
+            const char* lineEnd = SplitLine(scanner, fieldEnds, fieldCount);
 
             if (lineEnd > current)
             {
                 OrderType order;
-                if (true == ParseDataLine(current, lineEnd, order))
+                if (true == ParseDataLine(current, fieldEnds, fieldCount, order))
                 {
                     orders.push_back(std::move(order));
+                    parsedCount++;
+
+                    if (nullptr != latency)
+                    {
+                        latency->Record(TscClock::Now() - rowStart);
+                    }
                 }
             }
 
             current = lineEnd + 1;
         }
 
-        m_State = ParserState::Complete;
-        LOG_INFO("Parsed", orders.size(), "orders from CSV");
-        return orders;
+        return std::min(current, end);
+    }
+
+    template<typename Traits>
+    void CsvParser<Traits>::ReleaseConsumed(const char* position)
+    {
+        while (false == m_LongRows.empty() && m_LongRows.front().m_Row < position)
+        {
+            m_LongRows.pop_front();
+        }
+
+        if (true == m_MappedFile.IsOpen())
+        {
+            m_MappedFile.ReleaseBefore(static_cast<size_t>(position - m_Data));
+        }
+    }
+
+    template<typename Traits>
+    typename CsvParser<Traits>::SizeType CsvParser<Traits>::CountLines(const char* begin, const char* end) noexcept
+    {
+        if (begin >= end)
+        {
+            return 0;
+        }
+
+        const SizeType newlines = static_cast<SizeType>(std::count(begin, end, LineDelimiter));
+        return newlines + (LineDelimiter != end[-1] ? 1 : 0);
     }
 
     template<typename Traits>
     void CsvParser<Traits>::ParseHeaders(const char* start, const char* end)
     {
         m_Headers.clear();
-        m_FieldMapping.fill(FieldIndex::None);
+        m_ColumnPlan.fill(nullptr);
 
         const char* current = start;
         size_t columnIndex = 0;
 
         while (current < end && columnIndex < Traits::MaxFieldCount)
         {
-            const char* comma = std::strchr(current, FieldDelimiter);
-            if (nullptr == comma || comma > end)
+            const char* comma = static_cast<const char*>(
+                std::memchr(current, FieldDelimiter, static_cast<SizeType>(end - current)));
+            if (nullptr == comma)
             {
                 comma = end;
             }
@@ -127,8 +216,9 @@ namespace fischer::deribit
             std::string_view header(current, static_cast<SizeType>(comma - current));
             m_Headers.emplace_back(header);
 
-            // Map column index to field type for O(1) lookup during parsing
-            m_FieldMapping[columnIndex] = GetFieldIndex(header);
+            // The header is compiled once into one parse routine per column;
+            // unknown columns get none
+            m_ColumnPlan[columnIndex] = GetColumnParser(GetFieldIndex(header));
 
             current = comma + 1;
             columnIndex++;
@@ -138,214 +228,154 @@ namespace fischer::deribit
     }
 
     template<typename Traits>
-    bool CsvParser<Traits>::ParseDataLine(const char* start, const char* end, OrderType& order)
+    const char* CsvParser<Traits>::SplitLine(StructuralScanner<Traits>& scanner, FieldBoundaries& fieldEnds,
+                                             SizeType& fieldCount) const noexcept
     {
-        const char* current = start;
-        SizeType columnIndex = 0;
+        const SizeType columnCount = static_cast<SizeType>(m_Headers.size());
+        const char* delimiter = scanner.Next();
 
-        while (current < end && columnIndex < m_Headers.size())
+        while (true)
         {
-            const char* comma = std::strchr(current, FieldDelimiter);
-            if (nullptr == comma || comma > end)
+            if (fieldCount < columnCount)
             {
-                comma = end;
+                fieldEnds[fieldCount++] = delimiter;
             }
 
-            SizeType length = static_cast<SizeType>(comma - current);
-
-            // Trim trailing whitespace
-            while (0 < length &&
-                   (Space == current[length - 1] || CarriageReturn == current[length - 1]))
+            if (true == scanner.IsLineEnd(delimiter))
             {
-                length--;
+                return delimiter;
             }
 
-            // Trim leading whitespace
-            while (0 < length && Space == *current)
+            // Columns beyond the header are ignored
+            if (fieldCount == columnCount)
             {
-                current++;
-                length--;
-            }
-
-            // Use pre-computed field index for O(1) dispatch
-            if (0 < length && columnIndex < Traits::MaxFieldCount)
-            {
-                const FieldIndex fieldIdx = m_FieldMapping[columnIndex];
-                if (FieldIndex::None != fieldIdx)
-                {
-                    AssignFieldValue(order, m_Headers[columnIndex], current, length);
-                }
+                return scanner.SkipLine();
             }
 
-            current = comma + 1;
-            columnIndex++;
+            delimiter = scanner.Next();
         }
-
-        return true;
     }
 
     template<typename Traits>
-    void CsvParser<Traits>::AssignFieldValue(OrderType& order, std::string_view fieldName,
-                                             const char* value, SizeType length)
+    bool CsvParser<Traits>::ParseDataLine(const char* start, const FieldBoundaries& fieldEnds,
+                                          SizeType fieldCount, OrderType& order)
     {
-        const FieldIndex fieldIdx = GetFieldIndex(fieldName);
-
-        switch (fieldIdx)
+        // Text fields are stored as 16-bit offsets from the row start; a
+        // longer row keeps its texts out of line instead
+        order.m_Source = start;
+        if (0 < fieldCount && static_cast<SizeType>(fieldEnds[fieldCount - 1] - start) > MaxTextRefOffset) [[unlikely]]
         {
-        case FieldIndex::Id:
-            std::from_chars(value, value + length, order.m_Id);
-            break;
-
-        case FieldIndex::Direction:
-            order.m_Direction.assign(value, length);
-            break;
-
-        case FieldIndex::Amount:
-            order.m_Amount = std::strtod(value, nullptr);
-            break;
-
-        case FieldIndex::Contracts:
-            order.m_Contracts = std::strtod(value, nullptr);
-            break;
-
-        case FieldIndex::InstrumentName:
-            order.m_InstrumentName.assign(value, length);
-            break;
-
-        case FieldIndex::Label:
-            order.m_Label.assign(value, length);
-            break;
-
-        case FieldIndex::Type:
-            order.m_Type.assign(value, length);
-            break;
-
-        case FieldIndex::Price:
-            order.m_Price = std::strtod(value, nullptr);
-            break;
-
-        case FieldIndex::TimeInForce:
-            order.m_TimeInForce = std::string(value, length);
-            break;
-
-        case FieldIndex::PostOnly:
-            order.m_PostOnly = utils::ParseBool(value[0]);
-            break;
-
-        case FieldIndex::RejectPostOnly:
-            order.m_RejectPostOnly = utils::ParseBool(value[0]);
-            break;
+            LongRowTexts<Traits>& texts = m_LongRows.emplace_back();
+            texts.m_Row = start;
+            order.SetLongTexts(&texts);
+        }
+        const char* current = start;
 
-        case FieldIndex::ReduceOnly:
-            order.m_ReduceOnly = utils::ParseBool(value[0]);
-            break;
+        for (SizeType columnIndex = 0; columnIndex < fieldCount; ++columnIndex)
+        {
+            const char* fieldEnd = fieldEnds[columnIndex];
+            const ColumnParser parseColumn = m_ColumnPlan[columnIndex];
 
-        case FieldIndex::TriggerPrice:
-            order.m_TriggerPrice = std::strtod(value, nullptr);
-            break;
+            // Unknown columns are skipped without trimming or dispatch
+            if (nullptr != parseColumn)
+            {
+                SizeType length = static_cast<SizeType>(fieldEnd - current);
 
-        case FieldIndex::TriggerOffset:
-            order.m_TriggerOffset = std::strtod(value, nullptr);
-            break;
+                // Trim trailing whitespace
+                while (0 < length &&
+                       (Space == current[length - 1] || CarriageReturn == current[length - 1]))
+                {
+                    length--;
+                }
 
-        case FieldIndex::Trigger:
-            order.m_Trigger = std::string(value, length);
-            break;
+                // Trim leading whitespace
+                while (0 < length && Space == *current)
+                {
+                    current++;
+                    length--;
+                }
 
-        case FieldIndex::DisplayAmount:
-            order.m_DisplayAmount = std::strtod(value, nullptr);
-            break;
+                if (0 < length)
+                {
+                    parseColumn(order, current, length);
+                }
+            }
 
-        case FieldIndex::Advanced:
-            order.m_Advanced = std::string(value, length);
-            break;
+            current = fieldEnd + 1;
+        }
 
-        case FieldIndex::Mmp:
-            order.m_Mmp = utils::ParseBool(value[0]);
-            break;
+        if (nullptr != m_Fragments)
+        {
+            m_Fragments->Intern(order);
+        }
 
-        case FieldIndex::ValidUntil:
-            {
-                int64_t validUntil = 0;
-                std::from_chars(value, value + length, validUntil);
-                order.m_ValidUntil = validUntil;
-            }
-            break;
+        return true;
+    }
 
-        case FieldIndex::LinkedOrderType:
-            order.m_LinkedOrderType = std::string(value, length);
-            break;
+    template<typename Traits>
+    template<FieldIndex Field>
+    void CsvParser<Traits>::ParseColumn(OrderType& order, const char* value, SizeType length) noexcept
+    {
+        constexpr FieldEncoding encoding = GetFieldDescriptor(Field).m_Encoding;
 
-        case FieldIndex::TriggerFillCondition:
-            order.m_TriggerFillCondition = std::string(value, length);
-            break;
+        if constexpr (FieldEncoding::Integer == encoding)
+        {
+            std::from_chars(value, value + length, order.template GetValue<Field>());
+        }
+        else if constexpr (FieldEncoding::Number == encoding)
+        {
+            utils::ParseNumber(value, value + length, order.template GetValue<Field>());
+        }
+        else if constexpr (FieldEncoding::Boolean == encoding)
+        {
+            order.SetFlag(Field, utils::ParseBool(value[0]));
+        }
+        else
+        {
+            order.template GetValue<Field>() = order.MakeTextRef(value, length);
+        }
 
-        case FieldIndex::None:
-        case FieldIndex::MaxFields:
-            // Unknown field - ignore
-            break;
+        if constexpr (FieldEncoding::Enum == encoding)
+        {
+            const std::string_view text(value, length);
+
+            if constexpr (FieldIndex::Direction == Field) order.m_Direction = utils::StringToOrderDirection(text);
+            else if constexpr (FieldIndex::Type == Field) order.m_Type = utils::StringToOrderType(text);
+            else if constexpr (FieldIndex::TimeInForce == Field) order.m_TimeInForce = utils::StringToTimeInForce(text);
+            else if constexpr (FieldIndex::Trigger == Field) order.m_Trigger = utils::StringToTriggerType(text);
+            else if constexpr (FieldIndex::Advanced == Field) order.m_Advanced = utils::StringToAdvancedType(text);
+            else if constexpr (FieldIndex::LinkedOrderType == Field) order.m_LinkedOrderType = utils::StringToLinkedOrderType(text);
+            else if constexpr (FieldIndex::TriggerFillCondition == Field) order.m_TriggerFillCondition = utils::StringToTriggerFillCondition(text);
+            else static_assert(FieldIndex::None == Field, "Enum field has no parsed member");
         }
+
+        order.MarkPresent(Field);
     }
 
     template<typename Traits>
-    FieldIndex CsvParser<Traits>::GetFieldIndex(std::string_view fieldName) const noexcept
+    typename CsvParser<Traits>::ColumnParser CsvParser<Traits>::GetColumnParser(FieldIndex field) noexcept
     {
-        if (fieldName.empty()) return FieldIndex::None;
-
-        const char first = fieldName[0];
-        const size_t len = fieldName.length();
+        // One instantiation of ParseColumn per FieldIndex, indexed by its value
+        static constexpr auto Parsers = []<size_t... Fields>(std::index_sequence<Fields...>)
+        {
+            return std::array<ColumnParser, sizeof...(Fields)>{&ParseColumn<static_cast<FieldIndex>(Fields)>...};
+        }(std::make_index_sequence<static_cast<size_t>(FieldIndex::MaxFields)>{});
 
-        // Lookup using first character and length to minimize comparisons
-        switch (first)
+        if (FieldIndex::None == field || FieldIndex::MaxFields == field)
         {
-        case 'a':
-            if (6 == len && "amount" == fieldName) return FieldIndex::Amount;
-            if (8 == len && "advanced" == fieldName) return FieldIndex::Advanced;
-            break;
-        case 'c':
-            if (9 == len && "contracts" == fieldName) return FieldIndex::Contracts;
-            break;
-        case 'd':
-            if (9 == len && "direction" == fieldName) return FieldIndex::Direction;
-            if (14 == len && "display_amount" == fieldName) return FieldIndex::DisplayAmount;
-            break;
-        case 'i':
-            if (2 == len && "id" == fieldName) return FieldIndex::Id;
-            if (15 == len && "instrument_name" == fieldName) return FieldIndex::InstrumentName;
-            break;
-        case 'l':
-            if (5 == len && "label" == fieldName) return FieldIndex::Label;
-            if (17 == len && "linked_order_type" == fieldName) return FieldIndex::LinkedOrderType;
-            break;
-        case 'm':
-            if (3 == len && "mmp" == fieldName) return FieldIndex::Mmp;
-            break;
-        case 'p':
-            if (5 == len && "price" == fieldName) return FieldIndex::Price;
-            if (9 == len && "post_only" == fieldName) return FieldIndex::PostOnly;
-            break;
-        case 'r':
-            if (11 == len && "reduce_only" == fieldName) return FieldIndex::ReduceOnly;
-            if (16 == len && "reject_post_only" == fieldName) return FieldIndex::RejectPostOnly;
-            break;
-        case 't':
-            if (4 == len && "type" == fieldName) return FieldIndex::Type;
-            if (7 == len && "trigger" == fieldName) return FieldIndex::Trigger;
-            if (13 == len)
-            {
-                if ("time_in_force" == fieldName) return FieldIndex::TimeInForce;
-                if ("trigger_price" == fieldName) return FieldIndex::TriggerPrice;
-            }
-            if (14 == len && "trigger_offset" == fieldName) return FieldIndex::TriggerOffset;
-            if (23 == len && "trigger_fill_condition" == fieldName) return FieldIndex::TriggerFillCondition;
-            break;
-        case 'v':
-            if (11 == len && "valid_until" == fieldName) return FieldIndex::ValidUntil;
-            break;
+            return nullptr;
         }
 
-        return FieldIndex::None;
+        return Parsers[static_cast<size_t>(field)];
+    }
+
+    template<typename Traits>
+    FieldIndex CsvParser<Traits>::GetFieldIndex(std::string_view fieldName) const noexcept
+    {
+        // Header names come from the same table that drives JsonBuilder
+        return LookupFieldIndex(fieldName);
     }
 
     template class CsvParser<DeribitTraits>;
+    template class CsvParser<DeribitFixedPointTraits>;
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ namespace fischer::deribit
     constexpr std::string_view JsonPrefix = R"({"id":)";
     constexpr std::string_view JsonRpcField = R"(,"jsonrpc":"2.0","method":"private/)";
     constexpr std::string_view ParamsPrefix = R"(","params":{)";
+    constexpr std::string_view InstrumentFragmentPrefix = R"(,"instrument_name":")";
     constexpr std::string_view JsonSuffix = "}}";
     constexpr std::string_view NewLine = "\n";
     constexpr std::string_view MethodBuy = "buy";
@@ -32,6 +33,7 @@ namespace fischer::deribit
     constexpr char CarriageReturn = '\r';
     constexpr char Space = ' ';
     constexpr char NullTerminator = '\0';
+    constexpr size_t FirstDataLine = 2;     // line 1 is the header
 
     // Field Names
     constexpr std::string_view FieldId = "id";
@@ -42,29 +44,38 @@ namespace fischer::deribit
     constexpr std::string_view FieldLabel = "label";
     constexpr std::string_view FieldType = "type";
     constexpr std::string_view FieldPrice = "price";
-    constexpr std::string_view TimeInForce = "time_in_force";
-    constexpr std::string_view PostOnly = "post_only";
-    constexpr std::string_view RejectPostOnly = "reject_post_only";
-    constexpr std::string_view ReduceOnly = "reduce_only";
-    constexpr std::string_view TriggerPrice = "trigger_price";
-    constexpr std::string_view TriggerOffset = "trigger_offset";
-    constexpr std::string_view Trigger = "trigger";
-    constexpr std::string_view DisplayAmount = "display_amount";
-    constexpr std::string_view Advanced = "advanced";
-    constexpr std::string_view Mmp = "mmp";
-    constexpr std::string_view ValidUntil = "valid_until";
-    constexpr std::string_view LinkedOrderType = "linked_order_type";
-    constexpr std::string_view TriggerFillCondition = "trigger_fill_condition";
+    constexpr std::string_view FieldTimeInForce = "time_in_force";
+    constexpr std::string_view FieldPostOnly = "post_only";
+    constexpr std::string_view FieldRejectPostOnly = "reject_post_only";
+    constexpr std::string_view FieldReduceOnly = "reduce_only";
+    constexpr std::string_view FieldTriggerPrice = "trigger_price";
+    constexpr std::string_view FieldTriggerOffset = "trigger_offset";
+    constexpr std::string_view FieldTrigger = "trigger";
+    constexpr std::string_view FieldDisplayAmount = "display_amount";
+    constexpr std::string_view FieldAdvanced = "advanced";
+    constexpr std::string_view FieldMmp = "mmp";
+    constexpr std::string_view FieldValidUntil = "valid_until";
+    constexpr std::string_view FieldLinkedOrderType = "linked_order_type";
+    constexpr std::string_view FieldTriggerFillCondition = "trigger_fill_condition";
 
 
     // File I/O
     constexpr std::string_view DefaultInputFile = "deribit_orders.txt";
     constexpr std::string_view DefaultOutputFile = "output.txt";
     constexpr std::string_view DefaultLogFile = "deribit_processor.log";
+    constexpr std::string_view StandardStreamName = "-";    // stdin or stdout in daemon mode
+    constexpr std::string_view DefaultRejectsFile = "rejects.csv";
+    constexpr std::string_view RejectsHeader = "line,reason,row\n";
+    constexpr std::string_view CacheFileSuffix = ".cache";            // incremental mode sidecars of the output
+    constexpr std::string_view CheckpointFileSuffix = ".checkpoint";
+    constexpr std::string_view PartialFileSuffix = ".tmp";
+    constexpr std::string_view DefaultBatchOutputDirectory = ".";
+    constexpr std::string_view BatchOutputExtension = ".json";     // replaces the input's extension in batch mode
 
     // Performance and Metrics
     constexpr double MicrosecondsToMilliseconds = 1000.0;
     constexpr double MicrosecondsToSeconds = 1000000.0;
+    constexpr double BytesPerMegabyte = 1024.0 * 1024.0;
     constexpr int64_t InitialMessageId = 5275;
 
     // Logger
@@ -0,0 +1,183 @@
+#pragma once
+
+#include "FSHR_DERIBIT_NumberFormat.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <charconv>
+#include <cstring>
+
+namespace fischer::deribit
+{
+    // Exact decimal value m_Mantissa * 10^-m_Scale, packed into 8 bytes so a
+    // fixed-point Order stays the same size as a floating-point one. The scale
+    // is kept per value, so "1.50" is emitted as "1.50" and not re-rounded.
+    struct Decimal
+    {
+        int64_t m_Mantissa : 58;
+        uint64_t m_Scale : 6;
+
+        constexpr Decimal() noexcept
+            : m_Mantissa{0}
+            , m_Scale{0}
+        {
+        }
+    };
+
+    static_assert(sizeof(Decimal) == sizeof(int64_t), "Decimal must pack into one 64-bit word");
+
+    namespace utils
+    {
+        constexpr int64_t MaxDecimalMantissa = (int64_t{1} << 57) - 1;
+        constexpr uint64_t MaxDecimalScale = 63;
+        constexpr size_t MaxDecimalStringLength = 3 + MaxDecimalScale;     // "-0." and the fraction
+
+        // Parses [+-]digits[.digits][(e|E)[+-]digits] without touching floating
+        // point. Returns false (leaving value zero) on malformed or out-of-range
+        // input; trailing bytes after a valid number are ignored, like strtod.
+        inline bool ParseDecimal(const char* first, const char* last, Decimal& value) noexcept
+        {
+            value = Decimal{};
+
+            bool negative = false;
+            if (first < last && ('+' == *first || '-' == *first))
+            {
+                negative = '-' == *first;
+                ++first;
+            }
+
+            int64_t mantissa = 0;
+            int scale = 0;
+            bool seenDigit = false;
+            bool seenPoint = false;
+
+            for (; first < last; ++first)
+            {
+                const char c = *first;
+
+                if ('.' == c && false == seenPoint)
+                {
+                    seenPoint = true;
+                    continue;
+                }
+
+                if ('0' > c || '9' < c)
+                {
+                    break;
+                }
+
+                mantissa = mantissa * 10 + (c - '0');
+                if (MaxDecimalMantissa < mantissa)
+                {
+                    return false;
+                }
+
+                scale += seenPoint ? 1 : 0;
+                seenDigit = true;
+            }
+
+            if (false == seenDigit)
+            {
+                return false;
+            }
+
+            if (first < last && ('e' == *first || 'E' == *first))
+            {
+                int exponent = 0;
+                const char* exponentFirst = first + 1;
+                if (exponentFirst < last && '+' == *exponentFirst)
+                {
+                    ++exponentFirst;
+                }
+
+                const auto [end, error] = std::from_chars(exponentFirst, last, exponent);
+                if (std::errc{} == error && end != exponentFirst)
+                {
+                    scale -= exponent;
+                }
+            }
+
+            // A negative scale is folded into the mantissa ("12e3" -> 12000)
+            for (; 0 > scale; ++scale)
+            {
+                mantissa *= 10;
+                if (MaxDecimalMantissa < mantissa)
+                {
+                    return false;
+                }
+            }
+
+            if (static_cast<int>(MaxDecimalScale) < scale)
+            {
+                return false;
+            }
+
+            value.m_Mantissa = negative ? -mantissa : mantissa;
+            value.m_Scale = static_cast<uint64_t>(scale);
+            return true;
+        }
+
+        // Integer-to-text with the decimal point inserted m_Scale digits from
+        // the right; always valid JSON ("0.05", never ".05")
+        inline size_t FormatDecimal(char* out, Decimal value) noexcept
+        {
+            char* current = out;
+            int64_t mantissa = value.m_Mantissa;
+
+            if (0 > mantissa)
+            {
+                *current++ = '-';
+                mantissa = -mantissa;
+            }
+
+            char digits[MaxUInt64Digits];
+            const size_t digitCount = FormatUInt64(digits, static_cast<uint64_t>(mantissa));
+            const size_t scale = static_cast<size_t>(value.m_Scale);
+
+            if (0 == scale)
+            {
+                std::memcpy(current, digits, digitCount);
+                return static_cast<size_t>(current - out) + digitCount;
+            }
+
+            if (digitCount > scale)
+            {
+                const size_t integerDigits = digitCount - scale;
+                std::memcpy(current, digits, integerDigits);
+                current += integerDigits;
+                *current++ = '.';
+                std::memcpy(current, digits + integerDigits, scale);
+                return static_cast<size_t>(current - out) + scale;
+            }
+
+            *current++ = '0';
+            *current++ = '.';
+            std::memset(current, '0', scale - digitCount);
+            current += scale - digitCount;
+            std::memcpy(current, digits, digitCount);
+            return static_cast<size_t>(current - out) + digitCount;
+        }
+
+        inline bool ParseNumber(const char* first, const char* last, Decimal& value) noexcept
+        {
+            return ParseDecimal(first, last, value);
+        }
+
+        constexpr bool IsPositive(Decimal value) noexcept
+        {
+            return 0 < value.m_Mantissa;
+        }
+
+        // Nearest double, for checks that compare against floating-point
+        // reference data; never used on the output path
+        inline double ToDouble(Decimal value) noexcept
+        {
+            double divisor = 1.0;
+            for (uint64_t scale = value.m_Scale; 0 < scale; --scale)
+            {
+                divisor *= 10.0;
+            }
+            return static_cast<double>(value.m_Mantissa) / divisor;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_LatencyHistogram.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace fischer::deribit
+{
+    // Monotonic nanoseconds for pacing. A sleep alone wakes up tens of
+    // microseconds late and a spin alone burns a core for the whole wait,
+    // so WaitUntil sleeps until spinNanoseconds before the deadline and
+    // busy-polls the rest. steady_clock is CLOCK_MONOTONIC on Linux, which
+    // is what the sleep is timed against.
+    class SteadyPacingClock
+    {
+    public:
+        explicit SteadyPacingClock(int64_t spinNanoseconds = DeribitTraits::PacingSpinNanoseconds)
+            : m_SpinNanoseconds{spinNanoseconds}
+        {
+        }
+
+        int64_t GetSpinNanoseconds() const noexcept { return m_SpinNanoseconds; }
+
+        int64_t Now() const noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void WaitUntil(int64_t deadline) const noexcept
+        {
+            const int64_t wakeUp = deadline - m_SpinNanoseconds;
+            if (Now() < wakeUp)
+            {
+                const timespec time{static_cast<time_t>(wakeUp / 1000000000), static_cast<long>(wakeUp % 1000000000)};
+                while (EINTR == ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr))
+                {
+                }
+            }
+
+            while (Now() < deadline)
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                _mm_pause();
+#endif
+            }
+        }
+
+    private:
+        int64_t m_SpinNanoseconds;
+    };
+
+    // Time that passes only when told to: WaitUntil jumps to the deadline,
+    // and Advance stands in for work such as a sink's send. Makes a pacing
+    // schedule exact and repeatable, with no real waiting.
+    class SimulatedPacingClock
+    {
+    public:
+        explicit SimulatedPacingClock(int64_t start = 0) : m_Now{start} {}
+
+        int64_t Now() const noexcept { return m_Now; }
+        void WaitUntil(int64_t deadline) noexcept { m_Now = std::max(m_Now, deadline); }
+        void Advance(int64_t nanoseconds) noexcept { m_Now += nanoseconds; }
+
+    private:
+        int64_t m_Now;
+    };
+
+    // Releases messages under a token bucket of burst tokens refilled at
+    // rate tokens per second, one token per message - the credit model of
+    // the exchange's matching-engine limits. Kept in GCRA form: m_Tat is the
+    // time the bucket would be full again, and a message may go once
+    // m_Tat - tolerance has passed. The schedule is advanced from each
+    // actual release time, so a late release never lets a later burst
+    // exceed the limit. The refill interval is rounded up to whole
+    // nanoseconds, erring below the target rate.
+    //
+    // Messages that are due at the same moment go to the sink in one call.
+    // Each message's lateness is the time from its due time - when a token
+    // was available and it had been offered - to its release.
+    template<typename Traits = DeribitTraits, typename Clock = SteadyPacingClock>
+    class EmissionPacer
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+        using HistogramType = LatencyHistogram<Traits>;
+
+        EmissionPacer(double rate, SizeType burst, Clock clock = Clock{})
+            : m_Clock{clock}
+            , m_TargetRate{rate}
+            , m_Interval{std::max<int64_t>(1, static_cast<int64_t>(std::ceil(NanosecondsPerSecond / rate)))}
+            , m_Tolerance{static_cast<int64_t>(std::max<SizeType>(1, burst) - 1) * m_Interval}
+        {
+        }
+
+        // Releases count messages in order, calling sink(n) for each run of n
+        // messages released together; returns once the last one is released
+        template<typename Sink>
+        void Release(SizeType count, Sink&& sink)
+        {
+            const int64_t offered = m_Clock.Now();
+
+            for (SizeType released = 0; released < count;)
+            {
+                int64_t now = m_Clock.Now();
+                const int64_t due = std::max(m_Tat - m_Tolerance, offered);
+                if (now < due)
+                {
+                    m_Clock.WaitUntil(due);
+                    now = m_Clock.Now();
+                    m_WaitCount++;
+                }
+
+                SizeType group = 0;
+                do
+                {
+                    m_Lateness.Record(static_cast<uint64_t>(now - std::max(m_Tat - m_Tolerance, offered)));
+                    m_Tat = std::max(m_Tat, now) + m_Interval;
+                    group++;
+                }
+                while (released + group < count && m_Tat - m_Tolerance <= now);
+
+                if (0 == m_ReleasedCount)
+                {
+                    m_FirstRelease = now;
+                }
+                m_LastRelease = now;
+                m_ReleasedCount += group;
+                released += group;
+
+                sink(group);
+            }
+        }
+
+        double GetTargetRate() const { return m_TargetRate; }
+
+        // Messages per second from the first release to the last; above the
+        // target by the initial burst on a run not much longer than it
+        double GetAchievedRate() const
+        {
+            if (2 > m_ReleasedCount || m_LastRelease <= m_FirstRelease)
+            {
+                return 0.0;
+            }
+            return static_cast<double>(m_ReleasedCount - 1) * NanosecondsPerSecond /
+                   static_cast<double>(m_LastRelease - m_FirstRelease);
+        }
+
+        uint64_t GetReleasedCount() const { return m_ReleasedCount; }
+        uint64_t GetWaitCount() const { return m_WaitCount; }
+
+        // Release lateness in nanoseconds
+        const HistogramType& GetLateness() const { return m_Lateness; }
+
+        Clock& GetClock() { return m_Clock; }
+
+    private:
+        static constexpr double NanosecondsPerSecond = 1e9;
+
+        Clock m_Clock;
+        double m_TargetRate;
+        int64_t m_Interval;
+        int64_t m_Tolerance;
+        int64_t m_Tat{0};
+        int64_t m_FirstRelease{0};
+        int64_t m_LastRelease{0};
+        uint64_t m_ReleasedCount{0};
+        uint64_t m_WaitCount{0};
+        HistogramType m_Lateness;
+    };
+}
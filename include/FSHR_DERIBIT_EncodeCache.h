@@ -0,0 +1,171 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Content key of one input row: two 64-bit multiply-xorshift lanes over
+    // the row's bytes. Not cryptographic; at 128 bits an accidental collision
+    // between two rows is not a practical concern.
+    struct RowKey
+    {
+        uint64_t m_Low{0};
+        uint64_t m_High{0};
+
+        bool operator==(const RowKey&) const = default;
+    };
+
+    // Encoded message bodies of earlier runs, keyed by row content.
+    //
+    // A body is everything a message holds after its ID, so a cached row is
+    // emitted by writing the prefix and a fresh ID in front of it. Bodies
+    // depend on the column plan and the encoding options as well as the row,
+    // so every cache carries a context hash and one of another context is
+    // replaced.
+    //
+    // The file is a 40-byte header followed by records of a 24-byte key and
+    // length and the body bytes. Rows that were not cached are appended, and
+    // the header's record count is updated on every Flush, so the counted
+    // records are always complete and a run that stops early leaves a valid
+    // cache behind. Records of rows that have left the input stay until a
+    // complete run finds more than half of the cache unused and compacts it.
+    template<typename Traits = DeribitTraits>
+    class EncodeCache
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+
+        EncodeCache() = default;
+        EncodeCache(const EncodeCache&) = delete;
+        EncodeCache& operator=(const EncodeCache&) = delete;
+        ~EncodeCache() noexcept { Close(); }
+
+        static uint64_t HashContext(std::string_view headerLine, NumberFormat numberFormat, bool interning) noexcept;
+        static RowKey HashRow(std::string_view row) noexcept;
+
+        // Maps and indexes the cache; false if there is none or it does not
+        // match context, in which case every row is encoded
+        bool Load(const std::string& filename, uint64_t context);
+
+        // The cached body of a row, which is marked as used; empty if the row
+        // is not cached
+        std::string_view Find(const RowKey& key) noexcept;
+
+        // Appends to the loaded cache, or starts a new one for context
+        void BeginWrite(const std::string& filename, uint64_t context);
+        void Append(const RowKey& key, std::string_view body);
+
+        // Writes the buffered records and then their count
+        void Flush();
+
+        // Flushes and closes; with compact, a cache that is mostly records
+        // this run did not use is rewritten with the used ones only
+        void Commit(bool compact);
+
+        SizeType GetLoadedCount() const { return m_LoadedCount; }
+        SizeType GetRecordCount() const { return m_RecordCount; }
+
+    protected:
+        struct FileHeader
+        {
+            char m_Magic[8];
+            uint16_t m_Version;
+            uint16_t m_Reserved0;
+            uint32_t m_Reserved1;
+            uint64_t m_Context;
+            uint64_t m_RecordCount;
+            uint64_t m_Reserved2;
+        };
+
+        struct RecordHeader
+        {
+            uint64_t m_KeyLow;
+            uint64_t m_KeyHigh;
+            uint32_t m_BodyLength;
+            uint32_t m_Reserved;
+        };
+
+        static_assert(sizeof(FileHeader) == 40, "Header layout is part of the file format");
+        static_assert(sizeof(RecordHeader) == 24, "Record layout is part of the file format");
+
+        static constexpr char Magic[8] = {'F', 'S', 'H', 'R', 'E', 'N', 'C', '\0'};
+        static constexpr uint16_t FormatVersion = 1;
+
+        // Indexes recordCount records; returns where they end, or nullptr if
+        // the file holds fewer
+        const char* BuildIndex(const char* records, const char* end, SizeType recordCount);
+        SizeType Probe(uint64_t keyLow, uint64_t keyHigh) const noexcept;
+        void WriteAt(uint64_t offset, const void* data, SizeType size);
+        void Compact();
+        void Close() noexcept;
+
+    private:
+        // Open-addressing index over the mapped bodies; a length of 0 marks
+        // an empty slot, as bodies are never empty
+        struct Slot
+        {
+            uint64_t m_KeyLow{0};
+            uint64_t m_KeyHigh{0};
+            const char* m_Body{nullptr};
+            uint32_t m_BodyLength{0};
+            bool m_Used{false};
+        };
+
+        MappedFile m_File;
+        std::vector<Slot> m_Slots;
+        SizeType m_SlotMask{0};
+        SizeType m_LoadedCount{0};
+        SizeType m_UsedCount{0};
+        SizeType m_LoadedRecordCount{0};  // records indexed, repeats included
+        uint64_t m_LoadedSize{0};         // end of the indexed records
+        uint64_t m_Context{0};
+
+        int m_Descriptor{-1};
+        std::string m_Filename;
+        std::string m_Buffer;
+        uint64_t m_FileSize{0};
+        SizeType m_RecordCount{0};        // records in the file
+        SizeType m_BufferedCount{0};      // records in m_Buffer
+        SizeType m_AppendedCount{0};
+    };
+
+    // Progress of an incremental run, saved beside the output: a run that
+    // finds a checkpoint for the same input and context continues after the
+    // last row it covers instead of starting over
+    struct IncrementalCheckpoint
+    {
+        char m_Magic[8]{};
+        uint16_t m_Version{0};
+        uint16_t m_Reserved0{0};
+        uint32_t m_Reserved1{0};
+        uint64_t m_Context{0};
+        uint64_t m_InputSize{0};
+        int64_t m_InputModified{0};     // nanoseconds since the epoch
+        uint64_t m_InputOffset{0};      // from the first data row
+        uint64_t m_InputLine{0};
+        int64_t m_NextMessageId{0};
+        uint64_t m_OutputOffset{0};
+        uint64_t m_RejectsOffset{0};
+        uint64_t m_RejectCount{0};
+        uint64_t m_OrderCount{0};
+
+        static constexpr char Magic[8] = {'F', 'S', 'H', 'R', 'C', 'K', 'P', '\0'};
+        static constexpr uint16_t FormatVersion = 1;
+
+        // False if there is no checkpoint or it is not one
+        bool Load(const std::string& filename);
+
+        // Written to a ".tmp" file and renamed, so a reader sees the old or
+        // the new checkpoint, never a torn one
+        void Save(const std::string& filename);
+    };
+}
+
+#include <FSHR_DERIBIT_EncodeCache.hxx>
@@ -0,0 +1,413 @@
+#include "FSHR_DERIBIT_EncodeCache.h"
+#include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_Decimal.h"
+#include "FSHR_DERIBIT_Logger.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fischer::deribit
+{
+    template<typename Traits>
+    uint64_t EncodeCache<Traits>::HashContext(std::string_view headerLine, NumberFormat numberFormat,
+                                              bool interning) noexcept
+    {
+        const RowKey key = HashRow(headerLine);
+        const uint64_t options = static_cast<uint64_t>(numberFormat) |
+                                 (static_cast<uint64_t>(interning) << 8) |
+                                 (static_cast<uint64_t>(std::is_same_v<typename Traits::AmountType, Decimal>) << 9) |
+                                 (static_cast<uint64_t>(FormatVersion) << 16);
+        return (key.m_Low ^ options) * 0xBF58476D1CE4E5B9ULL ^ key.m_High;
+    }
+
+    template<typename Traits>
+    RowKey EncodeCache<Traits>::HashRow(std::string_view row) noexcept
+    {
+        uint64_t low = 0x9E3779B97F4A7C15ULL ^ row.size();
+        uint64_t high = 0xD6E8FEB86659FD93ULL ^ (row.size() << 17);
+        SizeType offset = 0;
+
+        for (; offset + sizeof(uint64_t) <= row.size(); offset += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, row.data() + offset, sizeof(word));
+            low = (low ^ word) * 0xBF58476D1CE4E5B9ULL;
+            low ^= low >> 31;
+            high = (high ^ std::rotl(word, 29)) * 0x94D049BB133111EBULL;
+            high ^= high >> 29;
+        }
+
+        uint64_t tail = 0;
+        std::memcpy(&tail, row.data() + offset, row.size() - offset);
+        low = (low ^ tail) * 0x94D049BB133111EBULL;
+        high = (high ^ std::rotl(tail, 29)) * 0xBF58476D1CE4E5B9ULL;
+        return RowKey{low ^ (low >> 29), high ^ (high >> 31)};
+    }
+
+    template<typename Traits>
+    bool EncodeCache<Traits>::Load(const std::string& filename, uint64_t context)
+    {
+        m_Slots.clear();
+        m_File.Close();
+        m_LoadedCount = 0;
+        m_LoadedRecordCount = 0;
+        m_UsedCount = 0;
+        m_LoadedSize = 0;
+        m_Context = context;
+
+        if (false == std::filesystem::exists(filename))
+        {
+            return false;
+        }
+
+        FileHeader header{};
+        if (false == m_File.Open(filename) || sizeof(header) > m_File.GetSize())
+        {
+            LOG_WARNING("Replacing unreadable encode cache:", filename);
+            m_File.Close();
+            return false;
+        }
+
+        std::memcpy(&header, m_File.GetData(), sizeof(header));
+        if (0 != std::memcmp(header.m_Magic, Magic, sizeof(Magic)) || FormatVersion != header.m_Version)
+        {
+            LOG_WARNING("Replacing encode cache of another format:", filename);
+            m_File.Close();
+            return false;
+        }
+
+        if (context != header.m_Context)
+        {
+            LOG_INFO("Encode cache was built for another header or encoding; encoding every row");
+            m_File.Close();
+            return false;
+        }
+
+        const char* recordsEnd = BuildIndex(m_File.GetData() + sizeof(header), m_File.GetData() + m_File.GetSize(),
+                                            static_cast<SizeType>(header.m_RecordCount));
+        if (nullptr == recordsEnd)
+        {
+            LOG_WARNING("Replacing truncated encode cache:", filename);
+            m_Slots.clear();
+            m_File.Close();
+            m_LoadedCount = 0;
+            return false;
+        }
+
+        m_LoadedRecordCount = static_cast<SizeType>(header.m_RecordCount);
+        m_LoadedSize = static_cast<uint64_t>(recordsEnd - m_File.GetData());
+
+        LOG_INFO("Loaded", m_LoadedCount, "cached messages from", filename);
+        return true;
+    }
+
+    template<typename Traits>
+    const char* EncodeCache<Traits>::BuildIndex(const char* records, const char* end, SizeType recordCount)
+    {
+        m_Slots.assign(std::bit_ceil(std::max<SizeType>(recordCount * 2, 16)), Slot{});
+        m_SlotMask = m_Slots.size() - 1;
+
+        for (SizeType index = 0; index < recordCount; ++index)
+        {
+            RecordHeader record;
+            if (static_cast<SizeType>(end - records) < sizeof(record))
+            {
+                return nullptr;
+            }
+
+            std::memcpy(&record, records, sizeof(record));
+            records += sizeof(record);
+
+            if (0 == record.m_BodyLength || static_cast<SizeType>(end - records) < record.m_BodyLength)
+            {
+                return nullptr;
+            }
+
+            // Rows that repeat keep their first record
+            Slot& slot = m_Slots[Probe(record.m_KeyLow, record.m_KeyHigh)];
+            if (0 == slot.m_BodyLength)
+            {
+                slot = Slot{record.m_KeyLow, record.m_KeyHigh, records, record.m_BodyLength, false};
+                m_LoadedCount++;
+            }
+
+            records += record.m_BodyLength;
+        }
+
+        return records;
+    }
+
+    // The slot holding the key, or the empty slot where it would go
+    template<typename Traits>
+    typename EncodeCache<Traits>::SizeType
+    EncodeCache<Traits>::Probe(uint64_t keyLow, uint64_t keyHigh) const noexcept
+    {
+        for (SizeType slot = keyLow & m_SlotMask; ; slot = (slot + 1) & m_SlotMask)
+        {
+            const Slot& entry = m_Slots[slot];
+            if (0 == entry.m_BodyLength || (keyLow == entry.m_KeyLow && keyHigh == entry.m_KeyHigh))
+            {
+                return slot;
+            }
+        }
+    }
+
+    template<typename Traits>
+    std::string_view EncodeCache<Traits>::Find(const RowKey& key) noexcept
+    {
+        if (true == m_Slots.empty())
+        {
+            return {};
+        }
+
+        Slot& slot = m_Slots[Probe(key.m_Low, key.m_High)];
+        if (0 < slot.m_BodyLength && false == slot.m_Used)
+        {
+            slot.m_Used = true;
+            m_UsedCount++;
+        }
+        return std::string_view(slot.m_Body, slot.m_BodyLength);
+    }
+
+    template<typename Traits>
+    void EncodeCache<Traits>::BeginWrite(const std::string& filename, uint64_t context)
+    {
+        m_Filename = filename;
+        m_Context = context;
+        m_Buffer.clear();
+        m_Buffer.reserve(Traits::CacheWriteBufferSize);
+        m_BufferedCount = 0;
+        m_AppendedCount = 0;
+
+        // Records after the counted ones are the incomplete tail of a run
+        // that stopped; the mapping never reads them
+        const bool append = true == m_File.IsOpen();
+        m_Descriptor = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (true == append ? 0 : O_TRUNC), 0644);
+
+        if (0 > m_Descriptor ||
+            (true == append && 0 != ::ftruncate(m_Descriptor, static_cast<off_t>(m_LoadedSize))))
+        {
+            LOG_ERROR("Failed to open encode cache:", filename, std::strerror(errno));
+            throw std::runtime_error("Failed to open encode cache");
+        }
+
+        if (true == append)
+        {
+            m_FileSize = m_LoadedSize;
+            m_RecordCount = m_LoadedRecordCount;
+        }
+        else
+        {
+            FileHeader header{};
+            std::memcpy(header.m_Magic, Magic, sizeof(Magic));
+            header.m_Version = FormatVersion;
+            header.m_Context = context;
+            WriteAt(0, &header, sizeof(header));
+            m_FileSize = sizeof(header);
+            m_RecordCount = 0;
+        }
+    }
+
+    template<typename Traits>
+    void EncodeCache<Traits>::Append(const RowKey& key, std::string_view body)
+    {
+        if (Traits::CacheWriteBufferSize <= m_Buffer.size())
+        {
+            WriteAt(m_FileSize, m_Buffer.data(), m_Buffer.size());
+            m_FileSize += m_Buffer.size();
+            m_RecordCount += m_BufferedCount;
+            m_BufferedCount = 0;
+            m_Buffer.clear();
+        }
+
+        const RecordHeader record{key.m_Low, key.m_High, static_cast<uint32_t>(body.size()), 0};
+        m_Buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        m_Buffer.append(body);
+        m_BufferedCount++;
+        m_AppendedCount++;
+    }
+
+    template<typename Traits>
+    void EncodeCache<Traits>::Flush()
+    {
+        WriteAt(m_FileSize, m_Buffer.data(), m_Buffer.size());
+        m_FileSize += m_Buffer.size();
+        m_RecordCount += m_BufferedCount;
+        m_BufferedCount = 0;
+        m_Buffer.clear();
+
+        // The count follows the records it covers
+        const uint64_t recordCount = m_RecordCount;
+        WriteAt(offsetof(FileHeader, m_RecordCount), &recordCount, sizeof(recordCount));
+    }
+
+    template<typename Traits>
+    void EncodeCache<Traits>::Commit(bool compact)
+    {
+        Flush();
+
+        const SizeType liveCount = m_UsedCount + m_AppendedCount;
+        if (true == compact && m_RecordCount > 2 * liveCount)
+        {
+            Compact();
+        }
+
+        LOG_INFO("Encode cache saved:", m_Filename, "messages:", m_RecordCount, "new:", m_AppendedCount);
+        Close();
+    }
+
+    // Rewrites the cache with the records this run used or appended, then
+    // replaces it; a run that stops meanwhile leaves the old one intact
+    template<typename Traits>
+    void EncodeCache<Traits>::Compact()
+    {
+        MappedFile file;
+        if (false == file.Open(m_Filename))
+        {
+            LOG_WARNING("Failed to map encode cache for compaction:", m_Filename);
+            return;
+        }
+
+        const std::string partialName = m_Filename + std::string(PartialFileSuffix);
+        std::ofstream output(partialName, std::ios::binary | std::ios::trunc);
+
+        FileHeader header{};
+        std::memcpy(&header, file.GetData(), sizeof(header));
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const char* records = file.GetData() + sizeof(header);
+        SizeType keptCount = 0;
+
+        for (SizeType index = 0; index < m_RecordCount; ++index)
+        {
+            RecordHeader record;
+            std::memcpy(&record, records, sizeof(record));
+            const SizeType recordSize = sizeof(record) + record.m_BodyLength;
+
+            // Appended records are all kept; of the loaded ones, the first
+            // record of each used row
+            bool keep = index >= m_LoadedRecordCount;
+            if (false == keep)
+            {
+                Slot& slot = m_Slots[Probe(record.m_KeyLow, record.m_KeyHigh)];
+                keep = slot.m_Used;
+                slot.m_Used = false;
+            }
+
+            if (true == keep)
+            {
+                output.write(records, static_cast<std::streamsize>(recordSize));
+                keptCount++;
+            }
+            records += recordSize;
+        }
+
+        const uint64_t recordCount = keptCount;
+        output.seekp(offsetof(FileHeader, m_RecordCount));
+        output.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
+        output.close();
+
+        if (true == output.fail())
+        {
+            LOG_WARNING("Failed to compact encode cache:", m_Filename);
+            std::filesystem::remove(partialName);
+            return;
+        }
+
+        std::filesystem::rename(partialName, m_Filename);
+        LOG_INFO("Encode cache compacted from", m_RecordCount, "to", keptCount, "messages");
+        m_RecordCount = keptCount;
+    }
+
+    template<typename Traits>
+    void EncodeCache<Traits>::WriteAt(uint64_t offset, const void* data, SizeType size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+
+        while (0 < size)
+        {
+            const ssize_t written = ::pwrite(m_Descriptor, bytes, size, static_cast<off_t>(offset));
+            if (0 > written && EINTR == errno)
+            {
+                continue;
+            }
+            if (0 >= written)
+            {
+                LOG_ERROR("Failed to write encode cache:", m_Filename, std::strerror(errno));
+                throw std::runtime_error("Failed to write encode cache");
+            }
+
+            bytes += written;
+            offset += static_cast<uint64_t>(written);
+            size -= static_cast<SizeType>(written);
+        }
+    }
+
+    template<typename Traits>
+    void EncodeCache<Traits>::Close() noexcept
+    {
+        if (0 <= m_Descriptor)
+        {
+            ::close(m_Descriptor);
+            m_Descriptor = -1;
+        }
+
+        m_File.Close();
+        m_Slots.clear();
+    }
+
+    inline bool IncrementalCheckpoint::Load(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        if (false == file.is_open())
+        {
+            return false;
+        }
+
+        IncrementalCheckpoint checkpoint;
+        file.read(reinterpret_cast<char*>(&checkpoint), sizeof(checkpoint));
+
+        if (sizeof(checkpoint) != static_cast<size_t>(file.gcount()) ||
+            0 != std::memcmp(checkpoint.m_Magic, Magic, sizeof(Magic)) || FormatVersion != checkpoint.m_Version)
+        {
+            LOG_WARNING("Ignoring unreadable checkpoint:", filename);
+            return false;
+        }
+
+        *this = checkpoint;
+        return true;
+    }
+
+    inline void IncrementalCheckpoint::Save(const std::string& filename)
+    {
+        std::memcpy(m_Magic, Magic, sizeof(Magic));
+        m_Version = FormatVersion;
+
+        const std::string partialName = filename + std::string(PartialFileSuffix);
+        {
+            std::ofstream file(partialName, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(this), sizeof(*this));
+
+            if (false == file.good())
+            {
+                LOG_ERROR("Failed to write checkpoint:", partialName);
+                throw std::runtime_error("Failed to write checkpoint");
+            }
+        }
+
+        std::filesystem::rename(partialName, filename);
+    }
+
+    template class EncodeCache<DeribitTraits>;
+    template class EncodeCache<DeribitFixedPointTraits>;
+}
@@ -68,7 +68,9 @@ namespace fischer::deribit
         Rejected = 2,
         Cancelled = 3,
         Untriggered = 4,
-        Archive = 5
+        Archive = 5,
+        Unknown = 6,        // no order_state in the response, or one not listed
+        MaxStates
     };
 
     enum class LogLevel : uint8_t
@@ -100,6 +102,96 @@ namespace fischer::deribit
         Failed = 5
     };
 
+    // Rendering of floating-point values in the JSON output
+    enum class NumberFormat : uint8_t
+    {
+        Printf = 0,         // snprintf("%.10g"), the reference rendering
+        Compatible = 1,     // byte-identical to Printf, without printf overhead
+        Shortest = 2        // shortest round-trip representation
+    };
+
+    // How encoded output reaches the file
+    enum class OutputBackend : uint8_t
+    {
+        Synchronous = 0,    // write() on the encoding thread
+        Thread = 1,         // pwritev() from a writer thread
+        IoUring = 2         // io_uring submissions; falls back to Thread if unavailable
+    };
+
+    // When written output is forced to stable storage with fdatasync
+    enum class SyncPolicy : uint8_t
+    {
+        None = 0,
+        OnClose = 1,
+        EveryWrite = 2
+    };
+
+    // Encoding of the order input and of the processed output
+    enum class InputFormat : uint8_t
+    {
+        Csv = 0,
+        Binary = 1          // BinaryOrderFile records, decoded without text parsing
+    };
+
+    enum class OutputFormat : uint8_t
+    {
+        Json = 0,
+        Binary = 1          // converts the input to a BinaryOrderFile
+    };
+
+    // How batch mode numbers the messages of its files
+    enum class MessageIdAllocation : uint8_t
+    {
+        Global = 0,         // one sequence through the files in the order given
+        PerFile = 1         // each file starts its own range of IDs
+    };
+
+    // Page size backing large buffers (PageBuffer)
+    enum class HugePages : uint8_t
+    {
+        Off = 0,            // ordinary heap arrays
+        Transparent = 1,    // 2 MiB-aligned mappings advised for transparent huge pages
+        Explicit = 2        // MAP_HUGETLB from the reserved pool, transparent when it is empty
+    };
+
+    // Hardware events PerfCounters reads
+    enum class PerfEvent : uint8_t
+    {
+        TlbLoads = 0,       // data loads looked up in the TLB
+        TlbLoadMisses,      // of those, misses that walked the page tables
+        NodeLoads,          // loads that missed the caches and went to memory
+        RemoteNodeLoads,    // of those, loads served by another NUMA node
+        MaxEvents
+    };
+
+    // Instrument kinds of the public/get_instruments reference data
+    enum class InstrumentKind : uint8_t
+    {
+        Future = 0,
+        Option = 1,
+        Spot = 2,
+        FutureCombo = 3,
+        OptionCombo = 4
+    };
+
+    // Pre-trade validation failures, most fundamental first: a row failing
+    // several checks is reported with the lowest reason
+    enum class RejectReason : uint8_t
+    {
+        None = 0,
+        InvalidDirection,
+        InvalidType,
+        MissingInstrument,
+        UnknownInstrument,
+        MissingAmount,
+        AmountBelowMinimum,
+        AmountNotMultiple,
+        MissingPrice,
+        PriceNotOnTick,
+        InvalidTrigger,
+        AdvancedNotOption
+    };
+
     enum class FieldIndex : int8_t
     {
         None = -1,
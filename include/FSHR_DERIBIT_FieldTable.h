@@ -0,0 +1,142 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_Constants.h"
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+namespace fischer::deribit
+{
+    // How a field's value is rendered in the params object
+    enum class FieldEncoding : uint8_t
+    {
+        Number = 0,
+        Text = 1,       // verbatim text view
+        Enum = 2,       // verbatim text view, also parsed into its enum
+        Boolean = 3,
+        Integer = 4
+    };
+
+    // When a field is written into the params object
+    enum class FieldEmission : uint8_t
+    {
+        Envelope = 0,       // written outside params (id, method)
+        WhenPositive = 1,   // written when the value is greater than zero
+        WhenPresent = 2     // written when the CSV column was non-empty
+    };
+
+    struct FieldDescriptor
+    {
+        FieldIndex m_Index;
+        std::string_view m_Name;
+        FieldEncoding m_Encoding;
+        FieldEmission m_Emission;
+    };
+
+    // Single source of truth for the CSV header names and the JSON params
+    // layout. CsvParser maps header columns through it and JsonBuilder emits
+    // params in table order, so the two can never disagree on a field name.
+    inline constexpr std::array<FieldDescriptor, static_cast<size_t>(FieldIndex::MaxFields)> FieldTable
+    {{
+        {FieldIndex::Id,                   FieldId,                   FieldEncoding::Integer, FieldEmission::Envelope},
+        {FieldIndex::Direction,            FieldDirection,            FieldEncoding::Enum,    FieldEmission::Envelope},
+        {FieldIndex::Amount,               FieldAmount,               FieldEncoding::Number,  FieldEmission::WhenPositive},
+        {FieldIndex::Contracts,            FieldContracts,            FieldEncoding::Number,  FieldEmission::WhenPositive},
+        {FieldIndex::InstrumentName,       FieldInstrumentName,       FieldEncoding::Text,    FieldEmission::WhenPresent},
+        {FieldIndex::Label,                FieldLabel,                FieldEncoding::Text,    FieldEmission::WhenPresent},
+        {FieldIndex::Type,                 FieldType,                 FieldEncoding::Enum,    FieldEmission::WhenPresent},
+        {FieldIndex::Price,                FieldPrice,                FieldEncoding::Number,  FieldEmission::WhenPresent},
+        {FieldIndex::TimeInForce,          FieldTimeInForce,          FieldEncoding::Enum,    FieldEmission::WhenPresent},
+        {FieldIndex::DisplayAmount,        FieldDisplayAmount,        FieldEncoding::Number,  FieldEmission::WhenPresent},
+        {FieldIndex::PostOnly,             FieldPostOnly,             FieldEncoding::Boolean, FieldEmission::WhenPresent},
+        {FieldIndex::RejectPostOnly,       FieldRejectPostOnly,       FieldEncoding::Boolean, FieldEmission::WhenPresent},
+        {FieldIndex::ReduceOnly,           FieldReduceOnly,           FieldEncoding::Boolean, FieldEmission::WhenPresent},
+        {FieldIndex::TriggerPrice,         FieldTriggerPrice,         FieldEncoding::Number,  FieldEmission::WhenPresent},
+        {FieldIndex::TriggerOffset,        FieldTriggerOffset,        FieldEncoding::Number,  FieldEmission::WhenPresent},
+        {FieldIndex::Trigger,              FieldTrigger,              FieldEncoding::Enum,    FieldEmission::WhenPresent},
+        {FieldIndex::Advanced,             FieldAdvanced,             FieldEncoding::Enum,    FieldEmission::WhenPresent},
+        {FieldIndex::Mmp,                  FieldMmp,                  FieldEncoding::Boolean, FieldEmission::WhenPresent},
+        {FieldIndex::ValidUntil,           FieldValidUntil,           FieldEncoding::Integer, FieldEmission::WhenPresent},
+        {FieldIndex::LinkedOrderType,      FieldLinkedOrderType,      FieldEncoding::Enum,    FieldEmission::WhenPresent},
+        {FieldIndex::TriggerFillCondition, FieldTriggerFillCondition, FieldEncoding::Enum,    FieldEmission::WhenPresent}
+    }};
+
+    constexpr bool IsFieldTableComplete() noexcept
+    {
+        uint32_t seen = 0;
+        for (const FieldDescriptor& field : FieldTable)
+        {
+            const uint32_t bit = uint32_t{1} << static_cast<uint32_t>(field.m_Index);
+            if (FieldIndex::None == field.m_Index || 0 != (seen & bit) || true == field.m_Name.empty())
+            {
+                return false;
+            }
+            seen |= bit;
+        }
+        return true;
+    }
+
+    static_assert(IsFieldTableComplete(), "FieldTable must list every FieldIndex exactly once");
+
+    constexpr const FieldDescriptor& GetFieldDescriptor(FieldIndex index) noexcept
+    {
+        size_t slot = 0;
+        while (FieldTable[slot].m_Index != index)
+        {
+            ++slot;
+        }
+        return FieldTable[slot];
+    }
+
+    // Pre-rendered ,"name": key, written with one copy per field; the leading
+    // comma is skipped for the first field in params
+    constexpr size_t MaxKeyFragmentLength = 32;
+
+    struct KeyFragment
+    {
+        std::array<char, MaxKeyFragmentLength> m_Text{};
+        size_t m_Length{0};
+    };
+
+    constexpr KeyFragment MakeKeyFragment(std::string_view name) noexcept
+    {
+        KeyFragment fragment;
+        fragment.m_Text[fragment.m_Length++] = ',';
+        fragment.m_Text[fragment.m_Length++] = '"';
+        for (const char c : name)
+        {
+            fragment.m_Text[fragment.m_Length++] = c;
+        }
+        fragment.m_Text[fragment.m_Length++] = '"';
+        fragment.m_Text[fragment.m_Length++] = ':';
+        return fragment;
+    }
+
+    inline constexpr std::array<KeyFragment, FieldTable.size()> KeyFragments = []()
+    {
+        std::array<KeyFragment, FieldTable.size()> fragments{};
+        for (size_t slot = 0; slot < FieldTable.size(); ++slot)
+        {
+            fragments[slot] = MakeKeyFragment(FieldTable[slot].m_Name);
+        }
+        return fragments;
+    }();
+
+    constexpr FieldIndex LookupFieldIndex(std::string_view name) noexcept
+    {
+        for (const FieldDescriptor& field : FieldTable)
+        {
+            if (field.m_Name.size() == name.size() && field.m_Name == name)
+            {
+                return field.m_Index;
+            }
+        }
+        return FieldIndex::None;
+    }
+
+    static_assert(FieldIndex::TriggerFillCondition == LookupFieldIndex("trigger_fill_condition"));
+    static_assert(FieldIndex::None == LookupFieldIndex("unknown"));
+}
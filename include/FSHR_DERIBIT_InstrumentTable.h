@@ -0,0 +1,342 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_InternTable.h"
+#include "FSHR_DERIBIT_MappedFile.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_Utils.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Trading rules of one instrument, as published by public/get_instruments
+    struct InstrumentSpec
+    {
+        double m_TickSize{0.0};
+        double m_MinTradeAmount{0.0};
+        double m_ContractSize{0.0};
+        InstrumentKind m_Kind{InstrumentKind::Future};
+    };
+
+    // Instrument reference data, indexed by name. Specs are flat POD records
+    // in one array, addressed by the name's InternTable ID, so a lookup is a
+    // hash probe and an index; validators cache the index per name they see.
+    //
+    // Read-only once loaded, so it can be shared by parallel workers.
+    template<typename Traits = DeribitTraits>
+    class InstrumentTable
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+        using IndexType = typename InternTable<Traits>::IdType;
+
+        static constexpr IndexType NoInstrument = InternTable<Traits>::NoId;
+
+        InstrumentTable()
+            : m_Names{{}, {}, Traits::InstrumentTableCapacity}
+        {
+            m_Specs.emplace_back();     // index 0 is NoInstrument
+        }
+
+        // Accepts a saved public/get_instruments response, whose "result"
+        // member holds the instruments, or the bare array of instruments. The
+        // dump is memory-mapped and scanned in place; only the fields used by
+        // validation are kept.
+        void Load(const std::string& filename)
+        {
+            MappedFile file;
+            if (false == file.Open(filename))
+            {
+                LOG_ERROR("Failed to map instrument file:", filename);
+                throw std::runtime_error("Failed to load instrument reference data");
+            }
+
+            const char* current = file.GetData();
+            const char* end = current + file.GetSize();
+
+            if (false == FindInstrumentArray(current, end) || false == ParseInstruments(current, end))
+            {
+                LOG_ERROR("Malformed instrument reference data:", filename);
+                throw std::runtime_error("Failed to load instrument reference data");
+            }
+
+            LOG_INFO("Loaded", GetSize(), "instruments from", filename);
+        }
+
+        IndexType Find(std::string_view name) const noexcept { return m_Names.Find(name); }
+        const InstrumentSpec& GetSpec(IndexType index) const noexcept { return m_Specs[index]; }
+        SizeType GetSize() const noexcept { return m_Names.GetSize(); }
+        bool IsLoaded() const noexcept { return 0 < GetSize(); }
+
+    private:
+        static void SkipWhitespace(const char*& current, const char* end) noexcept
+        {
+            while (current < end && (' ' == *current || '\t' == *current || '\n' == *current || '\r' == *current))
+            {
+                ++current;
+            }
+        }
+
+        // Raw contents between the quotes; instrument names and kinds never
+        // contain escapes, so none are decoded
+        static bool ParseString(const char*& current, const char* end, std::string_view& value) noexcept
+        {
+            if (current >= end || '"' != *current)
+            {
+                return false;
+            }
+
+            const char* begin = ++current;
+            for (; current < end && '"' != *current; ++current)
+            {
+                current += '\\' == *current ? 1 : 0;
+            }
+
+            if (current >= end)
+            {
+                return false;
+            }
+
+            value = std::string_view(begin, static_cast<SizeType>(current - begin));
+            ++current;
+            return true;
+        }
+
+        static bool SkipValue(const char*& current, const char* end) noexcept
+        {
+            std::string_view ignored;
+            if (current < end && '"' == *current)
+            {
+                return ParseString(current, end, ignored);
+            }
+
+            if (current < end && ('{' == *current || '[' == *current))
+            {
+                SizeType depth = 0;
+                while (current < end)
+                {
+                    if ('"' == *current)
+                    {
+                        if (false == ParseString(current, end, ignored))
+                        {
+                            return false;
+                        }
+                        continue;
+                    }
+
+                    depth += ('{' == *current || '[' == *current) ? 1 : 0;
+                    depth -= ('}' == *current || ']' == *current) ? 1 : 0;
+                    ++current;
+
+                    if (0 == depth)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Number, true, false or null
+            const char* begin = current;
+            while (current < end && ',' != *current && '}' != *current && ']' != *current &&
+                   ' ' != *current && '\n' != *current && '\r' != *current && '\t' != *current)
+            {
+                ++current;
+            }
+            return current > begin;
+        }
+
+        // Leaves current just inside the '[' of the instrument array
+        static bool FindInstrumentArray(const char*& current, const char* end) noexcept
+        {
+            SkipWhitespace(current, end);
+            if (current < end && '[' == *current)
+            {
+                ++current;
+                return true;
+            }
+
+            if (current >= end || '{' != *current)
+            {
+                return false;
+            }
+
+            ++current;
+            for (;;)
+            {
+                std::string_view key;
+                SkipWhitespace(current, end);
+                if (false == ParseString(current, end, key))
+                {
+                    return false;
+                }
+
+                SkipWhitespace(current, end);
+                if (current >= end || ':' != *current++)
+                {
+                    return false;
+                }
+
+                SkipWhitespace(current, end);
+                if ("result" == key)
+                {
+                    return current < end && '[' == *current++;
+                }
+
+                if (false == SkipValue(current, end))
+                {
+                    return false;
+                }
+
+                SkipWhitespace(current, end);
+                if (current >= end || ',' != *current++)
+                {
+                    return false;
+                }
+            }
+        }
+
+        bool ParseInstruments(const char*& current, const char* end)
+        {
+            SkipWhitespace(current, end);
+            if (current < end && ']' == *current)
+            {
+                return true;
+            }
+
+            for (;;)
+            {
+                SkipWhitespace(current, end);
+                if (false == ParseInstrument(current, end))
+                {
+                    return false;
+                }
+
+                SkipWhitespace(current, end);
+                if (current >= end)
+                {
+                    return false;
+                }
+                if (']' == *current)
+                {
+                    return true;
+                }
+                if (',' != *current++)
+                {
+                    return false;
+                }
+            }
+        }
+
+        bool ParseInstrument(const char*& current, const char* end)
+        {
+            if (current >= end || '{' != *current++)
+            {
+                return false;
+            }
+
+            std::string_view name;
+            InstrumentSpec spec;
+
+            SkipWhitespace(current, end);
+            while (current < end && '}' != *current)
+            {
+                std::string_view key;
+                if (false == ParseString(current, end, key))
+                {
+                    return false;
+                }
+
+                SkipWhitespace(current, end);
+                if (current >= end || ':' != *current++)
+                {
+                    return false;
+                }
+
+                SkipWhitespace(current, end);
+                const char* valueBegin = current;
+                if (false == SkipValue(current, end))
+                {
+                    return false;
+                }
+
+                if ("instrument_name" == key || "kind" == key)
+                {
+                    std::string_view text;
+                    const char* textBegin = valueBegin;
+                    if (false == ParseString(textBegin, current, text))
+                    {
+                        return false;
+                    }
+
+                    if ("kind" == key)
+                    {
+                        spec.m_Kind = utils::StringToInstrumentKind(text);
+                    }
+                    else
+                    {
+                        name = text;
+                    }
+                }
+                else if ("tick_size" == key)
+                {
+                    spec.m_TickSize = utils::ParseDouble(valueBegin, current);
+                }
+                else if ("min_trade_amount" == key)
+                {
+                    spec.m_MinTradeAmount = utils::ParseDouble(valueBegin, current);
+                }
+                else if ("contract_size" == key)
+                {
+                    spec.m_ContractSize = utils::ParseDouble(valueBegin, current);
+                }
+
+                SkipWhitespace(current, end);
+                if (current < end && ',' == *current)
+                {
+                    ++current;
+                    SkipWhitespace(current, end);
+                }
+            }
+
+            if (current >= end)
+            {
+                return false;
+            }
+            ++current;
+
+            return true == name.empty() || true == Insert(name, spec);
+        }
+
+        // A name listed twice keeps its last spec
+        bool Insert(std::string_view name, const InstrumentSpec& spec)
+        {
+            const IndexType index = m_Names.Intern(name);
+            if (NoInstrument == index)
+            {
+                LOG_ERROR("Instrument table is full; capacity:", Traits::InstrumentTableCapacity);
+                return false;
+            }
+
+            if (m_Specs.size() == index)
+            {
+                m_Specs.push_back(spec);
+            }
+            else
+            {
+                m_Specs[index] = spec;
+            }
+            return true;
+        }
+
+    private:
+        InternTable<Traits> m_Names;
+        std::vector<InstrumentSpec> m_Specs;
+    };
+}
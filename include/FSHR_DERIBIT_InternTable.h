@@ -0,0 +1,183 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_Utils.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Maps each distinct text to a small ID and keeps the JSON fragment that
+    // text renders to - prefix, escaped text, suffix - so an encoder can emit
+    // the whole fragment with one copy. ID 0 means "not interned": the text
+    // was never seen, or the table was full when it was.
+    //
+    // Not thread-safe; parallel workers each intern into their own table.
+    template<typename Traits = DeribitTraits>
+    class InternTable
+    {
+    public:
+        using IdType = uint16_t;
+        using SizeType = typename Traits::SizeType;
+
+        static constexpr IdType NoId = 0;
+        static constexpr SizeType MaxCapacity = UINT16_MAX - 1;
+
+        InternTable(std::string_view prefix, std::string_view suffix,
+                    SizeType capacity = Traits::InternTableCapacity)
+            : m_Prefix{prefix}
+            , m_Suffix{suffix}
+            , m_Capacity{std::min(capacity, MaxCapacity)}
+            , m_SlotMask{std::bit_ceil(m_Capacity * 2) - 1}     // half-full at most, so probes stay short
+            , m_Slots(m_SlotMask + 1, NoId)
+        {
+            m_Entries.reserve(m_Capacity + 1);
+            m_Entries.emplace_back();           // ID 0 is never a valid entry
+        }
+
+        IdType Intern(std::string_view text)
+        {
+            const uint64_t hash = Hash(text);
+            const SizeType slot = Probe(hash, text);
+            return NoId == m_Slots[slot] ? Insert(slot, hash, text) : m_Slots[slot];
+        }
+
+        // Lookup without inserting; NoId if the text was never interned
+        IdType Find(std::string_view text) const noexcept
+        {
+            return m_Slots[Probe(Hash(text), text)];
+        }
+
+        std::string_view GetFragment(IdType id) const noexcept
+        {
+            const Entry& entry = m_Entries[id];
+            return std::string_view(m_Storage.data() + entry.m_FragmentOffset, entry.m_FragmentLength);
+        }
+
+        SizeType GetSize() const noexcept { return static_cast<SizeType>(m_Entries.size() - 1); }
+
+        // Multiply-xorshift over 8-byte words; instrument names are short, so
+        // this is two or three rounds
+        static uint64_t Hash(std::string_view text) noexcept
+        {
+            uint64_t hash = 0x9E3779B97F4A7C15ULL ^ text.size();
+            SizeType offset = 0;
+
+            for (; offset + sizeof(uint64_t) <= text.size(); offset += sizeof(uint64_t))
+            {
+                uint64_t word;
+                std::memcpy(&word, text.data() + offset, sizeof(word));
+                hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+                hash ^= hash >> 31;
+            }
+
+            uint64_t tail = 0;
+            std::memcpy(&tail, text.data() + offset, text.size() - offset);
+            hash = (hash ^ tail) * 0x94D049BB133111EBULL;
+            return hash ^ (hash >> 29);
+        }
+
+    private:
+        struct Entry
+        {
+            uint64_t m_Hash{0};
+            uint32_t m_TextOffset{0};
+            uint32_t m_TextLength{0};
+            uint32_t m_FragmentOffset{0};
+            uint32_t m_FragmentLength{0};
+        };
+
+        // The slot holding text, or the empty slot where it would go
+        SizeType Probe(uint64_t hash, std::string_view text) const noexcept
+        {
+            for (SizeType slot = hash & m_SlotMask; ; slot = (slot + 1) & m_SlotMask)
+            {
+                const IdType id = m_Slots[slot];
+                if (NoId == id)
+                {
+                    return slot;
+                }
+
+                const Entry& entry = m_Entries[id];
+                if (entry.m_Hash == hash && entry.m_TextLength == text.size() &&
+                    0 == std::memcmp(m_Storage.data() + entry.m_TextOffset, text.data(), text.size()))
+                {
+                    return slot;
+                }
+            }
+        }
+
+        IdType Insert(SizeType slot, uint64_t hash, std::string_view text)
+        {
+            if (m_Capacity <= GetSize())
+            {
+                return NoId;
+            }
+
+            Entry entry;
+            entry.m_Hash = hash;
+            entry.m_TextOffset = static_cast<uint32_t>(m_Storage.size());
+            entry.m_TextLength = static_cast<uint32_t>(text.size());
+            m_Storage.append(text);
+
+            entry.m_FragmentOffset = static_cast<uint32_t>(m_Storage.size());
+            m_Storage.append(m_Prefix);
+            AppendEscaped(text);
+            m_Storage.append(m_Suffix);
+            entry.m_FragmentLength = static_cast<uint32_t>(m_Storage.size() - entry.m_FragmentOffset);
+
+            const IdType id = static_cast<IdType>(m_Entries.size());
+            m_Entries.push_back(entry);
+            m_Slots[slot] = id;
+            return id;
+        }
+
+        // Escaping is paid once per distinct text instead of once per order
+        void AppendEscaped(std::string_view text)
+        {
+            const size_t start = m_Storage.size();
+            m_Storage.resize(start + utils::MaxJsonEscapeLength * text.size());
+            m_Storage.resize(start + utils::EscapeJsonString(m_Storage.data() + start, text));
+        }
+
+    private:
+        std::string m_Prefix;
+        std::string m_Suffix;
+        SizeType m_Capacity;
+        SizeType m_SlotMask;
+        std::string m_Storage;          // raw texts and fragments, addressed by offset
+        std::vector<Entry> m_Entries;
+        std::vector<IdType> m_Slots;
+    };
+
+    // The two fragments every message repeats: the envelope up to params,
+    // which depends only on the direction, and the instrument_name member
+    template<typename Traits = DeribitTraits>
+    struct MessageFragments
+    {
+        InternTable<Traits> m_Methods{JsonRpcField, ParamsPrefix};
+        InternTable<Traits> m_Instruments{InstrumentFragmentPrefix, "\""};
+
+        // Sets the order's fragment IDs for the fields it has
+        template<typename OrderType>
+        void Intern(OrderType& order)
+        {
+            if (true == order.Has(FieldIndex::Direction))
+            {
+                order.m_MethodFragment = m_Methods.Intern(order.GetText(order.m_DirectionText));
+            }
+            if (true == order.Has(FieldIndex::InstrumentName))
+            {
+                order.m_InstrumentFragment = m_Instruments.Intern(order.GetText(order.m_InstrumentName));
+            }
+        }
+    };
+}
@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fischer::deribit
+{
+    // Minimal io_uring over the raw system calls, covering what the output
+    // writer needs: queued writes and data syncs, and reaping completions.
+    // Only one thread may use an instance.
+    class IoUring
+    {
+    public:
+        IoUring() = default;
+
+        IoUring(const IoUring&) = delete;
+        IoUring& operator=(const IoUring&) = delete;
+
+        ~IoUring() noexcept
+        {
+            Close();
+        }
+
+        // Returns false if the kernel does not provide io_uring or it is
+        // blocked (seccomp, io_uring_disabled); callers fall back to threads
+        bool Open(uint32_t entries)
+        {
+            Close();
+
+            io_uring_params params{};
+            const int descriptor = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+            if (0 > descriptor)
+            {
+                return false;
+            }
+
+            m_Descriptor = descriptor;
+            m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            m_SqeSize = params.sq_entries * sizeof(io_uring_sqe);
+
+            // Both rings share one mapping on kernels with IORING_FEAT_SINGLE_MMAP
+            const bool singleMapping = 0 != (params.features & IORING_FEAT_SINGLE_MMAP);
+            if (true == singleMapping)
+            {
+                m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+            }
+
+            m_SqRing = Map(m_SqRingSize, IORING_OFF_SQ_RING);
+            m_CqRing = true == singleMapping ? m_SqRing : Map(m_CqRingSize, IORING_OFF_CQ_RING);
+            m_Sqes = static_cast<io_uring_sqe*>(Map(m_SqeSize, IORING_OFF_SQES));
+
+            if (nullptr == m_SqRing || nullptr == m_CqRing || nullptr == m_Sqes)
+            {
+                Close();
+                return false;
+            }
+
+            char* sq = static_cast<char*>(m_SqRing);
+            m_SqHead = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+            m_SqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+            m_SqMask = *reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+            m_SqEntries = params.sq_entries;
+            m_SqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+            char* cq = static_cast<char*>(m_CqRing);
+            m_CqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+            m_CqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+            m_CqMask = *reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+            m_Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            return true;
+        }
+
+        bool IsOpen() const { return 0 <= m_Descriptor; }
+
+        // Restricts the kernel's async workers for this ring, which run the
+        // writes that cannot complete inline, to cpus (Linux 5.14+)
+        bool SetWorkerAffinity(const std::vector<int>& cpus) noexcept
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus)
+            {
+                CPU_SET(cpu, &set);
+            }
+
+            return 0 == ::syscall(__NR_io_uring_register, m_Descriptor, IORING_REGISTER_IOWQ_AFF, &set, sizeof(set));
+        }
+
+        // Queues a write of [data, data + length) at offset
+        bool PrepareWrite(int descriptor, const void* data, uint32_t length, uint64_t offset,
+                          uint64_t userData) noexcept
+        {
+            io_uring_sqe* sqe = NextSqe();
+            if (nullptr == sqe)
+            {
+                return false;
+            }
+
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = descriptor;
+            sqe->addr = reinterpret_cast<uint64_t>(data);
+            sqe->len = length;
+            sqe->off = offset;
+            sqe->user_data = userData;
+            Publish();
+            return true;
+        }
+
+        bool PrepareDataSync(int descriptor, uint64_t userData) noexcept
+        {
+            io_uring_sqe* sqe = NextSqe();
+            if (nullptr == sqe)
+            {
+                return false;
+            }
+
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = descriptor;
+            sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+            sqe->user_data = userData;
+            Publish();
+            return true;
+        }
+
+        // Hands every prepared operation to the kernel, optionally blocking
+        // until at least waitCount completions are available. Returns a
+        // negative errno on failure.
+        int Submit(uint32_t waitCount = 0) noexcept
+        {
+            for (;;)
+            {
+                const uint32_t flags = 0 < waitCount ? IORING_ENTER_GETEVENTS : 0;
+                const long result = ::syscall(__NR_io_uring_enter, m_Descriptor, m_Pending, waitCount,
+                                              flags, nullptr, 0);
+                if (0 <= result)
+                {
+                    m_Pending -= static_cast<uint32_t>(result);
+                    return static_cast<int>(result);
+                }
+                if (EINTR != errno)
+                {
+                    return -errno;
+                }
+            }
+        }
+
+        // Reaps one completion; false when none is ready
+        bool PopCompletion(uint64_t& userData, int32_t& result) noexcept
+        {
+            const uint32_t head = *m_CqHead;
+            if (head == std::atomic_ref<uint32_t>(*m_CqTail).load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            const io_uring_cqe& cqe = m_Cqes[head & m_CqMask];
+            userData = cqe.user_data;
+            result = cqe.res;
+            std::atomic_ref<uint32_t>(*m_CqHead).store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        void Close() noexcept
+        {
+            if (nullptr != m_Sqes)
+            {
+                ::munmap(m_Sqes, m_SqeSize);
+            }
+            if (nullptr != m_CqRing && m_CqRing != m_SqRing)
+            {
+                ::munmap(m_CqRing, m_CqRingSize);
+            }
+            if (nullptr != m_SqRing)
+            {
+                ::munmap(m_SqRing, m_SqRingSize);
+            }
+            if (0 <= m_Descriptor)
+            {
+                ::close(m_Descriptor);
+            }
+
+            m_Descriptor = -1;
+            m_SqRing = m_CqRing = nullptr;
+            m_Sqes = nullptr;
+            m_Pending = 0;
+        }
+
+    private:
+        void* Map(size_t size, off_t offset) const noexcept
+        {
+            void* address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                   m_Descriptor, offset);
+            return MAP_FAILED == address ? nullptr : address;
+        }
+
+        io_uring_sqe* NextSqe() noexcept
+        {
+            const uint32_t tail = *m_SqTail;
+            if (tail - std::atomic_ref<uint32_t>(*m_SqHead).load(std::memory_order_acquire) >= m_SqEntries)
+            {
+                return nullptr;
+            }
+
+            const uint32_t index = tail & m_SqMask;
+            io_uring_sqe* sqe = &m_Sqes[index];
+            std::memset(sqe, 0, sizeof(io_uring_sqe));
+            m_SqArray[index] = index;
+            return sqe;
+        }
+
+        // Makes the entry filled in after NextSqe visible to the kernel
+        void Publish() noexcept
+        {
+            std::atomic_ref<uint32_t>(*m_SqTail).store(*m_SqTail + 1, std::memory_order_release);
+            m_Pending++;
+        }
+
+    private:
+        int m_Descriptor{-1};
+        void* m_SqRing{nullptr};
+        void* m_CqRing{nullptr};
+        io_uring_sqe* m_Sqes{nullptr};
+        size_t m_SqRingSize{0};
+        size_t m_CqRingSize{0};
+        size_t m_SqeSize{0};
+
+        uint32_t* m_SqHead{nullptr};
+        uint32_t* m_SqTail{nullptr};
+        uint32_t* m_SqArray{nullptr};
+        uint32_t m_SqMask{0};
+        uint32_t m_SqEntries{0};
+        uint32_t m_Pending{0};              // prepared but not yet submitted
+
+        uint32_t* m_CqHead{nullptr};
+        uint32_t* m_CqTail{nullptr};
+        io_uring_cqe* m_Cqes{nullptr};
+        uint32_t m_CqMask{0};
+    };
+}
@@ -1,12 +1,19 @@
 #pragma once
 
 #include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_Enums.h"
 #include "FSHR_DERIBIT_ProtocolTraits.h"
 #include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_InternTable.h"
+#include "FSHR_DERIBIT_PageBuffer.h"
 
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <memory>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace fischer::deribit
 {
@@ -18,29 +25,81 @@ namespace fischer::deribit
         using MessageIdType = typename Traits::MessageIdType;
         using SizeType = typename Traits::SizeType;
 
-        JsonBuilder();
+        // Where a message's payload sits in the buffer when framing is enabled
+        struct MessageSpan
+        {
+            SizeType m_Offset;
+            SizeType m_Length;
+        };
+
+        explicit JsonBuilder(NumberFormat numberFormat = Traits::DefaultNumberFormat);
         RULE_OF_FIVE_MOVABLE(JsonBuilder);
 
         void Reset();
+
+        // Room for bytes more output before the buffer has to grow again;
+        // untouched capacity costs address space only
+        void Reserve(SizeType bytes) { EnsureCapacity(bytes); }
+
+        // Upper bound on the bytes BuildOrderMessage writes for order, header
+        // room included: every field at its longest plus the order's texts
+        // escaped at their longest
+        SizeType GetMessageSizeBound(const OrderType& order) const noexcept;
+
+        // The bounds of orders summed; reserved up front, building them never
+        // grows the buffer
+        SizeType MeasureOrders(std::span<const OrderType> orders) const noexcept;
+
         void BuildOrderMessage(const OrderType& order, MessageIdType messageId);
 
+        // A message's body is everything after its ID, so it depends on the
+        // order alone: a body taken from a message built at messageStart can
+        // be appended again later under another ID, with the same framing
+        void AppendMessage(MessageIdType messageId, std::string_view body);
+        std::string_view GetMessageBody(SizeType messageStart) const;
+
+        // Framing for a message transport: every message is preceded by
+        // headerReserve bytes for the caller to write a header into, no
+        // newline is appended, and the payload spans are recorded. The
+        // buffer is then no longer one contiguous output, so GetView and
+        // GetResult include the unused header room. 0 restores newline output.
+        void SetHeaderReserve(SizeType headerReserve) { m_HeaderReserve = headerReserve; }
+        const std::vector<MessageSpan>& GetMessages() const { return m_Messages; }
+        char* GetMutableData() { return m_Buffer.Get(); }
+
+        // Fragments the orders were interned into by the parser; orders with
+        // a fragment ID get the pre-rendered bytes copied in one piece
+        void SetFragments(const MessageFragments<Traits>* fragments) { m_Fragments = fragments; }
+
         std::string GetResult() const;
+        std::string_view GetView() const { return std::string_view(m_Buffer.Get(), m_Position); }
         SizeType GetBufferPosition() const { return m_Position; }
+        NumberFormat GetNumberFormat() const { return m_NumberFormat; }
 
     protected:
         void EnsureCapacity(SizeType needed);
         void AppendChar(char c);
         void AppendString(const char* str, SizeType length);
-        void AppendQuotedString(const std::string& str);
-        void AppendFieldName(const char* name, bool isFirst);
+        void AppendEscaped(std::string_view str);
+        void AppendQuotedString(std::string_view str);
+        template<size_t... Slots>
+        void AppendParams(const OrderType& order, std::index_sequence<Slots...>);
+        template<size_t Slot>
+        void AppendField(const OrderType& order, SizeType& skip);
         void AppendInt64(int64_t value);
         void AppendDouble(double value);
+        void AppendNumber(double value);
+        void AppendNumber(const Decimal& value);
         void AppendBoolean(bool value);
 
     private:
-        std::unique_ptr<char[]> m_Buffer;
+        PageBuffer m_Buffer;
         SizeType m_Capacity;
         SizeType m_Position;
+        SizeType m_HeaderReserve;
+        std::vector<MessageSpan> m_Messages;
+        const MessageFragments<Traits>* m_Fragments;
+        NumberFormat m_NumberFormat;
     };
 }
 
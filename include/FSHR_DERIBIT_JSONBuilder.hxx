@@ -1,19 +1,88 @@
 #include "FSHR_DERIBIT_JSONBuilder.h"
 #include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_FieldTable.h"
 #include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_NumberFormat.h"
+#include "FSHR_DERIBIT_Utils.h"
 
 #include <cstring>
 #include <cstdio>
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <numeric>
+#include <type_traits>
 
 namespace fischer::deribit
 {
+    // The cached instrument fragment must render exactly what the key
+    // fragment followed by a quoted value would
+    static_assert(InstrumentFragmentPrefix.substr(0, InstrumentFragmentPrefix.size() - 1) ==
+                  std::string_view(KeyFragments[static_cast<size_t>(FieldIndex::InstrumentName)].m_Text.data(),
+                                   KeyFragments[static_cast<size_t>(FieldIndex::InstrumentName)].m_Length));
+
+    // Longest rendering of each params field with its key and leading comma,
+    // by FieldIndex; texts count their quotes only, and envelope fields are
+    // not in params
     template<typename Traits>
-    JsonBuilder<Traits>::JsonBuilder()
+    constexpr std::array<uint32_t, FieldTable.size()> GetMaxFieldLengths() noexcept
+    {
+        constexpr uint32_t numberLength = std::is_same_v<typename Traits::AmountType, Decimal>
+                                              ? utils::MaxDecimalStringLength
+                                              : Traits::MaxDoubleStringLength;
+
+        std::array<uint32_t, FieldTable.size()> lengths{};
+        for (size_t slot = 0; slot < FieldTable.size(); ++slot)
+        {
+            const FieldDescriptor& field = FieldTable[slot];
+            if (FieldEmission::Envelope == field.m_Emission)
+            {
+                continue;
+            }
+
+            uint32_t length = KeyFragments[slot].m_Length;
+            switch (field.m_Encoding)
+            {
+                case FieldEncoding::Number:  length += numberLength; break;
+                case FieldEncoding::Text:
+                case FieldEncoding::Enum:    length += 2; break;
+                case FieldEncoding::Boolean: length += 5; break;
+                case FieldEncoding::Integer: length += Traits::MaxInt64StringLength; break;
+            }
+            lengths[static_cast<size_t>(field.m_Index)] = length;
+        }
+        return lengths;
+    }
+
+    // Fields written by value rather than presence, as Order::m_Presence bits
+    constexpr uint32_t GetWhenPositiveFields() noexcept
+    {
+        uint32_t fields = 0;
+        for (const FieldDescriptor& field : FieldTable)
+        {
+            if (FieldEmission::WhenPositive == field.m_Emission)
+            {
+                fields |= uint32_t{1} << static_cast<uint32_t>(field.m_Index);
+            }
+        }
+        return fields;
+    }
+
+    // Everything around the params with the longest ID; the method's
+    // direction is one of the order's texts
+    template<typename Traits>
+    constexpr size_t MaxEnvelopeLength = JsonPrefix.size() + Traits::MaxInt64StringLength + JsonRpcField.size() +
+                                         ParamsPrefix.size() + JsonSuffix.size() + NewLine.size();
+
+    template<typename Traits>
+    JsonBuilder<Traits>::JsonBuilder(NumberFormat numberFormat)
         : m_Capacity{Traits::InitialJsonBufferSize}
         , m_Position{0}
+        , m_HeaderReserve{0}
+        , m_Fragments{nullptr}
+        , m_NumberFormat{numberFormat}
     {
-        m_Buffer = std::make_unique<char[]>(m_Capacity);
+        m_Buffer = PageBuffer(m_Capacity);
         LOG_DEBUG("JsonBuilder initialized with buffer size:", m_Capacity);
     }
 
@@ -21,169 +90,124 @@ namespace fischer::deribit
     void JsonBuilder<Traits>::Reset()
     {
         m_Position = 0;
+        m_Messages.clear();
         LOG_DEBUG("JsonBuilder buffer reset");
     }
 
     template<typename Traits>
     void JsonBuilder<Traits>::BuildOrderMessage(const OrderType& order, MessageIdType messageId)
     {
-        EnsureCapacity(Traits::EstimatedMessageSize);
+        // Append* write unchecked, so the room for the whole message is made
+        // here; a fixed estimate would let long texts run past the buffer.
+        // Every field at its longest and every text escaped at six bytes a
+        // character bounds the message without looking up fragments, so the
+        // closer bound is only worked out near the end of the buffer.
+        constexpr std::array<uint32_t, FieldTable.size()> fieldLengths = GetMaxFieldLengths<Traits>();
+        constexpr SizeType maxFieldsLength = std::accumulate(fieldLengths.begin(), fieldLengths.end(), SizeType{0});
+        if (m_Position + MaxEnvelopeLength<Traits> + maxFieldsLength + m_HeaderReserve +
+            utils::MaxJsonEscapeLength * order.GetTextLength() > m_Capacity)
+        {
+            EnsureCapacity(GetMessageSizeBound(order));
+        }
+
+        // Room for a transport header, filled in by whoever sends the message
+        m_Position += m_HeaderReserve;
+        const SizeType messageStart = m_Position;
 
         // Start JSON message
         AppendString(JsonPrefix.data(), JsonPrefix.size());
         AppendInt64(messageId);
 
         // Add JSON-RPC method
-        AppendString(JsonRpcField.data(), JsonRpcField.size());
-        AppendString(order.m_Direction.c_str(), order.m_Direction.length());
-        AppendString(ParamsPrefix.data(), ParamsPrefix.size());
-
-        bool isFirst = true;
-
-        // Required fields
-        if (0.0 < order.m_Amount)
-        {
-            AppendFieldName(FieldAmount.data(), isFirst);
-            AppendDouble(order.m_Amount);
-            isFirst = false;
-        }
-
-        if (0.0 < order.m_Contracts)
-        {
-            AppendFieldName(FieldContracts.data(), isFirst);
-            AppendDouble(order.m_Contracts);
-            isFirst = false;
-        }
-
-        if (false == order.m_InstrumentName.empty())
+        if (nullptr != m_Fragments && InternTable<Traits>::NoId != order.m_MethodFragment)
         {
-            AppendFieldName(FieldInstrumentName.data(), isFirst);
-            AppendQuotedString(order.m_InstrumentName);
-            isFirst = false;
+            const std::string_view fragment = m_Fragments->m_Methods.GetFragment(order.m_MethodFragment);
+            AppendString(fragment.data(), fragment.size());
         }
-
-        if (false == order.m_Label.empty())
-        {
-            AppendFieldName(FieldLabel.data(), isFirst);
-            AppendQuotedString(order.m_Label);
-            isFirst = false;
-        }
-
-        if (false == order.m_Type.empty())
-        {
-            AppendFieldName(FieldType.data(), isFirst);
-            AppendQuotedString(order.m_Type);
-            isFirst = false;
-        }
-
-        // Optional fields using std::optional
-        if (order.m_Price.has_value())
-        {
-            AppendFieldName(FieldPrice.data(), isFirst);
-            AppendDouble(order.m_Price.value());
-            isFirst = false;
-        }
-
-        if (order.m_TimeInForce.has_value() && false == order.m_TimeInForce->empty())
-        {
-            AppendFieldName(TimeInForce.data(), isFirst);
-            AppendQuotedString(order.m_TimeInForce.value());
-            isFirst = false;
-        }
-
-        if (order.m_DisplayAmount.has_value())
+        else
         {
-            AppendFieldName(DisplayAmount.data(), isFirst);
-            AppendDouble(order.m_DisplayAmount.value());
-            isFirst = false;
+            const std::string_view direction = order.GetText(order.m_DirectionText);
+            AppendString(JsonRpcField.data(), JsonRpcField.size());
+            AppendEscaped(direction);
+            AppendString(ParamsPrefix.data(), ParamsPrefix.size());
         }
 
-        if (order.m_PostOnly.has_value())
-        {
-            AppendFieldName(PostOnly.data(), isFirst);
-            AppendBoolean(order.m_PostOnly.value());
-            isFirst = false;
-        }
+        // Params are emitted by a serializer expanded from FieldTable
+        AppendParams(order, std::make_index_sequence<FieldTable.size()>{});
 
-        if (order.m_RejectPostOnly.has_value())
-        {
-            AppendFieldName(RejectPostOnly.data(), isFirst);
-            AppendBoolean(order.m_RejectPostOnly.value());
-            isFirst = false;
-        }
+        // Close JSON message
+        AppendString(JsonSuffix.data(), JsonSuffix.size());
 
-        if (order.m_ReduceOnly.has_value())
+        if (0 == m_HeaderReserve)
         {
-            AppendFieldName(ReduceOnly.data(), isFirst);
-            AppendBoolean(order.m_ReduceOnly.value());
-            isFirst = false;
+            AppendString(NewLine.data(), NewLine.size());
         }
-
-        if (order.m_TriggerPrice.has_value())
+        else
         {
-            AppendFieldName(TriggerPrice.data(), isFirst);
-            AppendDouble(order.m_TriggerPrice.value());
-            isFirst = false;
+            m_Messages.push_back({messageStart, m_Position - messageStart});
         }
+    }
 
-        if (order.m_TriggerOffset.has_value())
+    template<typename Traits>
+    typename JsonBuilder<Traits>::SizeType JsonBuilder<Traits>::GetMessageSizeBound(const OrderType& order) const noexcept
+    {
+        constexpr std::array<uint32_t, FieldTable.size()> fieldLengths = GetMaxFieldLengths<Traits>();
+        constexpr uint32_t whenPositiveFields = GetWhenPositiveFields();
+
+        // Only fields the order may emit count; WhenPositive ones are counted
+        // whatever their value, which saves comparing it here. Texts count
+        // at their longest escape, which covers a fragment in their place too
+        SizeType bound = MaxEnvelopeLength<Traits> + m_HeaderReserve +
+                         utils::MaxJsonEscapeLength * order.GetTextLength();
+        for (uint32_t fields = order.m_Presence | whenPositiveFields; 0 != fields; fields &= fields - 1)
         {
-            AppendFieldName(TriggerOffset.data(), isFirst);
-            AppendDouble(order.m_TriggerOffset.value());
-            isFirst = false;
+            bound += fieldLengths[std::countr_zero(fields)];
         }
 
-        if (order.m_Trigger.has_value() && false == order.m_Trigger->empty())
-        {
-            AppendFieldName(Trigger.data(), isFirst);
-            AppendQuotedString(order.m_Trigger.value());
-            isFirst = false;
-        }
+        return bound;
+    }
 
-        if (order.m_Advanced.has_value() && false == order.m_Advanced->empty())
+    template<typename Traits>
+    typename JsonBuilder<Traits>::SizeType
+    JsonBuilder<Traits>::MeasureOrders(std::span<const OrderType> orders) const noexcept
+    {
+        SizeType total = 0;
+        for (const OrderType& order : orders)
         {
-            AppendFieldName(Advanced.data(), isFirst);
-            AppendQuotedString(order.m_Advanced.value());
-            isFirst = false;
+            total += GetMessageSizeBound(order);
         }
+        return total;
+    }
 
-        if (order.m_Mmp.has_value())
-        {
-            AppendFieldName(Mmp.data(), isFirst);
-            AppendBoolean(order.m_Mmp.value());
-            isFirst = false;
-        }
+    template<typename Traits>
+    void JsonBuilder<Traits>::AppendMessage(MessageIdType messageId, std::string_view body)
+    {
+        EnsureCapacity(JsonPrefix.size() + Traits::MaxInt64StringLength + body.size() + m_HeaderReserve);
 
-        if (order.m_ValidUntil.has_value())
-        {
-            AppendFieldName(ValidUntil.data(), isFirst);
-            AppendInt64(order.m_ValidUntil.value());
-            isFirst = false;
-        }
+        m_Position += m_HeaderReserve;
+        const SizeType messageStart = m_Position;
 
-        if (order.m_LinkedOrderType.has_value() && false == order.m_LinkedOrderType->empty())
-        {
-            AppendFieldName(LinkedOrderType.data(), isFirst);
-            AppendQuotedString(order.m_LinkedOrderType.value());
-            isFirst = false;
-        }
+        AppendString(JsonPrefix.data(), JsonPrefix.size());
+        AppendInt64(messageId);
+        AppendString(body.data(), body.size());
 
-        if (order.m_TriggerFillCondition.has_value() && false == order.m_TriggerFillCondition->empty())
+        if (0 != m_HeaderReserve)
         {
-            AppendFieldName(TriggerFillCondition.data(), isFirst);
-            AppendQuotedString(order.m_TriggerFillCondition.value());
-            isFirst = false;
+            m_Messages.push_back({messageStart, m_Position - messageStart});
         }
+    }
 
-        // Close JSON message
-        AppendString(JsonSuffix.data(), JsonSuffix.size());
-        AppendString(NewLine.data(), NewLine.size());
+    template<typename Traits>
+    std::string_view JsonBuilder<Traits>::GetMessageBody(SizeType messageStart) const
+    {
+        const std::string_view message(m_Buffer.Get() + messageStart, m_Position - messageStart);
+        return message.substr(message.find_first_not_of("-0123456789", JsonPrefix.size()));
     }
 
     template<typename Traits>
     std::string JsonBuilder<Traits>::GetResult() const
     {
-        return std::string(m_Buffer.get(), m_Position);
+        return std::string(m_Buffer.Get(), m_Position);
     }
 
     template<typename Traits>
@@ -191,10 +215,13 @@ namespace fischer::deribit
     {
         if (m_Position + needed > m_Capacity)
         {
-            m_Capacity *= Traits::BufferGrowthFactor;
+            while (m_Position + needed > m_Capacity)
+            {
+                m_Capacity *= Traits::BufferGrowthFactor;
+            }
 
-            auto newBuffer = std::make_unique<char[]>(m_Capacity);
-            std::memcpy(newBuffer.get(), m_Buffer.get(), m_Position);
+            PageBuffer newBuffer(m_Capacity);
+            std::memcpy(newBuffer.Get(), m_Buffer.Get(), m_Position);
 
             m_Buffer = std::move(newBuffer);
 
@@ -205,52 +232,135 @@ namespace fischer::deribit
     template<typename Traits>
     void JsonBuilder<Traits>::AppendChar(char c)
     {
-        m_Buffer[m_Position++] = c;
+        m_Buffer.Get()[m_Position++] = c;
     }
 
     template<typename Traits>
     void JsonBuilder<Traits>::AppendString(const char* str, SizeType length)
     {
-        std::memcpy(m_Buffer.get() + m_Position, str, length);
+        std::memcpy(m_Buffer.Get() + m_Position, str, length);
         m_Position += length;
     }
 
     template<typename Traits>
-    void JsonBuilder<Traits>::AppendQuotedString(const std::string& str)
+    void JsonBuilder<Traits>::AppendEscaped(std::string_view str)
+    {
+        m_Position += static_cast<SizeType>(utils::EscapeJsonString(m_Buffer.Get() + m_Position, str));
+    }
+
+    template<typename Traits>
+    void JsonBuilder<Traits>::AppendQuotedString(std::string_view str)
     {
         AppendChar('"');
-        AppendString(str.c_str(), str.length());
+        AppendEscaped(str);
         AppendChar('"');
     }
 
     template<typename Traits>
-    void JsonBuilder<Traits>::AppendFieldName(const char* name, bool isFirst)
+    template<size_t... Slots>
+    void JsonBuilder<Traits>::AppendParams(const OrderType& order, std::index_sequence<Slots...>)
+    {
+        // 1 until the first field is written, so its leading comma is skipped
+        // without a branch
+        SizeType skip = 1;
+        (AppendField<Slots>(order, skip), ...);
+    }
+
+    template<typename Traits>
+    template<size_t Slot>
+    void JsonBuilder<Traits>::AppendField(const OrderType& order, SizeType& skip)
     {
-        if (false == isFirst)
+        constexpr FieldDescriptor field = FieldTable[Slot];
+        constexpr KeyFragment key = KeyFragments[Slot];
+
+        if constexpr (FieldEmission::Envelope == field.m_Emission)
         {
-            AppendChar(',');
+            return;
+        }
+        else
+        {
+            if constexpr (FieldEmission::WhenPositive == field.m_Emission)
+            {
+                if (false == utils::IsPositive(order.template GetValue<field.m_Index>()))
+                {
+                    return;
+                }
+            }
+            else
+            {
+                if (false == order.Has(field.m_Index))
+                {
+                    return;
+                }
+            }
+
+            if constexpr (FieldIndex::InstrumentName == field.m_Index)
+            {
+                if (nullptr != m_Fragments && InternTable<Traits>::NoId != order.m_InstrumentFragment)
+                {
+                    const std::string_view fragment =
+                        m_Fragments->m_Instruments.GetFragment(order.m_InstrumentFragment);
+                    AppendString(fragment.data() + skip, fragment.size() - skip);
+                    skip = 0;
+                    return;
+                }
+            }
+
+            AppendString(key.m_Text.data() + skip, key.m_Length - skip);
+            skip = 0;
+
+            if constexpr (FieldEncoding::Number == field.m_Encoding)
+            {
+                AppendNumber(order.template GetValue<field.m_Index>());
+            }
+            else if constexpr (FieldEncoding::Text == field.m_Encoding ||
+                               FieldEncoding::Enum == field.m_Encoding)
+            {
+                AppendQuotedString(order.GetText(order.template GetValue<field.m_Index>()));
+            }
+            else if constexpr (FieldEncoding::Boolean == field.m_Encoding)
+            {
+                AppendBoolean(order.GetFlag(field.m_Index));
+            }
+            else
+            {
+                AppendInt64(order.template GetValue<field.m_Index>());
+            }
         }
-
-        AppendChar('"');
-        AppendString(name, std::strlen(name));
-        AppendChar('"');
-        AppendChar(':');
     }
 
     template<typename Traits>
     void JsonBuilder<Traits>::AppendInt64(int64_t value)
     {
-        m_Position += static_cast<SizeType>(
-            std::snprintf(m_Buffer.get() + m_Position,
-                         Traits::MaxInt64StringLength, "%ld", value));
+        if (NumberFormat::Printf == m_NumberFormat)
+        {
+            m_Position += static_cast<SizeType>(
+                std::snprintf(m_Buffer.Get() + m_Position,
+                             Traits::MaxInt64StringLength, "%ld", value));
+            return;
+        }
+
+        m_Position += static_cast<SizeType>(utils::FormatInt64(m_Buffer.Get() + m_Position, value));
     }
 
     template<typename Traits>
     void JsonBuilder<Traits>::AppendDouble(double value)
     {
         m_Position += static_cast<SizeType>(
-            std::snprintf(m_Buffer.get() + m_Position,
-                         Traits::MaxDoubleStringLength, "%.10g", value));
+            utils::FormatDouble(m_Buffer.Get() + m_Position, Traits::MaxDoubleStringLength,
+                                value, m_NumberFormat, Traits::DoublePrecision));
+    }
+
+    template<typename Traits>
+    void JsonBuilder<Traits>::AppendNumber(double value)
+    {
+        AppendDouble(value);
+    }
+
+    template<typename Traits>
+    void JsonBuilder<Traits>::AppendNumber(const Decimal& value)
+    {
+        m_Position += static_cast<SizeType>(utils::FormatDecimal(m_Buffer.Get() + m_Position, value));
     }
 
     template<typename Traits>
@@ -267,4 +377,5 @@ namespace fischer::deribit
     }
 
     template class JsonBuilder<DeribitTraits>;
+    template class JsonBuilder<DeribitFixedPointTraits>;
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // HDR-style log-linear histogram of raw tick counts. Values below
+    // 2^SubBucketBits get one bucket each; every power of two above that is
+    // split into 2^SubBucketBits equal buckets, so any recorded value is known
+    // to within 2^-SubBucketBits of itself across the whole 64-bit range.
+    // Recording is a bit_width, a shift and an increment.
+    template<typename Traits = DeribitTraits>
+    class LatencyHistogram
+    {
+    public:
+        static constexpr uint32_t SubBucketBits = Traits::LatencySubBucketBits;
+        static constexpr uint64_t SubBucketCount = uint64_t{1} << SubBucketBits;
+        static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+        static_assert(0 < SubBucketBits && SubBucketBits < 16, "Sub-bucket bits out of range");
+
+        LatencyHistogram()
+            : m_Counts(BucketCount, 0)
+            , m_TotalCount{0}
+            , m_Min{std::numeric_limits<uint64_t>::max()}
+            , m_Max{0}
+        {
+        }
+
+        void Record(uint64_t value) noexcept
+        {
+            m_Counts[GetBucketIndex(value)]++;
+            m_TotalCount++;
+            m_Min = std::min(m_Min, value);
+            m_Max = std::max(m_Max, value);
+        }
+
+        void Merge(const LatencyHistogram& other) noexcept
+        {
+            for (size_t index = 0; index < BucketCount; ++index)
+            {
+                m_Counts[index] += other.m_Counts[index];
+            }
+            m_TotalCount += other.m_TotalCount;
+            m_Min = std::min(m_Min, other.m_Min);
+            m_Max = std::max(m_Max, other.m_Max);
+        }
+
+        void Reset() noexcept
+        {
+            std::fill(m_Counts.begin(), m_Counts.end(), 0);
+            m_TotalCount = 0;
+            m_Min = std::numeric_limits<uint64_t>::max();
+            m_Max = 0;
+        }
+
+        uint64_t GetCount() const noexcept { return m_TotalCount; }
+        uint64_t GetMin() const noexcept { return 0 == m_TotalCount ? 0 : m_Min; }
+        uint64_t GetMax() const noexcept { return m_Max; }
+
+        // Smallest value v such that at least the given fraction of the
+        // recordings are <= v, reported as the upper edge of its bucket
+        uint64_t GetPercentile(double fraction) const noexcept
+        {
+            if (0 == m_TotalCount)
+            {
+                return 0;
+            }
+
+            const double clamped = std::clamp(fraction, 0.0, 1.0);
+            const uint64_t target = std::max<uint64_t>(
+                1, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(m_TotalCount))));
+
+            uint64_t seen = 0;
+            for (size_t index = 0; index < BucketCount; ++index)
+            {
+                seen += m_Counts[index];
+                if (seen >= target)
+                {
+                    return std::min(GetBucketUpper(index), m_Max);
+                }
+            }
+
+            return m_Max;
+        }
+
+        // {"count":N,"min_ns":..,"p50_ns":..,"p99_ns":..,"p999_ns":..,"max_ns":..,
+        //  "buckets":[[upper_ns,count],...]} with only non-empty buckets listed
+        void AppendJson(std::string& out, double nanosecondsPerTick) const
+        {
+            const auto AppendField = [&out](std::string_view name, uint64_t value)
+            {
+                char digits[24];
+                out.push_back('"');
+                out.append(name);
+                out.append("\":");
+                out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+                out.push_back(',');
+            };
+
+            const auto ToNanoseconds = [nanosecondsPerTick](uint64_t ticks)
+            {
+                return static_cast<uint64_t>(std::llround(static_cast<double>(ticks) * nanosecondsPerTick));
+            };
+
+            out.push_back('{');
+            AppendField("count", m_TotalCount);
+            AppendField("min_ns", ToNanoseconds(GetMin()));
+            AppendField("p50_ns", ToNanoseconds(GetPercentile(0.5)));
+            AppendField("p99_ns", ToNanoseconds(GetPercentile(0.99)));
+            AppendField("p999_ns", ToNanoseconds(GetPercentile(0.999)));
+            AppendField("max_ns", ToNanoseconds(m_Max));
+            out.append("\"buckets\":[");
+
+            bool isFirst = true;
+            for (size_t index = 0; index < BucketCount; ++index)
+            {
+                if (0 == m_Counts[index])
+                {
+                    continue;
+                }
+
+                char digits[24];
+                out.append(true == isFirst ? "[" : ",[");
+                out.append(digits, std::to_chars(digits, digits + sizeof(digits),
+                                                 ToNanoseconds(GetBucketUpper(index))).ptr);
+                out.push_back(',');
+                out.append(digits, std::to_chars(digits, digits + sizeof(digits), m_Counts[index]).ptr);
+                out.push_back(']');
+                isFirst = false;
+            }
+
+            out.append("]}");
+        }
+
+        static constexpr size_t GetBucketIndex(uint64_t value) noexcept
+        {
+            if (value < SubBucketCount)
+            {
+                return static_cast<size_t>(value);
+            }
+
+            const uint32_t shift = static_cast<uint32_t>(std::bit_width(value)) - 1 - SubBucketBits;
+            const uint64_t subBucket = (value >> shift) - SubBucketCount;
+            return static_cast<size_t>((shift + 1) * SubBucketCount + subBucket);
+        }
+
+        static constexpr uint64_t GetBucketUpper(size_t index) noexcept
+        {
+            if (index < SubBucketCount)
+            {
+                return index;
+            }
+
+            const uint64_t shift = index / SubBucketCount - 1;
+            const uint64_t lower = (SubBucketCount + index % SubBucketCount) << shift;
+            return lower + ((uint64_t{1} << shift) - 1);
+        }
+
+    private:
+        std::vector<uint64_t> m_Counts;
+        uint64_t m_TotalCount;
+        uint64_t m_Min;
+        uint64_t m_Max;
+    };
+
+    static_assert(LatencyHistogram<>::GetBucketIndex(std::numeric_limits<uint64_t>::max()) ==
+                  LatencyHistogram<>::BucketCount - 1, "Largest value must land in the last bucket");
+    static_assert(LatencyHistogram<>::GetBucketUpper(LatencyHistogram<>::BucketCount - 1) ==
+                  std::numeric_limits<uint64_t>::max(), "Bucket bounds must cover the 64-bit range");
+}
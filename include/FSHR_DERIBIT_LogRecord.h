@@ -0,0 +1,257 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace fischer::deribit
+{
+    enum class LogArgumentKind : uint8_t
+    {
+        Signed = 0,
+        Unsigned = 1,
+        Floating = 2,
+        Boolean = 3,
+        Text = 4
+    };
+
+    // Precision std::ostream uses for doubles unless told otherwise
+    constexpr int DefaultLogStreamPrecision = 6;
+
+    // Renders one argument as the ostream-based logger did (integers in
+    // decimal, doubles as %g, booleans as 1/0)
+    template<typename T>
+    void AppendLogArgument(std::string& out, const T& value)
+    {
+        char digits[32];
+
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            out.push_back(true == value ? '1' : '0');
+        }
+        else if constexpr (std::is_same_v<T, char>)
+        {
+            out.push_back(value);
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            out.append(digits, std::to_chars(digits, digits + sizeof(digits), static_cast<int64_t>(value)).ptr);
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            out.append(digits, std::to_chars(digits, digits + sizeof(digits), static_cast<uint64_t>(value)).ptr);
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            out.append(digits, std::to_chars(digits, digits + sizeof(digits), static_cast<double>(value),
+                                             std::chars_format::general, DefaultLogStreamPrecision).ptr);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+        {
+            out.append(std::string_view(value));
+        }
+        else
+        {
+            // Rare argument types are still rendered by their operator<<
+            std::ostringstream stream;
+            stream << value;
+            out.append(stream.str());
+        }
+    }
+
+    // The arguments separated by single spaces, formatted on the spot
+    template<typename First, typename... Rest>
+    void AppendLogArguments(std::string& out, const First& first, const Rest&... rest)
+    {
+        AppendLogArgument(out, first);
+        ((out.push_back(' '), AppendLogArgument(out, rest)), ...);
+    }
+
+    // One log call captured as raw, typed arguments: the calling thread only
+    // copies scalars and text bytes, and all formatting happens on whichever
+    // thread later calls AppendArguments. A call whose arguments do not fit
+    // the payload is formatted on the calling thread into a heap spill
+    // instead, which the reader frees with ReleaseSpill.
+    template<size_t RecordSize>
+    struct alignas(64) LogRecord
+    {
+        static constexpr size_t HeaderSize = sizeof(int64_t) + sizeof(std::string*) + sizeof(uint32_t);
+        static constexpr size_t PayloadCapacity = RecordSize - HeaderSize;
+
+        static_assert(RecordSize > HeaderSize + 16, "Log record too small for any argument");
+        static_assert(PayloadCapacity <= UINT16_MAX, "Payload size must fit in 16 bits");
+
+        int64_t m_Timestamp{0};                 // steady_clock nanoseconds
+        std::string* m_Spill{nullptr};          // the formatted arguments when they overflowed the payload
+        LogLevel m_Level{LogLevel::Info};
+        bool m_Overflowed{false};
+        uint16_t m_PayloadSize{0};
+        std::array<char, PayloadCapacity> m_Payload{};
+
+        template<typename... Args>
+        void Capture(LogLevel level, int64_t timestamp, const Args&... args)
+        {
+            m_Timestamp = timestamp;
+            m_Spill = nullptr;
+            m_Level = level;
+            m_Overflowed = false;
+            m_PayloadSize = 0;
+            (AppendArgument(args), ...);
+
+            if (true == m_Overflowed) [[unlikely]]
+            {
+                m_Spill = new std::string();
+                AppendLogArguments(*m_Spill, args...);
+                m_PayloadSize = 0;
+            }
+        }
+
+        void ReleaseSpill() noexcept
+        {
+            delete m_Spill;
+            m_Spill = nullptr;
+        }
+
+        // Renders the arguments separated by single spaces, as
+        // AppendLogArguments would have
+        void AppendArguments(std::string& out) const
+        {
+            if (nullptr != m_Spill) [[unlikely]]
+            {
+                out.append(*m_Spill);
+                return;
+            }
+
+            size_t position = 0;
+            bool isFirst = true;
+
+            while (position < m_PayloadSize)
+            {
+                if (false == isFirst)
+                {
+                    out.push_back(' ');
+                }
+                isFirst = false;
+
+                const auto kind = static_cast<LogArgumentKind>(m_Payload[position++]);
+                char digits[32];
+
+                switch (kind)
+                {
+                case LogArgumentKind::Signed:
+                    out.append(digits, std::to_chars(digits, digits + sizeof(digits),
+                                                     ReadScalar<int64_t>(position)).ptr);
+                    break;
+
+                case LogArgumentKind::Unsigned:
+                    out.append(digits, std::to_chars(digits, digits + sizeof(digits),
+                                                     ReadScalar<uint64_t>(position)).ptr);
+                    break;
+
+                case LogArgumentKind::Floating:
+                    out.append(digits, std::to_chars(digits, digits + sizeof(digits),
+                                                     ReadScalar<double>(position),
+                                                     std::chars_format::general, DefaultLogStreamPrecision).ptr);
+                    break;
+
+                case LogArgumentKind::Boolean:
+                    out.push_back(0 != ReadScalar<uint8_t>(position) ? '1' : '0');
+                    break;
+
+                case LogArgumentKind::Text:
+                {
+                    const uint16_t length = ReadScalar<uint16_t>(position);
+                    out.append(m_Payload.data() + position, length);
+                    position += length;
+                    break;
+                }
+                }
+            }
+        }
+
+    private:
+        template<typename T>
+        void AppendArgument(const T& value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                AppendScalar(LogArgumentKind::Boolean, static_cast<uint8_t>(value));
+            }
+            else if constexpr (std::is_same_v<T, char>)
+            {
+                AppendText(std::string_view(&value, 1));
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                AppendScalar(LogArgumentKind::Signed, static_cast<int64_t>(value));
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                AppendScalar(LogArgumentKind::Unsigned, static_cast<uint64_t>(value));
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                AppendScalar(LogArgumentKind::Floating, static_cast<double>(value));
+            }
+            else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            {
+                AppendText(std::string_view(value));
+            }
+            else
+            {
+                // Rare argument types are still rendered by their operator<<
+                std::ostringstream stream;
+                stream << value;
+                AppendText(stream.str());
+            }
+        }
+
+        template<typename T>
+        void AppendScalar(LogArgumentKind kind, T value) noexcept
+        {
+            if (true == m_Overflowed || 1 + sizeof(T) > PayloadCapacity - m_PayloadSize)
+            {
+                m_Overflowed = true;
+                return;
+            }
+
+            m_Payload[m_PayloadSize++] = static_cast<char>(kind);
+            std::memcpy(m_Payload.data() + m_PayloadSize, &value, sizeof(T));
+            m_PayloadSize = static_cast<uint16_t>(m_PayloadSize + sizeof(T));
+        }
+
+        void AppendText(std::string_view text) noexcept
+        {
+            constexpr size_t TextHeaderSize = 1 + sizeof(uint16_t);
+            if (true == m_Overflowed || TextHeaderSize + text.size() > PayloadCapacity - m_PayloadSize)
+            {
+                m_Overflowed = true;
+                return;
+            }
+
+            const auto length = static_cast<uint16_t>(text.size());
+
+            m_Payload[m_PayloadSize++] = static_cast<char>(LogArgumentKind::Text);
+            std::memcpy(m_Payload.data() + m_PayloadSize, &length, sizeof(length));
+            std::memcpy(m_Payload.data() + m_PayloadSize + sizeof(length), text.data(), length);
+            m_PayloadSize = static_cast<uint16_t>(m_PayloadSize + sizeof(length) + length);
+        }
+
+        template<typename T>
+        T ReadScalar(size_t& position) const noexcept
+        {
+            T value;
+            std::memcpy(&value, m_Payload.data() + position, sizeof(T));
+            position += sizeof(T);
+            return value;
+        }
+    };
+}
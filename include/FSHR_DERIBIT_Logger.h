@@ -1,9 +1,12 @@
 #pragma once
 
 #include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_Constants.h"
 #include "FSHR_DERIBIT_Utils.h"
 #include "FSHR_DERIBIT_Macro.h"
 #include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_LogRecord.h"
+#include "FSHR_DERIBIT_SpscRing.h"
 
 #include <string>
 #include <fstream>
@@ -11,16 +14,29 @@
 #include <atomic>
 #include <chrono>
 #include <memory>
-#include <sstream>
-#include <iomanip>
-#include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
 
 namespace fischer::deribit
 {
+    // Synchronous mode formats and writes on the calling thread under a mutex.
+    // Asynchronous mode only captures a steady_clock timestamp and the raw
+    // arguments into a per-thread lock-free ring; a background thread merges
+    // the rings in timestamp order, formats them and writes them in batches.
+    // A message too long for a ring record is formatted by the caller into a
+    // heap spill the record points to, so no mode cuts a message short.
     template<typename Traits = DeribitTraits>
     class Logger
     {
     public:
+        using RecordType = LogRecord<Traits::AsyncLogRecordSize>;
+
+        // Levels below this are removed by the LOG_* macros at compile time
+        static constexpr LogLevel CompiledLogLevel = Traits::MinCompiledLogLevel;
+
         RULE_OF_FIVE_NONMOVABLE(Logger);
 
         static Logger& GetInstance()
@@ -32,8 +48,11 @@ namespace fischer::deribit
         void Initialize(const std::string& logFile = "",
                        LogLevel minLevel = LogLevel::Info,
                        bool enableConsole = true,
-                       bool enableFile = true)
+                       bool enableFile = true,
+                       bool asynchronous = Traits::EnableAsyncLogging)
         {
+            StopBackend();
+
             std::lock_guard<std::mutex> lock(m_Mutex);
 
             m_MinLogLevel = minLevel;
@@ -49,10 +68,19 @@ namespace fischer::deribit
                 m_FileStream.open(logFile, std::ios::out | std::ios::app);
                 m_LogFilePath = logFile;
             }
+
+            if (true == asynchronous)
+            {
+                m_Backend = std::jthread([this](std::stop_token stopToken) { RunBackend(stopToken); });
+                m_Asynchronous.store(true, std::memory_order_release);
+            }
         }
 
+        // Drains every pending asynchronous message before closing the file
         void Shutdown()
         {
+            StopBackend();
+
             std::lock_guard<std::mutex> lock(m_Mutex);
             if (true == m_FileStream.is_open())
             {
@@ -111,62 +139,279 @@ namespace fischer::deribit
             m_EnableFile.store(enable);
         }
 
+        bool IsAsynchronous() const
+        {
+            return m_Asynchronous.load(std::memory_order_acquire);
+        }
+
     private:
+        using RingType = SpscRing<RecordType, Traits::AsyncLogRingCapacity>;
+
+        struct ThreadRing
+        {
+            RingType m_Ring;
+            std::atomic<bool> m_Retired{false};
+        };
+
+        // Marks the calling thread's ring retired when the thread exits; the
+        // backend frees it once drained
+        struct ThreadRingHandle
+        {
+            ThreadRing* m_ThreadRing{nullptr};
+
+            ~ThreadRingHandle()
+            {
+                if (nullptr != m_ThreadRing)
+                {
+                    m_ThreadRing->m_Retired.store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        struct ProducerScope
+        {
+            std::atomic<uint32_t>& m_Count;
+
+            explicit ProducerScope(std::atomic<uint32_t>& count) : m_Count{count} { m_Count.fetch_add(1); }
+            ~ProducerScope() { m_Count.fetch_sub(1, std::memory_order_release); }
+        };
+
         // Private constructor for singleton
         Logger()
             : m_MinLogLevel{LogLevel::Info}
             , m_EnableConsole{Traits::EnableConsoleLogging}
             , m_EnableFile{Traits::EnableFileLogging}
+            , m_Asynchronous{false}
+            , m_DroppedCount{0}
+            , m_Producers{0}
+            , m_SteadyOrigin{std::chrono::steady_clock::now()}
+            , m_SystemOrigin{std::chrono::system_clock::now()}
+            , m_CachedSecond{-1}
         {
         }
 
         template<typename... Args>
         void Log(LogLevel level, const Args&... args)
         {
-            if (level < m_MinLogLevel.load())
+            if (level < m_MinLogLevel.load(std::memory_order_relaxed))
             {
                 return;
             }
 
-            std::ostringstream oss;
-            oss.str().reserve(Traits::MaxLogMessageLength);
+            const int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
 
-            auto now = std::chrono::system_clock::now();
-            auto time_t = std::chrono::system_clock::to_time_t(now);
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                now.time_since_epoch()) % 1000;
-
-            oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-            oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+            {
+                // Counted before the mode is read, so StopBackend can wait out
+                // a producer that saw it asynchronous and has not published yet
+                const ProducerScope producer(m_Producers);
+                if (true == m_Asynchronous.load())
+                {
+                    RingType& ring = GetThreadRing().m_Ring;
+                    RecordType* record = ring.TryAcquire();
+                    if (nullptr == record)
+                    {
+                        // Never block the caller; the loss is reported by the backend
+                        m_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
 
-            oss << " [" << utils::LogLevelToString(level) << "] ";
+                    record->Capture(level, timestamp, args...);
+                    ring.Publish();
+                    return;
+                }
+            }
 
-            ((oss << args << ' '), ...);
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Batch.clear();
+            FormatPrefix(level, timestamp, m_Batch);
+            AppendLogArguments(m_Batch, args...);
+            m_Batch.push_back('\n');
+            WriteBatch(m_Batch, LogLevel::Error <= level);
+        }
 
-            std::string message = oss.str();
+        ThreadRing& GetThreadRing()
+        {
+            thread_local ThreadRingHandle handle;
 
-            if (false == message.empty() && ' ' == message.back())
+            if (nullptr == handle.m_ThreadRing)
             {
-                message.pop_back();
+                auto threadRing = std::make_unique<ThreadRing>();
+                handle.m_ThreadRing = threadRing.get();
+
+                std::lock_guard<std::mutex> lock(m_RingsMutex);
+                m_Rings.push_back(std::move(threadRing));
             }
 
-            std::lock_guard<std::mutex> lock(m_Mutex);
+            return *handle.m_ThreadRing;
+        }
 
-            if (true == m_EnableConsole.load())
+        void RunBackend(std::stop_token stopToken)
+        {
+            const auto pollInterval = std::chrono::microseconds(Traits::AsyncLogPollMicroseconds);
+
+            while (false == stopToken.stop_requested())
             {
-                if (LogLevel::Error == level || LogLevel::Critical == level)
+                if (0 == Drain())
                 {
-                    std::cerr << message << std::endl;
+                    std::this_thread::sleep_for(pollInterval);
                 }
-                else
+            }
+
+            // Final pass for everything logged before the stop request
+            Drain();
+        }
+
+        // Producers arriving after the mode flips log synchronously; those
+        // already in the ring path are waited for, so the backend's final
+        // Drain sees what they publish
+        void StopBackend()
+        {
+            m_Asynchronous.store(false);
+            while (0 != m_Producers.load())
+            {
+                std::this_thread::yield();
+            }
+
+            if (true == m_Backend.joinable())
+            {
+                m_Backend.request_stop();
+                m_Backend.join();
+            }
+        }
+
+        // Moves every published record out of the rings, orders them by
+        // timestamp and writes them with one call per stream. Returns the
+        // number of records written.
+        size_t Drain()
+        {
+            m_Pending.clear();
+
+            {
+                std::lock_guard<std::mutex> lock(m_RingsMutex);
+
+                for (auto& threadRing : m_Rings)
                 {
-                    std::cout << message << std::endl;
+                    RingType& ring = threadRing->m_Ring;
+                    for (const RecordType* record = ring.Front(); nullptr != record; record = ring.Front())
+                    {
+                        m_Pending.push_back(*record);
+                        ring.Pop();
+                    }
                 }
+
+                std::erase_if(m_Rings, [](const std::unique_ptr<ThreadRing>& threadRing)
+                {
+                    return true == threadRing->m_Retired.load(std::memory_order_acquire) &&
+                           true == threadRing->m_Ring.IsEmpty();
+                });
+            }
+
+            const uint64_t dropped = m_DroppedCount.exchange(0, std::memory_order_relaxed);
+            if (true == m_Pending.empty() && 0 == dropped)
+            {
+                return 0;
+            }
+
+            // Sort pointers rather than the records: std::stable_sort's scratch
+            // buffer ignores the records' 64-byte alignment
+            m_PendingOrder.clear();
+            for (const RecordType& record : m_Pending)
+            {
+                m_PendingOrder.push_back(&record);
+            }
+
+            std::stable_sort(m_PendingOrder.begin(), m_PendingOrder.end(),
+                             [](const RecordType* left, const RecordType* right)
+            {
+                return left->m_Timestamp < right->m_Timestamp;
+            });
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            m_Batch.clear();
+            m_ErrorBatch.clear();
+
+            for (const RecordType* record : m_PendingOrder)
+            {
+                FormatRecord(*record, LogLevel::Error <= record->m_Level ? m_ErrorBatch : m_Batch);
+            }
+
+            if (0 != dropped)
+            {
+                RecordType notice;
+                notice.Capture(LogLevel::Warning, m_PendingOrder.empty() ? 0 : m_PendingOrder.back()->m_Timestamp,
+                               "Logger dropped", dropped, "messages: ring full");
+                FormatRecord(notice, m_Batch);
+            }
+
+            WriteBatch(m_Batch, false);
+            WriteBatch(m_ErrorBatch, true);
+
+            for (RecordType& record : m_Pending)
+            {
+                record.ReleaseSpill();
+            }
+            return m_Pending.size() + (0 != dropped ? 1 : 0);
+        }
+
+        // "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] args\n"
+        void FormatRecord(const RecordType& record, std::string& out)
+        {
+            FormatPrefix(record.m_Level, record.m_Timestamp, out);
+            record.AppendArguments(out);
+            out.push_back('\n');
+        }
+
+        // "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] "; the calendar part is recomputed
+        // with localtime_r only when the second changes
+        void FormatPrefix(LogLevel level, int64_t timestamp, std::string& out)
+        {
+            const auto wallTime = m_SystemOrigin + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(timestamp) - m_SteadyOrigin.time_since_epoch());
+            const auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(
+                wallTime.time_since_epoch()).count();
+            const std::time_t second = static_cast<std::time_t>(milliseconds / 1000);
+
+            if (second != m_CachedSecond)
+            {
+                std::tm calendar{};
+                localtime_r(&second, &calendar);
+                m_CachedSecondLength = std::strftime(m_CachedSecondText, sizeof(m_CachedSecondText),
+                                                     TimestampFormat.data(), &calendar);
+                m_CachedSecond = second;
+            }
+
+            const int millisecond = static_cast<int>(milliseconds % 1000);
+
+            out.append(m_CachedSecondText, m_CachedSecondLength);
+            out.push_back('.');
+            out.push_back(static_cast<char>('0' + millisecond / 100));
+            out.push_back(static_cast<char>('0' + millisecond / 10 % 10));
+            out.push_back(static_cast<char>('0' + millisecond % 10));
+            out.append(" [");
+            out.append(utils::LogLevelToString(level));
+            out.append("] ");
+        }
+
+        // Caller holds m_Mutex
+        void WriteBatch(const std::string& batch, bool isError)
+        {
+            if (true == batch.empty())
+            {
+                return;
+            }
+
+            if (true == m_EnableConsole.load())
+            {
+                std::FILE* console = true == isError ? stderr : stdout;
+                std::fwrite(batch.data(), 1, batch.size(), console);
+                std::fflush(console);
             }
 
             if (true == m_EnableFile.load() && true == m_FileStream.is_open())
             {
-                m_FileStream << message << std::endl;
+                m_FileStream.write(batch.data(), static_cast<std::streamsize>(batch.size()));
                 m_FileStream.flush();
             }
         }
@@ -178,12 +423,43 @@ namespace fischer::deribit
         std::atomic<LogLevel> m_MinLogLevel;
         std::atomic<bool> m_EnableConsole;
         std::atomic<bool> m_EnableFile;
+        std::atomic<bool> m_Asynchronous;
+        std::atomic<uint64_t> m_DroppedCount;
+        std::atomic<uint32_t> m_Producers;      // Log calls between counting in and publishing
+
+        // Wall-clock anchor for the steady_clock timestamps in the records
+        std::chrono::steady_clock::time_point m_SteadyOrigin;
+        std::chrono::system_clock::time_point m_SystemOrigin;
+        std::time_t m_CachedSecond;
+        char m_CachedSecondText[TimestampBufferSize]{};
+        size_t m_CachedSecondLength{0};
+
+        std::mutex m_RingsMutex;
+        std::vector<std::unique_ptr<ThreadRing>> m_Rings;
+        std::vector<RecordType> m_Pending;
+        std::vector<const RecordType*> m_PendingOrder;
+        std::string m_Batch;
+        std::string m_ErrorBatch;
+
+        // Declared last so it is joined before anything it uses is destroyed
+        std::jthread m_Backend;
     };
 
+    // Levels below Logger<>::CompiledLogLevel compile to nothing: the
+    // arguments are never evaluated
+    #define FSHR_DERIBIT_LOG(LEVEL, METHOD, ...)                                            \
+        do                                                                                  \
+        {                                                                                   \
+            if constexpr (LEVEL >= fischer::deribit::Logger<>::CompiledLogLevel)            \
+            {                                                                               \
+                fischer::deribit::Logger<>::GetInstance().METHOD(__VA_ARGS__);              \
+            }                                                                               \
+        } while (false)
+
     // May move to Macro.h, unsure
-    #define LOG_DEBUG(...)   fischer::deribit::Logger<>::GetInstance().Debug(__VA_ARGS__)
-    #define LOG_INFO(...)    fischer::deribit::Logger<>::GetInstance().Info(__VA_ARGS__)
-    #define LOG_WARNING(...) fischer::deribit::Logger<>::GetInstance().Warning(__VA_ARGS__)
-    #define LOG_ERROR(...)   fischer::deribit::Logger<>::GetInstance().Error(__VA_ARGS__)
-    #define LOG_CRITICAL(...) fischer::deribit::Logger<>::GetInstance().Critical(__VA_ARGS__)
+    #define LOG_DEBUG(...)    FSHR_DERIBIT_LOG(fischer::deribit::LogLevel::Debug, Debug, __VA_ARGS__)
+    #define LOG_INFO(...)     FSHR_DERIBIT_LOG(fischer::deribit::LogLevel::Info, Info, __VA_ARGS__)
+    #define LOG_WARNING(...)  FSHR_DERIBIT_LOG(fischer::deribit::LogLevel::Warning, Warning, __VA_ARGS__)
+    #define LOG_ERROR(...)    FSHR_DERIBIT_LOG(fischer::deribit::LogLevel::Error, Error, __VA_ARGS__)
+    #define LOG_CRITICAL(...) FSHR_DERIBIT_LOG(fischer::deribit::LogLevel::Critical, Critical, __VA_ARGS__)
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fischer::deribit
+{
+    // Read-only memory mapping of a whole file. The mapped bytes are parsed in
+    // place, so the file is never copied into a heap buffer.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept
+            : m_Address{std::exchange(other.m_Address, nullptr)}
+            , m_Size{std::exchange(other.m_Size, 0)}
+            , m_ReleasedSize{std::exchange(other.m_ReleasedSize, 0)}
+        {
+        }
+
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Close();
+                m_Address = std::exchange(other.m_Address, nullptr);
+                m_Size = std::exchange(other.m_Size, 0);
+                m_ReleasedSize = std::exchange(other.m_ReleasedSize, 0);
+            }
+            return *this;
+        }
+
+        ~MappedFile() noexcept
+        {
+            Close();
+        }
+
+        // Returns false if the file cannot be opened or mapped. Empty files
+        // cannot be mapped either; callers fall back to a regular read.
+        bool Open(const std::string& filename)
+        {
+            Close();
+
+            const int descriptor = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if (0 > descriptor)
+            {
+                return false;
+            }
+
+            struct stat fileStat{};
+            if (0 != ::fstat(descriptor, &fileStat) || 0 >= fileStat.st_size)
+            {
+                ::close(descriptor);
+                return false;
+            }
+
+            const size_t size = static_cast<size_t>(fileStat.st_size);
+            void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            ::close(descriptor);
+
+            if (MAP_FAILED == address)
+            {
+                return false;
+            }
+
+            // Advice only - failures are harmless
+            ::madvise(address, size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+            ::madvise(address, size, MADV_HUGEPAGE);
+#endif
+
+            m_Address = address;
+            m_Size = size;
+            return true;
+        }
+
+        void Close() noexcept
+        {
+            if (nullptr != m_Address)
+            {
+                ::munmap(m_Address, m_Size);
+                m_Address = nullptr;
+                m_Size = 0;
+                m_ReleasedSize = 0;
+            }
+        }
+
+        // Drops the resident pages that lie entirely before offset. The mapping
+        // stays valid: touching a released page reads it back from the file.
+        void ReleaseBefore(size_t offset) noexcept
+        {
+            const size_t pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            const size_t releaseEnd = std::min(offset, m_Size) / pageSize * pageSize;
+
+            if (nullptr != m_Address && releaseEnd > m_ReleasedSize)
+            {
+                ::madvise(static_cast<char*>(m_Address) + m_ReleasedSize,
+                          releaseEnd - m_ReleasedSize, MADV_DONTNEED);
+                m_ReleasedSize = releaseEnd;
+            }
+        }
+
+        bool IsOpen() const { return nullptr != m_Address; }
+        const char* GetData() const { return static_cast<const char*>(m_Address); }
+        size_t GetSize() const { return m_Size; }
+
+    private:
+        void* m_Address{nullptr};
+        size_t m_Size{0};
+        size_t m_ReleasedSize{0};
+    };
+}
\ No newline at end of file
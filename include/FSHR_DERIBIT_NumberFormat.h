@@ -0,0 +1,91 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace fischer::deribit::utils
+{
+    constexpr size_t MaxUInt64Digits = 20;
+
+    // "00", "01", ..., "99": integers are rendered two digits per division
+    inline constexpr std::array<char, 200> DigitPairs = []()
+    {
+        std::array<char, 200> table{};
+        for (size_t i = 0; i < 100; ++i)
+        {
+            table[i * 2] = static_cast<char>('0' + i / 10);
+            table[i * 2 + 1] = static_cast<char>('0' + i % 10);
+        }
+        return table;
+    }();
+
+    inline size_t FormatUInt64(char* out, uint64_t value) noexcept
+    {
+        char digits[MaxUInt64Digits];
+        char* const end = digits + MaxUInt64Digits;
+        char* current = end;
+
+        while (100 <= value)
+        {
+            const size_t pair = static_cast<size_t>(value % 100) * 2;
+            value /= 100;
+            current -= 2;
+            std::memcpy(current, &DigitPairs[pair], 2);
+        }
+
+        if (10 <= value)
+        {
+            current -= 2;
+            std::memcpy(current, &DigitPairs[static_cast<size_t>(value) * 2], 2);
+        }
+        else
+        {
+            *--current = static_cast<char>('0' + value);
+        }
+
+        const size_t length = static_cast<size_t>(end - current);
+        std::memcpy(out, current, length);
+        return length;
+    }
+
+    // Same output as printf("%ld")
+    inline size_t FormatInt64(char* out, int64_t value) noexcept
+    {
+        if (0 > value)
+        {
+            *out = '-';
+            return 1 + FormatUInt64(out + 1, 0 - static_cast<uint64_t>(value));
+        }
+
+        return FormatUInt64(out, static_cast<uint64_t>(value));
+    }
+
+    // Renders value into [out, out + capacity) and returns the length.
+    // Compatible is byte-identical to printf("%.<precision>g") - std::to_chars
+    // with an explicit precision is specified to match printf in the C locale -
+    // but skips format-string parsing and locale lookups. Shortest emits the
+    // shortest text that round-trips to the same double.
+    inline size_t FormatDouble(char* out, size_t capacity, double value,
+                               NumberFormat format, int precision) noexcept
+    {
+        switch (format)
+        {
+        case NumberFormat::Printf:
+            return static_cast<size_t>(std::snprintf(out, capacity, "%.*g", precision, value));
+
+        case NumberFormat::Shortest:
+            return static_cast<size_t>(std::to_chars(out, out + capacity, value).ptr - out);
+
+        case NumberFormat::Compatible:
+        default:
+            return static_cast<size_t>(std::to_chars(out, out + capacity, value,
+                                                     std::chars_format::general, precision).ptr - out);
+        }
+    }
+}
\ No newline at end of file
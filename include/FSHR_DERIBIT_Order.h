@@ -1,14 +1,46 @@
 #pragma once
 
 #include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_Enums.h"
 #include "FSHR_DERIBIT_ProtocolTraits.h"
 
-#include <string>
-#include <optional>
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 namespace fischer::deribit
 {
+    // Slice of the order's source row: offset and length relative to
+    // Order::m_Source, so text fields never own or copy any bytes
+    struct TextRef
+    {
+        uint16_t m_Offset{0};
+        uint16_t m_Length{0};
+    };
+
+    constexpr size_t MaxTextRefOffset = std::numeric_limits<uint16_t>::max();
+
+    // Text fields of a row too long for 16-bit TextRefs, kept out of line by
+    // the parser that read the row. An order using one points m_Source here
+    // instead of at the row, and each TextRef's offset is a slot; slot 0 is
+    // the empty text of a field the row left out.
+    template<typename Traits = DeribitTraits>
+    struct LongRowTexts
+    {
+        const char* m_Row{nullptr};
+        size_t m_TextLength{0};
+        size_t m_Count{1};
+        std::array<std::string_view, Traits::MaxFieldCount + 1> m_Texts{};
+    };
+
+    // Fixed-size order record backed by the loaded input buffer. The buffer must
+    // outlive the order. Optional fields are tracked in m_Presence, one bit per
+    // FieldIndex, instead of std::optional.
     template<typename Traits = DeribitTraits>
     struct alignas(64) Order
     {
@@ -16,32 +48,181 @@ namespace fischer::deribit
         using AmountType  = typename Traits::AmountType;
         using PriceType   = typename Traits::PriceType;
 
-        // Required Fields - Always present in every order
+        // Numeric Fields
+        const char*                     m_Source{nullptr};
         OrderIdType                     m_Id{0};
-        AmountType                      m_Amount{0.0};
-        AmountType                      m_Contracts{0.0};
-        std::string                     m_InstrumentName;
-        std::string                     m_Direction;
-        std::string                     m_Type;
-        std::string                     m_Label;
-
-        // Optional Fields
-        std::optional<PriceType>        m_Price;
-        std::optional<PriceType>        m_TriggerPrice;
-        std::optional<PriceType>        m_TriggerOffset;
-        std::optional<AmountType>       m_DisplayAmount;
-        std::optional<std::string>      m_TimeInForce;
-        std::optional<std::string>      m_Trigger;
-        std::optional<std::string>      m_Advanced;
-        std::optional<bool>             m_PostOnly;
-        std::optional<bool>             m_RejectPostOnly;
-        std::optional<bool>             m_ReduceOnly;
-        std::optional<bool>             m_Mmp;
-        std::optional<int64_t>          m_ValidUntil;
-        std::optional<std::string>      m_LinkedOrderType;
-        std::optional<std::string>      m_TriggerFillCondition;
+        AmountType                      m_Amount{};
+        AmountType                      m_Contracts{};
+        PriceType                       m_Price{};
+        PriceType                       m_TriggerPrice{};
+        PriceType                       m_TriggerOffset{};
+        AmountType                      m_DisplayAmount{};
+        int64_t                         m_ValidUntil{0};
+        uint32_t                        m_Presence{0};
+
+        // Text Fields - exactly as written in the input
+        TextRef                         m_InstrumentName;
+        TextRef                         m_Label;
+        TextRef                         m_DirectionText;
+        TextRef                         m_TypeText;
+        TextRef                         m_TimeInForceText;
+        TextRef                         m_TriggerText;
+        TextRef                         m_AdvancedText;
+        TextRef                         m_LinkedOrderTypeText;
+        TextRef                         m_TriggerFillConditionText;
+
+        // Enumerated Fields - parsed from the text above
+        OrderDirection                  m_Direction{OrderDirection::Buy};
+        OrderType                       m_Type{OrderType::Limit};
+        TimeInForce                     m_TimeInForce{TimeInForce::GoodTilCancelled};
+        TriggerType                     m_Trigger{TriggerType::None};
+        AdvancedType                    m_Advanced{AdvancedType::None};
+        LinkedOrderType                 m_LinkedOrderType{LinkedOrderType::None};
+        TriggerFillCondition            m_TriggerFillCondition{TriggerFillCondition::FirstHit};
+
+        // post_only, reject_post_only, reduce_only and mmp values
+        uint8_t                         m_Flags{0};
+
+        // InternTable IDs of the direction and instrument name; 0 when not interned
+        uint16_t                        m_MethodFragment{0};
+        uint16_t                        m_InstrumentFragment{0};
+
+        // m_Flags bit set while m_Source points to LongRowTexts
+        static constexpr uint8_t LongTextFlag = 1U << 7;
 
         Order() = default;
         RULE_OF_FIVE_TRIVIALLY_COPYABLE(Order);
+
+        static constexpr uint32_t PresenceBit(FieldIndex field) noexcept
+        {
+            return uint32_t{1} << static_cast<uint32_t>(field);
+        }
+
+        bool Has(FieldIndex field) const noexcept { return 0 != (m_Presence & PresenceBit(field)); }
+        void MarkPresent(FieldIndex field) noexcept { m_Presence |= PresenceBit(field); }
+
+        std::string_view GetText(TextRef text) const noexcept
+        {
+            if (true == HasLongTexts()) [[unlikely]]
+            {
+                return GetLongTexts()->m_Texts[text.m_Offset];
+            }
+            return std::string_view(m_Source + text.m_Offset, text.m_Length);
+        }
+
+        // Start of the order's source row
+        const char* GetRow() const noexcept
+        {
+            return true == HasLongTexts() ? GetLongTexts()->m_Row : m_Source;
+        }
+
+        // Bytes of all text fields together
+        size_t GetTextLength() const noexcept
+        {
+            if (true == HasLongTexts()) [[unlikely]]
+            {
+                return GetLongTexts()->m_TextLength;
+            }
+            return size_t{m_InstrumentName.m_Length} + m_Label.m_Length + m_DirectionText.m_Length +
+                   m_TypeText.m_Length + m_TimeInForceText.m_Length + m_TriggerText.m_Length +
+                   m_AdvancedText.m_Length + m_LinkedOrderTypeText.m_Length + m_TriggerFillConditionText.m_Length;
+        }
+
+        // Texts of this order are read from texts, which must outlive it
+        void SetLongTexts(LongRowTexts<Traits>* texts) noexcept
+        {
+            m_Source = reinterpret_cast<const char*>(texts);
+            m_Flags = static_cast<uint8_t>(m_Flags | LongTextFlag);
+        }
+
+        // value must lie within MaxTextRefOffset bytes of m_Source, unless
+        // the order's texts are kept out of line
+        TextRef MakeTextRef(const char* value, size_t length) noexcept
+        {
+            if (true == HasLongTexts()) [[unlikely]]
+            {
+                // Only the parser that set the texts writes to them
+                LongRowTexts<Traits>* texts = const_cast<LongRowTexts<Traits>*>(GetLongTexts());
+                const size_t slot = std::min(texts->m_Count++, texts->m_Texts.size() - 1);
+                texts->m_Texts[slot] = std::string_view(value, length);
+                texts->m_TextLength += length;
+                return TextRef{static_cast<uint16_t>(slot),
+                               static_cast<uint16_t>(std::min(length, MaxTextRefOffset))};
+            }
+            return TextRef{static_cast<uint16_t>(value - m_Source), static_cast<uint16_t>(length)};
+        }
+
+        // Member holding a numeric, integer or text field; resolved at compile
+        // time for the serializer and column parsers generated
+        // from FieldTable
+        template<FieldIndex Field>
+        const auto& GetValue() const noexcept
+        {
+            if constexpr (FieldIndex::Id == Field) return m_Id;
+            else if constexpr (FieldIndex::Direction == Field) return m_DirectionText;
+            else if constexpr (FieldIndex::Amount == Field) return m_Amount;
+            else if constexpr (FieldIndex::Contracts == Field) return m_Contracts;
+            else if constexpr (FieldIndex::InstrumentName == Field) return m_InstrumentName;
+            else if constexpr (FieldIndex::Label == Field) return m_Label;
+            else if constexpr (FieldIndex::Type == Field) return m_TypeText;
+            else if constexpr (FieldIndex::Price == Field) return m_Price;
+            else if constexpr (FieldIndex::TimeInForce == Field) return m_TimeInForceText;
+            else if constexpr (FieldIndex::DisplayAmount == Field) return m_DisplayAmount;
+            else if constexpr (FieldIndex::TriggerPrice == Field) return m_TriggerPrice;
+            else if constexpr (FieldIndex::TriggerOffset == Field) return m_TriggerOffset;
+            else if constexpr (FieldIndex::Trigger == Field) return m_TriggerText;
+            else if constexpr (FieldIndex::Advanced == Field) return m_AdvancedText;
+            else if constexpr (FieldIndex::ValidUntil == Field) return m_ValidUntil;
+            else if constexpr (FieldIndex::LinkedOrderType == Field) return m_LinkedOrderTypeText;
+            else if constexpr (FieldIndex::TriggerFillCondition == Field) return m_TriggerFillConditionText;
+            else static_assert(FieldIndex::None == Field, "Boolean fields are read through GetFlag");
+        }
+
+        template<FieldIndex Field>
+        auto& GetValue() noexcept
+        {
+            return const_cast<std::remove_cvref_t<decltype(std::as_const(*this).template GetValue<Field>())>&>(
+                std::as_const(*this).template GetValue<Field>());
+        }
+
+        bool GetFlag(FieldIndex field) const noexcept { return 0 != (m_Flags & FlagBit(field)); }
+
+        void SetFlag(FieldIndex field, bool value) noexcept
+        {
+            m_Flags = static_cast<uint8_t>(true == value ? (m_Flags | FlagBit(field))
+                                                         : (m_Flags & ~FlagBit(field)));
+        }
+
+    private:
+        bool HasLongTexts() const noexcept { return 0 != (m_Flags & LongTextFlag); }
+
+        const LongRowTexts<Traits>* GetLongTexts() const noexcept
+        {
+            return reinterpret_cast<const LongRowTexts<Traits>*>(m_Source);
+        }
+
+        static constexpr uint8_t FlagBit(FieldIndex field) noexcept
+        {
+            switch (field)
+            {
+            case FieldIndex::PostOnly:
+                return 1U << 0;
+            case FieldIndex::RejectPostOnly:
+                return 1U << 1;
+            case FieldIndex::ReduceOnly:
+                return 1U << 2;
+            case FieldIndex::Mmp:
+                return 1U << 3;
+            default:
+                return 0;
+            }
+        }
     };
+
+    // Orders of one parse batch, allocated as the traits choose
+    template<typename Traits>
+    using OrderVector = std::vector<Order<Traits>, typename Traits::template AllocatorType<Order<Traits>>>;
+
+    static_assert(static_cast<int>(FieldIndex::MaxFields) <= 32, "Presence mask holds one bit per field");
+    static_assert(sizeof(Order<DeribitTraits>) <= 128, "Order should fit in two cache lines");
 }
\ No newline at end of file
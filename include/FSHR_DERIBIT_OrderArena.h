@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_PageBuffer.h"
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace fischer::deribit
+{
+    // Monotonic arena for the orders of one parse batch. A vector reserved
+    // from it takes one upstream allocation of exactly its rows; nothing is
+    // freed per vector, and the batch's memory is released in one shot when
+    // the arena goes. Vectors must not outlive their arena, and an arena is
+    // used by one thread at a time. Blocks of a huge page or more come from
+    // PageResource, backed as PageBuffer describes.
+    template<typename Traits = DeribitTraits>
+    class OrderArena
+    {
+    public:
+        OrderArena() = default;
+        RULE_OF_FIVE_NONMOVABLE(OrderArena);
+
+        // The default resource unless Traits::EnableOrderArena
+        std::pmr::memory_resource* GetResource() noexcept
+        {
+            if constexpr (true == Traits::EnableOrderArena)
+            {
+                return &m_Resource;
+            }
+            return std::pmr::get_default_resource();
+        }
+
+    private:
+        PageResource m_Pages;
+        std::pmr::monotonic_buffer_resource m_Resource{&m_Pages};
+    };
+}
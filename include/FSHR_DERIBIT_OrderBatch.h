@@ -0,0 +1,157 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_CSVParser.h"
+#include "FSHR_DERIBIT_JSONBuilder.h"
+#include "FSHR_DERIBIT_OutputWriter.h"
+#include "FSHR_DERIBIT_InternTable.h"
+#include "FSHR_DERIBIT_OrderProcessor.h"
+#include "FSHR_DERIBIT_OrderArena.h"
+#include "FSHR_DERIBIT_AllocationCounter.h"
+#include "FSHR_DERIBIT_WorkStealingPool.h"
+#include "FSHR_DERIBIT_ThreadPlacement.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Processes many CSV files into one JSON output each on a fixed
+    // WorkStealingPool, in one process.
+    //
+    // Every file is loaded and its data section cut into segments: a file
+    // larger than the task size is split at newlines across several tasks,
+    // and consecutive small files are packed into one. Each worker keeps its
+    // parser, fragment tables, builder and writer for the whole batch, so a
+    // header seen before reuses its column plan and each name is interned
+    // once per worker. All segments are parsed before any message ID is
+    // given out, as IDs follow the row counts. A file that is one segment is
+    // then encoded into the worker's builder and written straight away; the
+    // segments of a split file are encoded into their own buffers, and the
+    // worker finishing the last one writes the file.
+    template<typename Traits = DeribitTraits>
+    class OrderBatch
+    {
+    public:
+        using OrderType = Order<Traits>;
+        using OrderVectorType = OrderVector<Traits>;
+        using MessageIdType = typename Traits::MessageIdType;
+        using SizeType = typename Traits::SizeType;
+        using OptionsType = ProcessorOptions<Traits>;
+
+        explicit OrderBatch(const OptionsType& options = OptionsType{});
+        RULE_OF_FIVE_NONMOVABLE(OrderBatch);
+
+        // Expands each pattern with glob(3), matches in sorted order; a
+        // pattern without wildcards is taken as a file name. Throws if a
+        // pattern matches nothing.
+        static std::vector<std::string> ExpandInputs(const std::vector<std::string>& patterns);
+
+        // The output of inputFile: its stem with BatchOutputExtension, in the
+        // output directory
+        std::string GetOutputFile(const std::string& inputFile) const;
+
+        // Throws before writing anything if two inputs map to one output or
+        // an output would replace an input, and after the batch if any file
+        // failed
+        void ProcessFiles(const std::vector<std::string>& inputFiles);
+
+        SizeType GetFileCount() const { return m_Files.size(); }
+        SizeType GetProcessedOrderCount() const { return m_ProcessedOrderCount; }
+        uint64_t GetInputBytes() const { return m_InputBytes; }
+        SizeType GetTaskCount() const { return m_Tasks.size(); }
+        SizeType GetWorkerCount() const { return m_WorkerCount; }
+        uint64_t GetStealCount() const { return m_StealCount; }
+        std::chrono::microseconds GetTotalProcessingTime() const { return m_TotalProcessingTime; }
+        std::chrono::microseconds GetLoadTime() const { return m_LoadTime; }
+        std::chrono::microseconds GetParseTime() const { return m_ParseTime; }
+        std::chrono::microseconds GetWriteTime() const { return m_WriteTime; }    // encoding and writing
+        const AllocationCounter::Snapshot& GetAllocations() const { return m_Allocations; }
+
+    protected:
+        // A loaded input and the output it is written to
+        struct BatchFile
+        {
+            std::string m_Input;
+            std::string m_Output;
+            std::unique_ptr<CsvParser<Traits>> m_Loader;    // owns the input bytes until the file is written
+            SizeType m_FirstSegment{0};
+            SizeType m_SegmentCount{0};
+            std::atomic<SizeType> m_PendingSegments{0};
+        };
+
+        // The orders of a segment and their arena, released together once
+        // the segment is encoded
+        struct SegmentOrders
+        {
+            OrderArena<Traits> m_Arena;
+            OrderVectorType m_Orders{m_Arena.GetResource()};
+        };
+
+        // A newline-aligned range of one file's data section
+        struct Segment
+        {
+            SizeType m_File{0};
+            const char* m_Begin{nullptr};
+            const char* m_End{nullptr};
+            std::unique_ptr<SegmentOrders> m_Orders;
+            SizeType m_OrderCount{0};
+            MessageIdType m_FirstMessageId{0};
+            const MessageFragments<Traits>* m_Fragments{nullptr};     // of the worker that parsed it
+            std::optional<JsonBuilder<Traits>> m_Output;                // split files only
+        };
+
+        // Consecutive segments run by one worker
+        struct Task
+        {
+            SizeType m_FirstSegment{0};
+            SizeType m_SegmentCount{0};
+            uint64_t m_Bytes{0};
+        };
+
+        struct Worker
+        {
+            explicit Worker(const OptionsType& options);
+
+            MessageFragments<Traits> m_Fragments;
+            CsvParser<Traits> m_Parser;
+            std::string m_Header;           // the parser keeps views into it
+            JsonBuilder<Traits> m_Builder;
+            OutputWriter<Traits> m_Writer;
+        };
+
+        void LoadFile(BatchFile& file) const;
+        void PlanTasks();
+        void ParseSegment(Worker& worker, Segment& segment);
+        void AssignMessageIds();
+        void EncodeSegment(Worker& worker, Segment& segment);
+        void WriteFile(Worker& worker, BatchFile& file);
+
+    private:
+        OptionsType m_Options;
+        ThreadPlacement m_Placement;
+        SizeType m_WorkerCount;
+        std::vector<BatchFile> m_Files;
+        std::vector<Segment> m_Segments;
+        std::vector<Task> m_Tasks;
+        std::vector<std::unique_ptr<Worker>> m_Workers;
+        SizeType m_ProcessedOrderCount;
+        uint64_t m_InputBytes;
+        uint64_t m_StealCount;
+        std::chrono::microseconds m_TotalProcessingTime;
+        std::chrono::microseconds m_LoadTime;
+        std::chrono::microseconds m_ParseTime;
+        std::chrono::microseconds m_WriteTime;
+        AllocationCounter::Snapshot m_Allocations;
+    };
+}
+
+#include <FSHR_DERIBIT_OrderBatch.hxx>
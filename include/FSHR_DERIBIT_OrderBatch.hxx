@@ -0,0 +1,413 @@
+#include "FSHR_DERIBIT_OrderBatch.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_Constants.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+#include <glob.h>
+
+namespace fischer::deribit
+{
+    template<typename Traits>
+    OrderBatch<Traits>::Worker::Worker(const OptionsType& options)
+        : m_Builder{options.m_NumberFormat}
+        , m_Writer{options.m_OutputBackend, options.m_SyncPolicy, options.m_EnableDirectIo, options.m_WriterCpus}
+    {
+        m_Parser.SetFragments(true == options.m_EnableInterning ? &m_Fragments : nullptr);
+    }
+
+    template<typename Traits>
+    OrderBatch<Traits>::OrderBatch(const OptionsType& options)
+        : m_Options{options}
+        , m_Placement{options.m_WorkerCpus, options.m_WriterCpus, options.m_BindMemory}
+        , m_WorkerCount{0 == options.m_ThreadCount ? std::max<SizeType>(1, std::thread::hardware_concurrency())
+                                                   : options.m_ThreadCount}
+        , m_ProcessedOrderCount{0}
+        , m_InputBytes{0}
+        , m_StealCount{0}
+        , m_TotalProcessingTime{0}
+        , m_LoadTime{0}
+        , m_ParseTime{0}
+        , m_WriteTime{0}
+        , m_Allocations{}
+    {
+        m_Workers.reserve(m_WorkerCount);
+        for (SizeType worker = 0; worker < m_WorkerCount; ++worker)
+        {
+            m_Workers.push_back(std::make_unique<Worker>(m_Options));
+        }
+    }
+
+    template<typename Traits>
+    std::vector<std::string> OrderBatch<Traits>::ExpandInputs(const std::vector<std::string>& patterns)
+    {
+        std::vector<std::string> files;
+
+        for (const std::string& pattern : patterns)
+        {
+            if (std::string::npos == pattern.find_first_of("*?["))
+            {
+                files.push_back(pattern);
+                continue;
+            }
+
+            glob_t matches{};
+            const int result = ::glob(pattern.c_str(), 0, nullptr, &matches);
+            if (0 == result)
+            {
+                files.insert(files.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+            }
+            ::globfree(&matches);
+
+            if (0 != result)
+            {
+                LOG_ERROR("No batch input matches:", pattern);
+                throw std::runtime_error("Batch input pattern matched nothing");
+            }
+        }
+
+        return files;
+    }
+
+    template<typename Traits>
+    std::string OrderBatch<Traits>::GetOutputFile(const std::string& inputFile) const
+    {
+        std::filesystem::path output = std::filesystem::path(m_Options.m_OutputDirectory) /
+                                       std::filesystem::path(inputFile).stem();
+        output += BatchOutputExtension;
+        return output.string();
+    }
+
+    template<typename Traits>
+    void OrderBatch<Traits>::ProcessFiles(const std::vector<std::string>& inputFiles)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        if (true == m_Options.m_EnableValidation || true == m_Options.m_EnableIncremental ||
+            false == m_Options.m_WebSocketUrl.empty() || InputFormat::Csv != m_Options.m_InputFormat ||
+            OutputFormat::Json != m_Options.m_OutputFormat)
+        {
+            LOG_ERROR("Batch mode reads CSV and writes JSON files, without validation or incremental runs");
+            throw std::runtime_error("Unsupported batch processing mode");
+        }
+
+        if (0 < m_Options.m_StreamWindowRows || true == m_Options.m_EnableLatencyHistograms)
+        {
+            LOG_WARNING("Batch mode does not stream or record latencies; --stream and --latency are ignored");
+        }
+
+        auto startTime = Clock::now();
+
+        // Counted over the whole batch, on every worker
+        struct AllocationScope
+        {
+            AllocationCounter::Snapshot& m_Result;
+            const AllocationCounter::Snapshot m_Start{AllocationCounter::Read()};
+
+            ~AllocationScope() { m_Result = AllocationCounter::Read() - m_Start; }
+        } allocationScope{m_Allocations};
+
+        m_Files = std::vector<BatchFile>(inputFiles.size());
+        m_Segments.clear();
+        m_Tasks.clear();
+
+        // Every output must be distinct and must not be an input
+        std::filesystem::create_directories(m_Options.m_OutputDirectory);
+        std::unordered_set<std::string> inputs;
+        std::unordered_set<std::string> outputs;
+
+        for (SizeType index = 0; index < m_Files.size(); ++index)
+        {
+            m_Files[index].m_Input = inputFiles[index];
+            m_Files[index].m_Output = GetOutputFile(inputFiles[index]);
+            inputs.insert(std::filesystem::weakly_canonical(inputFiles[index]).string());
+        }
+
+        for (const BatchFile& file : m_Files)
+        {
+            const std::string output = std::filesystem::weakly_canonical(file.m_Output).string();
+            if (false == outputs.insert(output).second || true == inputs.contains(output))
+            {
+                LOG_ERROR("Batch output", file.m_Output, "of", file.m_Input,
+                          "would replace another output or an input");
+                throw std::runtime_error("Conflicting batch outputs");
+            }
+        }
+
+        WorkStealingPool<Traits> pool(m_WorkerCount, &m_Placement);
+
+        auto loadStart = Clock::now();
+        auto load = [this](SizeType, SizeType file) { LoadFile(m_Files[file]); };
+        pool.Run(m_Files.size(), load);
+
+        PlanTasks();
+        LOG_INFO("Batch of", m_Files.size(), "files,", m_InputBytes, "bytes in", m_Tasks.size(), "tasks on",
+                 m_WorkerCount, "workers");
+
+        auto parseStart = Clock::now();
+        auto parse = [this](SizeType worker, SizeType task)
+        {
+            for (SizeType index = 0; index < m_Tasks[task].m_SegmentCount; ++index)
+            {
+                ParseSegment(*m_Workers[worker], m_Segments[m_Tasks[task].m_FirstSegment + index]);
+            }
+        };
+        pool.Run(m_Tasks.size(), parse);
+
+        AssignMessageIds();
+
+        auto writeStart = Clock::now();
+        auto encode = [this](SizeType worker, SizeType task)
+        {
+            for (SizeType index = 0; index < m_Tasks[task].m_SegmentCount; ++index)
+            {
+                EncodeSegment(*m_Workers[worker], m_Segments[m_Tasks[task].m_FirstSegment + index]);
+            }
+        };
+        pool.Run(m_Tasks.size(), encode);
+        auto writeEnd = Clock::now();
+
+        m_StealCount = pool.GetStealCount();
+        m_LoadTime = std::chrono::duration_cast<std::chrono::microseconds>(parseStart - loadStart);
+        m_ParseTime = std::chrono::duration_cast<std::chrono::microseconds>(writeStart - parseStart);
+        m_WriteTime = std::chrono::duration_cast<std::chrono::microseconds>(writeEnd - writeStart);
+        m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(writeEnd - startTime);
+
+        LOG_INFO("Batch complete. Files:", m_Files.size(), "Orders:", m_ProcessedOrderCount,
+                 "Total time:", m_TotalProcessingTime.count(), "μs");
+    }
+
+    template<typename Traits>
+    void OrderBatch<Traits>::LoadFile(BatchFile& file) const
+    {
+        file.m_Loader = std::make_unique<CsvParser<Traits>>();
+        file.m_Loader->SetMemoryMapping(m_Options.m_EnableMemoryMapping);
+
+        if (false == file.m_Loader->LoadFile(file.m_Input))
+        {
+            LOG_ERROR("Failed to load file:", file.m_Input);
+            throw std::runtime_error("Failed to load CSV file");
+        }
+
+        if (false == file.m_Loader->ParseHeader())
+        {
+            LOG_ERROR("No CSV header in batch input:", file.m_Input);
+            throw std::runtime_error("Failed to parse CSV header");
+        }
+    }
+
+    // Tasks aim at an equal share of the input, BatchTasksPerWorker per
+    // worker, so stealing has small tasks left to even out the finish. A
+    // larger file is cut at newlines into tasks of that size; runs of smaller
+    // files are packed in input order until a task is full or a larger file
+    // interrupts them. Tasks are ordered largest first for the pool to deal.
+    template<typename Traits>
+    void OrderBatch<Traits>::PlanTasks()
+    {
+        m_InputBytes = 0;
+        for (const BatchFile& file : m_Files)
+        {
+            m_InputBytes += static_cast<uint64_t>(file.m_Loader->GetDataEnd() - file.m_Loader->GetDataBegin());
+        }
+
+        const uint64_t taskBytes = std::clamp<uint64_t>(m_InputBytes / (m_WorkerCount * Traits::BatchTasksPerWorker),
+                                                        Traits::MinParallelChunkSize, Traits::BatchTaskBytes);
+        Task pack;
+
+        const auto AddSegment = [this](SizeType file, const char* begin, const char* end)
+        {
+            Segment& segment = m_Segments.emplace_back();
+            segment.m_File = file;
+            segment.m_Begin = begin;
+            segment.m_End = end;
+        };
+
+        for (SizeType index = 0; index < m_Files.size(); ++index)
+        {
+            BatchFile& file = m_Files[index];
+            const char* begin = file.m_Loader->GetDataBegin();
+            const char* end = file.m_Loader->GetDataEnd();
+            const uint64_t size = static_cast<uint64_t>(end - begin);
+            file.m_FirstSegment = m_Segments.size();
+
+            if (size <= taskBytes)
+            {
+                if (0 < pack.m_SegmentCount && taskBytes < pack.m_Bytes + size)
+                {
+                    m_Tasks.push_back(pack);
+                    pack = Task{};
+                }
+
+                if (0 == pack.m_SegmentCount)
+                {
+                    pack.m_FirstSegment = m_Segments.size();
+                }
+
+                AddSegment(index, begin, end);
+                pack.m_SegmentCount++;
+                pack.m_Bytes += size;
+            }
+            else
+            {
+                // A pack is a run of adjacent segments, so it is closed
+                // before the split file's segments are added after it
+                if (0 < pack.m_SegmentCount)
+                {
+                    m_Tasks.push_back(pack);
+                    pack = Task{};
+                }
+
+                const SizeType count = static_cast<SizeType>((size + taskBytes - 1) / taskBytes);
+                const char* segmentBegin = begin;
+
+                for (SizeType part = 1; part <= count && segmentBegin < end; ++part)
+                {
+                    const char* segmentEnd = end;
+                    if (part < count)
+                    {
+                        const char* target = std::max(segmentBegin, begin + size * part / count);
+                        const char* newline = static_cast<const char*>(
+                            std::memchr(target, LineDelimiter, static_cast<SizeType>(end - target)));
+                        segmentEnd = (nullptr == newline) ? end : newline + 1;
+                    }
+
+                    m_Tasks.push_back(Task{m_Segments.size(), 1, static_cast<uint64_t>(segmentEnd - segmentBegin)});
+                    AddSegment(index, segmentBegin, segmentEnd);
+                    segmentBegin = segmentEnd;
+                }
+            }
+
+            file.m_SegmentCount = m_Segments.size() - file.m_FirstSegment;
+            file.m_PendingSegments.store(file.m_SegmentCount, std::memory_order_relaxed);
+        }
+
+        if (0 < pack.m_SegmentCount)
+        {
+            m_Tasks.push_back(pack);
+        }
+
+        std::stable_sort(m_Tasks.begin(), m_Tasks.end(), [](const Task& left, const Task& right)
+        {
+            return left.m_Bytes > right.m_Bytes;
+        });
+    }
+
+    template<typename Traits>
+    void OrderBatch<Traits>::ParseSegment(Worker& worker, Segment& segment)
+    {
+        // Files sharing a header share the worker's column plan
+        const std::string_view header = m_Files[segment.m_File].m_Loader->GetHeaderLine();
+        if (true == worker.m_Header.empty() || header != worker.m_Header)
+        {
+            worker.m_Header.assign(header);
+            worker.m_Parser.ParseHeaders(worker.m_Header.data(), worker.m_Header.data() + worker.m_Header.size());
+        }
+
+        segment.m_Orders = std::make_unique<SegmentOrders>();
+        segment.m_Orders->m_Orders.reserve(CsvParser<Traits>::CountLines(segment.m_Begin, segment.m_End));
+        worker.m_Parser.ParseLines(segment.m_Begin, segment.m_End, segment.m_Orders->m_Orders);
+        segment.m_OrderCount = static_cast<SizeType>(segment.m_Orders->m_Orders.size());
+        segment.m_Fragments = &worker.m_Fragments;
+    }
+
+    // Global IDs run through the files in the order given, as if they were
+    // one input; per-file ranges start m_IdRangeSize apart, so a file's IDs
+    // do not depend on the size of the files before it
+    template<typename Traits>
+    void OrderBatch<Traits>::AssignMessageIds()
+    {
+        const bool perFile = MessageIdAllocation::PerFile == m_Options.m_IdAllocation;
+        const MessageIdType rangeSize = static_cast<MessageIdType>(m_Options.m_IdRangeSize);
+        MessageIdType messageId = Traits::InitialMessageId;
+        m_ProcessedOrderCount = 0;
+
+        for (SizeType index = 0; index < m_Files.size(); ++index)
+        {
+            const BatchFile& file = m_Files[index];
+            if (true == perFile)
+            {
+                messageId = Traits::InitialMessageId + static_cast<MessageIdType>(index) * rangeSize;
+            }
+
+            const MessageIdType firstMessageId = messageId;
+            for (SizeType segment = file.m_FirstSegment; segment < file.m_FirstSegment + file.m_SegmentCount; ++segment)
+            {
+                m_Segments[segment].m_FirstMessageId = messageId;
+                messageId += static_cast<MessageIdType>(m_Segments[segment].m_OrderCount);
+                m_ProcessedOrderCount += m_Segments[segment].m_OrderCount;
+            }
+
+            if (true == perFile && rangeSize < messageId - firstMessageId)
+            {
+                LOG_ERROR("Batch input", file.m_Input, "has", messageId - firstMessageId,
+                          "orders, more than its ID range of", rangeSize);
+                throw std::runtime_error("Message ID range exceeded");
+            }
+        }
+    }
+
+    template<typename Traits>
+    void OrderBatch<Traits>::EncodeSegment(Worker& worker, Segment& segment)
+    {
+        BatchFile& file = m_Files[segment.m_File];
+        const bool wholeFile = 1 == file.m_SegmentCount;
+
+        JsonBuilder<Traits>& builder = true == wholeFile ? worker.m_Builder
+                                                         : segment.m_Output.emplace(m_Options.m_NumberFormat);
+        const std::span<const OrderType> orders(segment.m_Orders->m_Orders);
+
+        builder.Reset();
+        builder.SetFragments(segment.m_Fragments);
+        builder.Reserve(builder.MeasureOrders(orders));
+
+        MessageIdType messageId = segment.m_FirstMessageId;
+        for (const OrderType& order : orders)
+        {
+            builder.BuildOrderMessage(order, messageId++);
+        }
+        segment.m_Orders.reset();
+
+        // The worker encoding a split file's last segment writes the file
+        if (true == wholeFile || 1 == file.m_PendingSegments.fetch_sub(1, std::memory_order_acq_rel))
+        {
+            WriteFile(worker, file);
+        }
+    }
+
+    template<typename Traits>
+    void OrderBatch<Traits>::WriteFile(Worker& worker, BatchFile& file)
+    {
+        worker.m_Writer.Open(file.m_Output);
+
+        if (1 == file.m_SegmentCount)
+        {
+            worker.m_Writer.Submit(worker.m_Builder.GetView());
+        }
+        else
+        {
+            for (SizeType index = file.m_FirstSegment; index < file.m_FirstSegment + file.m_SegmentCount; ++index)
+            {
+                worker.m_Writer.Submit(m_Segments[index].m_Output->GetView());
+            }
+        }
+
+        worker.m_Writer.Close();
+
+        for (SizeType index = file.m_FirstSegment; index < file.m_FirstSegment + file.m_SegmentCount; ++index)
+        {
+            m_Segments[index].m_Output.reset();
+        }
+        file.m_Loader.reset();
+
+        LOG_DEBUG("Batch output written:", file.m_Output);
+    }
+
+    template class OrderBatch<DeribitTraits>;
+    template class OrderBatch<DeribitFixedPointTraits>;
+}
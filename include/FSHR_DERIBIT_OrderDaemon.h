@@ -0,0 +1,91 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_CSVParser.h"
+#include "FSHR_DERIBIT_JSONBuilder.h"
+#include "FSHR_DERIBIT_LatencyHistogram.h"
+#include "FSHR_DERIBIT_OrderProcessor.h"
+#include "FSHR_DERIBIT_InstrumentTable.h"
+#include "FSHR_DERIBIT_OrderValidator.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace fischer::deribit
+{
+    // Resident order processor: rows arrive continuously and each complete
+    // row is encoded and written as soon as it has been read. One parser and
+    // one builder live for the whole run, so the column plan and the output
+    // buffer stay warm, and message IDs continue across every input stream.
+    //
+    // Every input stream starts with a header line; a header identical to the
+    // previous one reuses the existing column plan.
+    template<typename Traits = DeribitTraits>
+    class OrderDaemon
+    {
+    public:
+        using OrderType = Order<Traits>;
+        using OrderVectorType = OrderVector<Traits>;
+        using MessageIdType = typename Traits::MessageIdType;
+        using SizeType = typename Traits::SizeType;
+        using OptionsType = ProcessorOptions<Traits>;
+        using HistogramType = LatencyHistogram<Traits>;
+
+        explicit OrderDaemon(const OptionsType& options = OptionsType{});
+        RULE_OF_FIVE_NONMOVABLE(OrderDaemon);
+
+        // Serves the source until it ends or stopDescriptor becomes readable:
+        // "-" is stdin, a FIFO is reopened whenever its writers disconnect,
+        // a directory is watched for files that are closed or moved into it,
+        // and any other file is processed once. The output is "-" for stdout
+        // or a file that is truncated first.
+        void Run(const std::string& source, const std::string& outputFile, int stopDescriptor);
+
+        SizeType GetProcessedOrderCount() const { return m_ProcessedOrderCount; }
+        SizeType GetStreamCount() const { return m_StreamCount; }     // streams that had a header
+        SizeType GetRejectedOrderCount() const { return m_RejectLog.GetCount(); }
+        bool IsValidationEnabled() const { return m_Options.m_EnableValidation; }
+        const HistogramType& GetParseLatency() const { return m_ParseLatency; }
+        const HistogramType& GetEncodeLatency() const { return m_EncodeLatency; }
+        bool IsLatencyEnabled() const { return m_Options.m_EnableLatencyHistograms; }
+
+    protected:
+        void ServeFifo(const std::string& path);
+        void ServeDirectory(const std::string& path);
+        bool ProcessStream(int descriptor);
+        void ProcessRows(const char* begin, const char* end);
+        void AdoptHeader(std::string_view header);
+        void WriteOutput(std::string_view data);
+        bool WaitReadable(int descriptor) const;
+        void OpenValidation();
+        void OpenOutput(const std::string& outputFile);
+        void CloseOutput();
+
+    private:
+        OptionsType m_Options;
+        MessageFragments<Traits> m_Fragments;       // kept for the whole run, like the column plan
+        CsvParser<Traits> m_Parser;
+        JsonBuilder<Traits> m_Builder;
+        InstrumentTable<Traits> m_Instruments;
+        OrderValidator<Traits> m_Validator;
+        RejectLog<Traits> m_RejectLog;
+        OrderVectorType m_Orders;
+        std::vector<Reject> m_Rejects;
+        std::vector<char> m_Buffer;
+        std::string m_Header;
+        int m_OutputDescriptor;
+        int m_StopDescriptor;
+        MessageIdType m_MessageIdCounter;
+        SizeType m_ProcessedOrderCount;
+        SizeType m_StreamCount;
+        HistogramType m_ParseLatency;
+        HistogramType m_EncodeLatency;
+    };
+}
+
+#include <FSHR_DERIBIT_OrderDaemon.hxx>
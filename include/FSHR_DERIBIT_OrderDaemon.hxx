@@ -0,0 +1,405 @@
+#include "FSHR_DERIBIT_OrderDaemon.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_TscClock.h"
+
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+namespace fischer::deribit
+{
+    template<typename Traits>
+    OrderDaemon<Traits>::OrderDaemon(const OptionsType& options)
+        : m_Options{options}
+        , m_Builder{options.m_NumberFormat}
+        , m_Validator{&m_Instruments, &m_Fragments}
+        , m_OutputDescriptor{-1}
+        , m_StopDescriptor{-1}
+        , m_MessageIdCounter{Traits::InitialMessageId}
+        , m_ProcessedOrderCount{0}
+        , m_StreamCount{0}
+    {
+        m_Orders.reserve(Traits::MaxOrderCount);
+        m_Buffer.resize(Traits::DaemonReadSize);
+
+        m_Parser.SetFragments(true == options.m_EnableInterning ? &m_Fragments : nullptr);
+        m_Builder.SetFragments(&m_Fragments);
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::Run(const std::string& source, const std::string& outputFile, int stopDescriptor)
+    {
+        m_StopDescriptor = stopDescriptor;
+
+        // The daemon is one thread, placed as worker 0
+        ThreadPlacement(m_Options.m_WorkerCpus, {}, m_Options.m_BindMemory).PlaceWorker(0);
+
+        OpenValidation();
+        OpenOutput(outputFile);
+
+        try
+        {
+            struct stat sourceStat{};
+            if (StandardStreamName == source)
+            {
+                LOG_INFO("Daemon reading orders from stdin");
+                ProcessStream(STDIN_FILENO);
+            }
+            else if (0 != ::stat(source.c_str(), &sourceStat))
+            {
+                LOG_ERROR("Failed to open daemon input:", source, std::strerror(errno));
+                throw std::runtime_error("Failed to open daemon input");
+            }
+            else if (true == S_ISFIFO(sourceStat.st_mode))
+            {
+                ServeFifo(source);
+            }
+            else if (true == S_ISDIR(sourceStat.st_mode))
+            {
+                ServeDirectory(source);
+            }
+            else
+            {
+                const int descriptor = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+                if (0 > descriptor)
+                {
+                    LOG_ERROR("Failed to open daemon input:", source, std::strerror(errno));
+                    throw std::runtime_error("Failed to open daemon input");
+                }
+                ProcessStream(descriptor);
+                ::close(descriptor);
+            }
+        }
+        catch (...)
+        {
+            CloseOutput();
+            throw;
+        }
+
+        CloseOutput();
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::ServeFifo(const std::string& path)
+    {
+        LOG_INFO("Daemon reading orders from FIFO:", path);
+
+        // Opened non-blocking so waiting for a writer can be interrupted; a
+        // FIFO whose writers all disconnected keeps reporting end of file, so
+        // it is reopened to wait for the next one
+        for (;;)
+        {
+            const int descriptor = ::open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+            if (0 > descriptor)
+            {
+                LOG_ERROR("Failed to open FIFO:", path, std::strerror(errno));
+                throw std::runtime_error("Failed to open FIFO");
+            }
+
+            const bool completed = ProcessStream(descriptor);
+            ::close(descriptor);
+
+            if (false == completed)
+            {
+                return;
+            }
+        }
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::ServeDirectory(const std::string& path)
+    {
+        const int watch = ::inotify_init1(IN_CLOEXEC);
+        if (0 > watch || 0 > ::inotify_add_watch(watch, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO))
+        {
+            LOG_ERROR("Failed to watch directory:", path, std::strerror(errno));
+            if (0 <= watch)
+            {
+                ::close(watch);
+            }
+            throw std::runtime_error("Failed to watch directory");
+        }
+
+        // Files already present are left alone; only new arrivals are processed
+        LOG_INFO("Daemon watching directory:", path);
+
+        alignas(inotify_event) char events[4096];
+        while (true == WaitReadable(watch))
+        {
+            const ssize_t length = ::read(watch, events, sizeof(events));
+            if (0 >= length)
+            {
+                if (0 > length && EINTR == errno)
+                {
+                    continue;
+                }
+                LOG_ERROR("Failed to read directory events:", path, std::strerror(errno));
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < length; )
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(events + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                // Hidden names are treated as files still being staged
+                if (0 == event->len || '.' == event->name[0])
+                {
+                    continue;
+                }
+
+                const std::string file = path + "/" + event->name;
+                const int descriptor = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+                if (0 > descriptor)
+                {
+                    LOG_WARNING("Skipping unreadable file:", file, std::strerror(errno));
+                    continue;
+                }
+
+                LOG_INFO("Daemon processing file:", file);
+                const bool completed = ProcessStream(descriptor);
+                ::close(descriptor);
+
+                if (false == completed)
+                {
+                    ::close(watch);
+                    return;
+                }
+            }
+        }
+
+        ::close(watch);
+    }
+
+    // Reads one stream to its end. Complete rows are encoded and written
+    // after every read; an incomplete row is carried to the front of the
+    // buffer. Returns false when a stop was requested.
+    template<typename Traits>
+    bool OrderDaemon<Traits>::ProcessStream(int descriptor)
+    {
+        SizeType pending = 0;
+        bool hasHeader = false;
+
+        for (;;)
+        {
+            // A row longer than the buffer grows it
+            if (m_Buffer.size() - pending < Traits::DaemonReadSize)
+            {
+                m_Buffer.resize(pending + Traits::DaemonReadSize);
+            }
+
+            if (false == WaitReadable(descriptor))
+            {
+                return false;
+            }
+
+            const ssize_t count = ::read(descriptor, m_Buffer.data() + pending, m_Buffer.size() - pending);
+            if (0 > count)
+            {
+                if (EINTR == errno || EAGAIN == errno)
+                {
+                    continue;
+                }
+                LOG_ERROR("Failed to read daemon input:", std::strerror(errno));
+                break;
+            }
+            if (0 == count)
+            {
+                break;
+            }
+
+            char* begin = m_Buffer.data();
+            const char* end = begin + pending + count;
+            const char* lastLine = static_cast<const char*>(
+                ::memrchr(begin + pending, LineDelimiter, static_cast<SizeType>(count)));
+            pending += static_cast<SizeType>(count);
+
+            if (nullptr == lastLine)
+            {
+                continue;
+            }
+
+            const char* rows = begin;
+            if (false == hasHeader)
+            {
+                const char* headerEnd = static_cast<const char*>(
+                    std::memchr(begin, LineDelimiter, static_cast<SizeType>(end - begin)));
+                AdoptHeader(std::string_view(begin, static_cast<SizeType>(headerEnd - begin)));
+                rows = headerEnd + 1;
+                m_RejectLog.Rebase(rows, FirstDataLine);
+                hasHeader = true;
+                m_StreamCount++;
+            }
+
+            ProcessRows(rows, lastLine + 1);
+
+            pending = static_cast<SizeType>(end - (lastLine + 1));
+            std::memmove(begin, lastLine + 1, pending);
+        }
+
+        // A last row without a trailing newline
+        if (0 < pending)
+        {
+            if (false == hasHeader)
+            {
+                AdoptHeader(std::string_view(m_Buffer.data(), pending));
+                m_StreamCount++;
+            }
+            else
+            {
+                ProcessRows(m_Buffer.data(), m_Buffer.data() + pending);
+            }
+        }
+
+        return true;
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::ProcessRows(const char* begin, const char* end)
+    {
+        const bool recordLatency = m_Options.m_EnableLatencyHistograms;
+
+        m_Orders.clear();
+        m_Parser.ParseLines(begin, end, m_Orders, std::numeric_limits<SizeType>::max(),
+                            true == recordLatency ? &m_ParseLatency : nullptr);
+
+        // The rows were moved to the front of the buffer since the last call;
+        // line numbering continues where it stopped
+        if (true == m_Options.m_EnableValidation)
+        {
+            m_Rejects.clear();
+            m_Validator.Validate(m_Orders, m_Rejects);
+            m_RejectLog.Rebase(begin, m_RejectLog.GetLine());
+            m_RejectLog.Write(m_Rejects, end);
+        }
+
+        m_Builder.Reset();
+        for (const OrderType& order : m_Orders)
+        {
+            const uint64_t encodeStart = true == recordLatency ? TscClock::Now() : 0;
+            m_Builder.BuildOrderMessage(order, m_MessageIdCounter++);
+
+            if (true == recordLatency)
+            {
+                m_EncodeLatency.Record(TscClock::Now() - encodeStart);
+            }
+        }
+
+        WriteOutput(m_Builder.GetView());
+        m_ProcessedOrderCount += static_cast<SizeType>(m_Orders.size());
+
+        // The buffer is refilled from its start, so nothing parsed is kept
+        m_Parser.ReleaseConsumed(end);
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::AdoptHeader(std::string_view header)
+    {
+        if (false == m_Header.empty() && header == m_Header)
+        {
+            LOG_DEBUG("Header unchanged, reusing the column plan");
+            return;
+        }
+
+        // The parser keeps views into the header, so it is owned here
+        m_Header.assign(header);
+        m_Parser.ParseHeaders(m_Header.data(), m_Header.data() + m_Header.size());
+        LOG_INFO("Column plan built for header:", m_Header);
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::WriteOutput(std::string_view data)
+    {
+        while (false == data.empty())
+        {
+            const ssize_t written = ::write(m_OutputDescriptor, data.data(), data.size());
+            if (0 > written)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+                LOG_ERROR("Failed to write daemon output:", std::strerror(errno));
+                throw std::runtime_error("Failed to write daemon output");
+            }
+            data.remove_prefix(static_cast<SizeType>(written));
+        }
+    }
+
+    // Waits until the descriptor has data or end of file; false if the stop
+    // descriptor became readable first
+    template<typename Traits>
+    bool OrderDaemon<Traits>::WaitReadable(int descriptor) const
+    {
+        pollfd descriptors[2] = {{descriptor, POLLIN, 0}, {m_StopDescriptor, POLLIN, 0}};
+        const nfds_t count = 0 <= m_StopDescriptor ? 2 : 1;
+
+        for (;;)
+        {
+            if (0 <= ::poll(descriptors, count, -1))
+            {
+                return 0 == (descriptors[1].revents & POLLIN);
+            }
+            if (EINTR != errno)
+            {
+                LOG_ERROR("Failed to wait for daemon input:", std::strerror(errno));
+                return false;
+            }
+        }
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::OpenValidation()
+    {
+        if (false == m_Options.m_EnableValidation)
+        {
+            return;
+        }
+
+        if (false == m_Options.m_InstrumentFile.empty())
+        {
+            m_Instruments.Load(m_Options.m_InstrumentFile);
+        }
+
+        m_RejectLog.Open(m_Options.m_RejectsFile);
+        LOG_INFO("Daemon rejects:", m_Options.m_RejectsFile);
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::OpenOutput(const std::string& outputFile)
+    {
+        if (StandardStreamName == outputFile)
+        {
+            m_OutputDescriptor = STDOUT_FILENO;
+            return;
+        }
+
+        m_OutputDescriptor = ::open(outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (0 > m_OutputDescriptor)
+        {
+            LOG_ERROR("Failed to open output file:", outputFile, std::strerror(errno));
+            throw std::runtime_error("Failed to open output file");
+        }
+    }
+
+    template<typename Traits>
+    void OrderDaemon<Traits>::CloseOutput()
+    {
+        if (STDOUT_FILENO < m_OutputDescriptor)
+        {
+            ::close(m_OutputDescriptor);
+        }
+        m_OutputDescriptor = -1;
+    }
+
+    template class OrderDaemon<DeribitTraits>;
+    template class OrderDaemon<DeribitFixedPointTraits>;
+}
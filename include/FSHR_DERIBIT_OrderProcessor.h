@@ -3,45 +3,191 @@
 #include "FSHR_DERIBIT_Macro.h"
 #include "FSHR_DERIBIT_Enums.h"
 #include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Constants.h"
 #include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_CSVParser.h"
+#include "FSHR_DERIBIT_JSONBuilder.h"
+#include "FSHR_DERIBIT_LatencyHistogram.h"
+#include "FSHR_DERIBIT_OutputWriter.h"
+#include "FSHR_DERIBIT_InternTable.h"
+#include "FSHR_DERIBIT_InstrumentTable.h"
+#include "FSHR_DERIBIT_OrderValidator.h"
+#include "FSHR_DERIBIT_BinaryOrderFile.h"
+#include "FSHR_DERIBIT_EncodeCache.h"
+#include "FSHR_DERIBIT_AllocationCounter.h"
+#include "FSHR_DERIBIT_OrderArena.h"
+#include "FSHR_DERIBIT_ThreadPlacement.h"
+#include "FSHR_DERIBIT_ResponseTracker.h"
 
 #include <string>
 #include <vector>
 #include <chrono>
 #include <cstdint>
+#include <span>
+#include <memory>
 
 namespace fischer::deribit
 {
+    // Runtime switches, defaulted from the compile-time traits
+    template<typename Traits = DeribitTraits>
+    struct ProcessorOptions
+    {
+        bool m_EnableMemoryMapping{Traits::EnableMemoryMapping};
+        typename Traits::SizeType m_ThreadCount{Traits::DefaultThreadCount};
+        typename Traits::SizeType m_StreamWindowRows{0};  // 0 disables streaming
+        NumberFormat m_NumberFormat{Traits::DefaultNumberFormat};
+        bool m_EnableLatencyHistograms{Traits::EnableLatencyHistograms};
+        std::string m_LatencyReportFile;                  // empty: no JSON report
+        OutputBackend m_OutputBackend{Traits::DefaultOutputBackend};
+        SyncPolicy m_SyncPolicy{Traits::DefaultSyncPolicy};
+        bool m_EnableDirectIo{false};
+        std::string m_WebSocketUrl;                       // non-empty: send frames instead of writing a file
+        double m_PacingRate{0.0};                         // messages per second; 0 releases the output at once
+        typename Traits::SizeType m_PacingBurst{Traits::DefaultPacingBurst};
+        bool m_EnableInterning{Traits::EnableInterning};
+        bool m_EnableValidation{Traits::EnableValidation};
+        std::string m_InstrumentFile;                     // empty: only the checks without reference data
+        std::string m_RejectsFile{DefaultRejectsFile};
+        InputFormat m_InputFormat{InputFormat::Csv};
+        OutputFormat m_OutputFormat{OutputFormat::Json};  // Binary: convert the input to a binary order file
+        bool m_EnableIncremental{Traits::EnableIncremental};
+        MessageIdAllocation m_IdAllocation{MessageIdAllocation::Global};   // batch mode only
+        typename Traits::SizeType m_IdRangeSize{Traits::DefaultIdRangeSize};
+        std::string m_OutputDirectory{DefaultBatchOutputDirectory};
+        std::vector<int> m_WorkerCpus;                    // empty: threads are not pinned
+        std::vector<int> m_WriterCpus;
+        bool m_BindMemory{false};                         // bind pinned workers' buffers to their node
+        HugePages m_HugePages{Traits::DefaultHugePages};
+        bool m_EnablePerfCounters{false};
+    };
+
     template<typename Traits = DeribitTraits>
     class OrderProcessor
     {
     public:
         using OrderType = Order<Traits>;
+        using OrderVectorType = OrderVector<Traits>;
         using MessageIdType = typename Traits::MessageIdType;
         using SizeType = typename Traits::SizeType;
+        using OptionsType = ProcessorOptions<Traits>;
+        using HistogramType = LatencyHistogram<Traits>;
 
-        OrderProcessor();
+        explicit OrderProcessor(const OptionsType& options = OptionsType{});
         RULE_OF_FIVE_NONMOVABLE(OrderProcessor);
 
         void ProcessOrders(const std::string& inputFile, const std::string& outputFile);
 
         SizeType GetProcessedOrderCount() const { return m_ProcessedOrderCount; }
+        SizeType GetRejectedOrderCount() const { return m_RejectLog.GetCount(); }
+        bool IsValidationEnabled() const { return m_Options.m_EnableValidation; }
         std::chrono::microseconds GetTotalProcessingTime() const { return m_TotalProcessingTime; }
         std::chrono::microseconds GetParseTime() const { return m_ParseTime; }
+        std::chrono::microseconds GetValidateTime() const { return m_ValidateTime; }
         std::chrono::microseconds GetBuildTime() const { return m_BuildTime; }
         std::chrono::microseconds GetWriteTime() const { return m_WriteTime; }
+        SizeType GetPeakWindowOrderCount() const { return m_PeakWindowOrderCount; }
+        SizeType GetPeakWindowBytes() const { return m_PeakWindowBytes; }
+
+        // Global operator new calls during the last ProcessOrders, on every
+        // thread; zero unless AllocationCounter::IsInstalled()
+        const AllocationCounter::Snapshot& GetAllocations() const { return m_Allocations; }
+
+        // Per-order latencies in TscClock ticks; empty unless
+        // m_EnableLatencyHistograms is set
+        const HistogramType& GetParseLatency() const { return m_ParseLatency; }
+        const HistogramType& GetEncodeLatency() const { return m_EncodeLatency; }
+        bool IsLatencyEnabled() const { return m_Options.m_EnableLatencyHistograms; }
+        void WriteLatencyReport(const std::string& filename) const;
+
+        // Paced output: the rate the messages were released at, and each
+        // release's lateness against its due time in nanoseconds
+        bool IsPacingEnabled() const { return 0.0 < m_Options.m_PacingRate; }
+        double GetTargetRate() const { return m_Options.m_PacingRate; }
+        double GetAchievedRate() const { return m_AchievedRate; }
+        const HistogramType& GetReleaseLateness() const { return m_ReleaseLateness; }
+
+        // WebSocket output: the peer's replies matched to the requests, with
+        // their round trips in TscClock ticks
+        bool HasResponses() const { return false == m_Options.m_WebSocketUrl.empty(); }
+        const ResponseTracker<Traits>& GetResponses() const { return m_Responses; }
 
     protected:
-        std::vector<OrderType> ParseOrderFile(const std::string& filename);
-        std::string BuildJsonPayload(const std::vector<OrderType>& orders);
-        void WriteOutputFile(const std::string& filename, const std::string& content);
+        // A newline-aligned slice of the input, parsed and encoded by one worker
+        struct Chunk
+        {
+            const char* m_Begin{nullptr};
+            const char* m_End{nullptr};
+            std::unique_ptr<OrderArena<Traits>> m_Arena{std::make_unique<OrderArena<Traits>>()};
+            OrderVectorType m_Orders{m_Arena->GetResource()};
+            MessageIdType m_FirstMessageId{0};
+            JsonBuilder<Traits> m_Builder;      // holds the chunk's output
+            std::vector<Reject> m_Rejects;
+            HistogramType m_ParseLatency;
+            HistogramType m_EncodeLatency;
+            MessageFragments<Traits> m_Fragments;
+            CsvParser<Traits> m_Parser;         // holds out-of-line texts of long rows until encoded
+        };
+
+        // A row of an incremental block and its cached body, if any
+        struct CachedRow
+        {
+            const char* m_Begin{nullptr};
+            RowKey m_Key;
+            std::string_view m_Body;
+        };
+
+        void ProcessOrdersToWebSocket(const std::string& inputFile);
+        void ProcessOrdersPaced(const std::string& inputFile, const std::string& outputFile);
+        void ProcessOrdersIncremental(const std::string& inputFile, const std::string& outputFile);
+        bool LoadCheckpoint(const std::string& checkpointFile, const std::string& inputFile,
+                            const std::string& outputFile,
+                            const CsvParser<Traits>& parser, IncrementalCheckpoint& checkpoint) const;
+        const char* CollectRows(const char* begin, const char* end, EncodeCache<Traits>& cache,
+                                std::vector<CachedRow>& rows) const;
+        void ProcessOrdersStreaming(const std::string& inputFile, const std::string& outputFile);
+        void ProcessOrdersParallel(const std::string& inputFile, const std::string& outputFile,
+                                   SizeType threadCount);
+        std::vector<Chunk> SplitIntoChunks(const char* begin, const char* end,
+                                           SizeType threadCount) const;
+        template<typename Function>
+        void RunChunks(std::vector<Chunk>& chunks, Function function) const;
+        SizeType ResolveThreadCount() const;
+
+        void OpenValidation(uint64_t rejectsOffset = 0, SizeType rejectCount = 0);
+        void ValidateOrders(OrderValidator<Traits>& validator, OrderVectorType& orders,
+                            const char* end);
+        void LoadInputFile(CsvParser<Traits>& parser, const std::string& filename) const;
+        OrderVectorType ParseOrderFile(CsvParser<Traits>& parser, BinaryOrderFile<Traits>& binaryFile,
+                                       const std::string& filename, OrderArena<Traits>& arena);
+        std::vector<JsonBuilder<Traits>> CreateBuilders(const MessageFragments<Traits>& fragments) const;
+        OutputWriter<Traits> CreateWriter() const;
+        SizeType EncodeAndWrite(std::span<const OrderType> orders, OutputWriter<Traits>& writer,
+                                std::vector<JsonBuilder<Traits>>& builders);
+        static MessageIdType EncodeOrders(JsonBuilder<Traits>& builder, std::span<const OrderType> orders,
+                                          MessageIdType messageId, HistogramType* latency);
+        HistogramType* GetLatencySink(HistogramType& histogram) const;
+        MessageFragments<Traits>* GetFragmentSink(MessageFragments<Traits>& fragments) const;
+        void WriteOutputFile(const std::string& filename, const std::vector<Chunk>& chunks);
 
     private:
+        OptionsType m_Options;
+        ThreadPlacement m_Placement;
         SizeType m_ProcessedOrderCount;
         std::chrono::microseconds m_TotalProcessingTime;
         std::chrono::microseconds m_ParseTime;
+        std::chrono::microseconds m_ValidateTime;
         std::chrono::microseconds m_BuildTime;
         std::chrono::microseconds m_WriteTime;
+        SizeType m_PeakWindowOrderCount;
+        SizeType m_PeakWindowBytes;
+        AllocationCounter::Snapshot m_Allocations;
+        HistogramType m_ParseLatency;
+        HistogramType m_EncodeLatency;
+        HistogramType m_ReleaseLateness;
+        double m_AchievedRate;
+        ResponseTracker<Traits> m_Responses;
+        InstrumentTable<Traits> m_Instruments;
+        RejectLog<Traits> m_RejectLog;
         MessageIdType m_MessageIdCounter;
         ProcessingStatus m_Status;
     };
@@ -3,20 +3,37 @@
 #include "FSHR_DERIBIT_JSONBuilder.h"
 #include "FSHR_DERIBIT_Logger.h"
 #include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_TscClock.h"
+#include "FSHR_DERIBIT_WebSocketSender.h"
+#include "FSHR_DERIBIT_EmissionPacer.h"
 
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <exception>
+#include <cstring>
+#include <thread>
+#include <limits>
+#include <charconv>
+#include <filesystem>
 
 namespace fischer::deribit
 {
     template<typename Traits>
-    OrderProcessor<Traits>::OrderProcessor()
-        : m_ProcessedOrderCount{0}
+    OrderProcessor<Traits>::OrderProcessor(const OptionsType& options)
+        : m_Options{options}
+        , m_Placement{options.m_WorkerCpus, options.m_WriterCpus, options.m_BindMemory}
+        , m_ProcessedOrderCount{0}
         , m_TotalProcessingTime{0}
         , m_ParseTime{0}
+        , m_ValidateTime{0}
         , m_BuildTime{0}
         , m_WriteTime{0}
+        , m_PeakWindowOrderCount{0}
+        , m_PeakWindowBytes{0}
+        , m_Allocations{}
+        , m_AchievedRate{0.0}
         , m_MessageIdCounter{Traits::InitialMessageId}
         , m_Status{ProcessingStatus::Idle}
     {
@@ -32,37 +49,115 @@ namespace fischer::deribit
 
         auto startTime = std::chrono::high_resolution_clock::now();
 
+        // Counted over the whole run, whichever path takes it
+        struct AllocationScope
+        {
+            AllocationCounter::Snapshot& m_Result;
+            const AllocationCounter::Snapshot m_Start{AllocationCounter::Read()};
+
+            ~AllocationScope() { m_Result = AllocationCounter::Read() - m_Start; }
+        } allocationScope{m_Allocations};
+
+        // The calling thread is worker 0 on every path
+        m_Placement.PlaceWorker(0);
+
         try
         {
-            // Parse CSV input
+            // The incremental path opens validation at its checkpoint
+            if (true == m_Options.m_EnableIncremental)
+            {
+                ProcessOrdersIncremental(inputFile, outputFile);
+                return;
+            }
+
+            OpenValidation();
+
+            if (true == IsPacingEnabled())
+            {
+                ProcessOrdersPaced(inputFile, outputFile);
+                return;
+            }
+
+            if (false == m_Options.m_WebSocketUrl.empty())
+            {
+                ProcessOrdersToWebSocket(inputFile);
+                return;
+            }
+
+            // Binary files are read and written whole, so they take the
+            // serial path
+            const bool binaryFormat = InputFormat::Binary == m_Options.m_InputFormat ||
+                                      OutputFormat::Binary == m_Options.m_OutputFormat;
+            const SizeType threadCount = ResolveThreadCount();
+
+            if (true == binaryFormat && (0 < m_Options.m_StreamWindowRows || 1 < threadCount))
+            {
+                LOG_WARNING("Binary input and output are processed serially; --stream and --threads are ignored");
+            }
+            else if (0 < m_Options.m_StreamWindowRows)
+            {
+                ProcessOrdersStreaming(inputFile, outputFile);
+                return;
+            }
+            else if (1 < threadCount)
+            {
+                ProcessOrdersParallel(inputFile, outputFile, threadCount);
+                return;
+            }
+
+            // Parse the input - orders reference the parser's buffer or the
+            // mapped binary file, and the fragment tables, so all of them
+            // must outlive the build phase; the arena holds the orders
             auto parseStart = std::chrono::high_resolution_clock::now();
-            std::vector<OrderType> orders = ParseOrderFile(inputFile);
+            MessageFragments<Traits> fragments;
+            CsvParser<Traits> parser;
+            BinaryOrderFile<Traits> binaryFile;
+            OrderArena<Traits> arena;
+            parser.SetFragments(GetFragmentSink(fragments));
+            OrderVectorType orders = ParseOrderFile(parser, binaryFile, inputFile, arena);
             auto parseEnd = std::chrono::high_resolution_clock::now();
 
             LOG_INFO("Parsed", orders.size(), "orders");
 
-            // Build JSON output
+            OrderValidator<Traits> validator(&m_Instruments, &fragments);
+            m_RejectLog.Rebase(parser.GetDataBegin(), FirstDataLine);
+            ValidateOrders(validator, orders, parser.GetDataEnd());
+
             m_Status = ProcessingStatus::Building;
             auto buildStart = std::chrono::high_resolution_clock::now();
-            std::string jsonOutput = BuildJsonPayload(orders);
-            auto buildEnd = std::chrono::high_resolution_clock::now();
 
-            LOG_DEBUG("Built JSON payload with size:", jsonOutput.size());
+            if (OutputFormat::Binary == m_Options.m_OutputFormat)
+            {
+                // Conversion: the accepted orders are stored, not encoded
+                m_Status = ProcessingStatus::Writing;
+                BinaryOrderFile<Traits>::Write(outputFile, orders);
+            }
+            else
+            {
+                // Encode and write: each block of orders is handed to the
+                // writer while the next block is encoded. The builders are
+                // declared first so they outlive any write still in flight.
+                std::vector<JsonBuilder<Traits>> builders = CreateBuilders(fragments);
+                OutputWriter<Traits> writer = CreateWriter();
+                writer.Open(outputFile);
+
+                EncodeAndWrite(orders, writer, builders);
+
+                m_Status = ProcessingStatus::Writing;
+                writer.Close();
+            }
 
-            // Write output file
-            m_Status = ProcessingStatus::Writing;
-            auto writeStart = std::chrono::high_resolution_clock::now();
-            WriteOutputFile(outputFile, jsonOutput);
             auto writeEnd = std::chrono::high_resolution_clock::now();
 
+            LOG_INFO("Output written successfully:", outputFile);
+
             // Calculate metrics
             m_ProcessedOrderCount = static_cast<SizeType>(orders.size());
             m_ParseTime = std::chrono::duration_cast<std::chrono::microseconds>(
                 parseEnd - parseStart);
-            m_BuildTime = std::chrono::duration_cast<std::chrono::microseconds>(
-                buildEnd - buildStart);
+            // Time not spent encoding was spent waiting for the writer
             m_WriteTime = std::chrono::duration_cast<std::chrono::microseconds>(
-                writeEnd - writeStart);
+                writeEnd - buildStart) - m_BuildTime;
             m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(
                 writeEnd - startTime);
 
@@ -80,10 +175,813 @@ namespace fischer::deribit
     }
 
     template<typename Traits>
-    std::vector<typename OrderProcessor<Traits>::OrderType>
-    OrderProcessor<Traits>::ParseOrderFile(const std::string& filename)
+    void OrderProcessor<Traits>::ProcessOrdersToWebSocket(const std::string& inputFile)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        if (OutputFormat::Binary == m_Options.m_OutputFormat)
+        {
+            LOG_ERROR("Binary output cannot be sent over a WebSocket");
+            throw std::runtime_error("Unsupported output format");
+        }
+
+        auto startTime = Clock::now();
+        MessageFragments<Traits> fragments;
+        CsvParser<Traits> parser;
+        BinaryOrderFile<Traits> binaryFile;
+        OrderArena<Traits> arena;
+        parser.SetFragments(GetFragmentSink(fragments));
+        OrderVectorType orders = ParseOrderFile(parser, binaryFile, inputFile, arena);
+        auto parseEnd = Clock::now();
+
+        LOG_INFO("Parsed", orders.size(), "orders");
+
+        OrderValidator<Traits> validator(&m_Instruments, &fragments);
+        m_RejectLog.Rebase(parser.GetDataBegin(), FirstDataLine);
+        ValidateOrders(validator, orders, parser.GetDataEnd());
+
+        WebSocketSender<Traits> sender;
+        sender.Connect(m_Options.m_WebSocketUrl);
+        m_Responses.Start(m_MessageIdCounter, static_cast<SizeType>(orders.size()));
+        sender.SetResponseTracker(&m_Responses);
+
+        // Each block is framed in place in the builder's buffer and sent
+        // before the next one is encoded into it
+        m_Status = ProcessingStatus::Building;
+        JsonBuilder<Traits> builder(m_Options.m_NumberFormat);
+        builder.SetHeaderReserve(WebSocketSender<Traits>::HeaderReserve);
+        builder.SetFragments(&fragments);
+        const std::span<const OrderType> pending(orders);
+
+        for (SizeType begin = 0; begin < pending.size(); begin += Traits::OutputBlockOrders)
+        {
+            auto encodeStart = Clock::now();
+            builder.Reset();
+            m_MessageIdCounter = EncodeOrders(builder,
+                                              pending.subspan(begin, std::min<SizeType>(
+                                                  Traits::OutputBlockOrders, pending.size() - begin)),
+                                              m_MessageIdCounter, GetLatencySink(m_EncodeLatency));
+            auto sendStart = Clock::now();
+
+            sender.Send(builder);
+
+            m_BuildTime += std::chrono::duration_cast<std::chrono::microseconds>(sendStart - encodeStart);
+            m_WriteTime += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - sendStart);
+        }
+
+        m_Status = ProcessingStatus::Writing;
+        auto closeStart = Clock::now();
+        sender.Close();
+        auto closeEnd = Clock::now();
+
+        m_ProcessedOrderCount = static_cast<SizeType>(orders.size());
+        m_ParseTime = std::chrono::duration_cast<std::chrono::microseconds>(parseEnd - startTime);
+        m_WriteTime += std::chrono::duration_cast<std::chrono::microseconds>(closeEnd - closeStart);
+        m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(closeEnd - startTime);
+        m_Status = ProcessingStatus::Complete;
+
+        LOG_INFO("WebSocket frames sent:", sender.GetFramesSent(), "bytes:", sender.GetBytesSent(),
+                 "replies received:", sender.GetFramesReceived());
+        LOG_INFO("Processing complete. Orders:", m_ProcessedOrderCount,
+                "Total time:", m_TotalProcessingTime.count(), "μs");
+    }
+
+    // The whole input is encoded before the first release, so no release
+    // waits on encoding and lateness measures the timer and the sink alone.
+    // Releases go to the WebSocket as frames, or to the output file: each
+    // release is written with its own synchronous write, so a reader
+    // following the file sees the messages at their paced times.
+    template<typename Traits>
+    void OrderProcessor<Traits>::ProcessOrdersPaced(const std::string& inputFile, const std::string& outputFile)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+        const bool toWebSocket = false == m_Options.m_WebSocketUrl.empty();
+
+        if (OutputFormat::Binary == m_Options.m_OutputFormat)
+        {
+            LOG_ERROR("Binary output cannot be paced");
+            throw std::runtime_error("Unsupported output format");
+        }
+
+        if (0 < m_Options.m_StreamWindowRows || 1 < ResolveThreadCount())
+        {
+            LOG_WARNING("Paced output is encoded serially; --stream and --threads are ignored");
+        }
+
+        auto startTime = Clock::now();
+        MessageFragments<Traits> fragments;
+        CsvParser<Traits> parser;
+        BinaryOrderFile<Traits> binaryFile;
+        OrderArena<Traits> arena;
+        parser.SetFragments(GetFragmentSink(fragments));
+        OrderVectorType orders = ParseOrderFile(parser, binaryFile, inputFile, arena);
+        auto parseEnd = Clock::now();
+
+        LOG_INFO("Parsed", orders.size(), "orders");
+
+        OrderValidator<Traits> validator(&m_Instruments, &fragments);
+        m_RejectLog.Rebase(parser.GetDataBegin(), FirstDataLine);
+        ValidateOrders(validator, orders, parser.GetDataEnd());
+
+        m_Status = ProcessingStatus::Building;
+        auto buildStart = Clock::now();
+        const MessageIdType firstMessageId = m_MessageIdCounter;
+        JsonBuilder<Traits> builder(m_Options.m_NumberFormat);
+        builder.SetHeaderReserve(true == toWebSocket ? WebSocketSender<Traits>::HeaderReserve : 0);
+        builder.SetFragments(&fragments);
+        builder.Reserve(builder.MeasureOrders(orders));
+        m_MessageIdCounter = EncodeOrders(builder, orders, m_MessageIdCounter, GetLatencySink(m_EncodeLatency));
+        auto releaseStart = Clock::now();
+
+        m_Status = ProcessingStatus::Writing;
+        const SizeType messageCount = static_cast<SizeType>(orders.size());
+
+        const auto KeepStatistics = [this](const auto& pacer)
+        {
+            m_ReleaseLateness = pacer.GetLateness();
+            m_AchievedRate = pacer.GetAchievedRate();
+            LOG_INFO("Paced release complete. Messages:", pacer.GetReleasedCount(), "Waits:", pacer.GetWaitCount());
+        };
+
+        if (true == toWebSocket)
+        {
+            // Replies are read while the pacer waits, so each is stamped when
+            // it arrives rather than at the next release
+            struct ReceivingClock : SteadyPacingClock
+            {
+                WebSocketSender<Traits>* m_Sender;
+
+                void WaitUntil(int64_t deadline) const
+                {
+                    m_Sender->ReceiveUntil(std::chrono::steady_clock::time_point(
+                        std::chrono::nanoseconds(deadline - GetSpinNanoseconds())));
+                    SteadyPacingClock::WaitUntil(deadline);
+                }
+            };
+
+            WebSocketSender<Traits> sender;
+            sender.Connect(m_Options.m_WebSocketUrl);
+            m_Responses.Start(firstMessageId, messageCount);
+            sender.SetResponseTracker(&m_Responses);
+
+            EmissionPacer<Traits, ReceivingClock> pacer(m_Options.m_PacingRate, m_Options.m_PacingBurst,
+                                                        ReceivingClock{SteadyPacingClock{}, &sender});
+            SizeType next = 0;
+            pacer.Release(messageCount, [&sender, &builder, &next](SizeType count)
+            {
+                sender.Send(builder, next, count);
+                next += count;
+            });
+
+            sender.Close();
+            KeepStatistics(pacer);
+            LOG_INFO("WebSocket frames sent:", sender.GetFramesSent(), "bytes:", sender.GetBytesSent(),
+                     "replies received:", sender.GetFramesReceived());
+        }
+        else
+        {
+            EmissionPacer<Traits> pacer(m_Options.m_PacingRate, m_Options.m_PacingBurst);
+            OutputWriter<Traits> writer(OutputBackend::Synchronous, m_Options.m_SyncPolicy);
+            writer.Open(outputFile);
+
+            // Without framing the messages are newline-terminated and
+            // recorded nowhere, so each release finds its end by newlines
+            const std::string_view output = builder.GetView();
+            const char* next = output.data();
+            const char* const end = output.data() + output.size();
+
+            pacer.Release(messageCount, [&writer, &next, end](SizeType count)
+            {
+                const char* const begin = next;
+                for (SizeType index = 0; index < count; ++index)
+                {
+                    next = static_cast<const char*>(std::memchr(next, '\n', static_cast<size_t>(end - next))) + 1;
+                }
+                writer.Submit(std::string_view(begin, static_cast<size_t>(next - begin)));
+            });
+
+            writer.Close();
+            KeepStatistics(pacer);
+            LOG_INFO("Output written successfully:", outputFile);
+        }
+
+        auto releaseEnd = Clock::now();
+
+        m_ProcessedOrderCount = messageCount;
+        m_ParseTime = std::chrono::duration_cast<std::chrono::microseconds>(parseEnd - startTime);
+        m_BuildTime = std::chrono::duration_cast<std::chrono::microseconds>(releaseStart - buildStart);
+        m_WriteTime = std::chrono::duration_cast<std::chrono::microseconds>(releaseEnd - releaseStart);
+        m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(releaseEnd - startTime);
+        m_Status = ProcessingStatus::Complete;
+
+        LOG_INFO("Processing complete. Orders:", m_ProcessedOrderCount,
+                "Total time:", m_TotalProcessingTime.count(), "μs");
+    }
+
+    // Rows whose text is in the previous run's cache are emitted from it
+    // with fresh message IDs; only the others are parsed and encoded. With
+    // validation every row is parsed and checked, and the cache saves only
+    // the encoding. Encoded rows are appended to the cache as they go.
+    // Every CheckpointBlocks blocks the written output and the rejects are
+    // recorded in a checkpoint, which a later run over the same input
+    // resumes from.
+    template<typename Traits>
+    void OrderProcessor<Traits>::ProcessOrdersIncremental(const std::string& inputFile,
+                                                          const std::string& outputFile)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        if (false == m_Options.m_WebSocketUrl.empty() || InputFormat::Csv != m_Options.m_InputFormat ||
+            OutputFormat::Json != m_Options.m_OutputFormat || true == IsPacingEnabled())
+        {
+            LOG_ERROR("Incremental processing reads CSV and writes a JSON file, unpaced");
+            throw std::runtime_error("Unsupported incremental processing mode");
+        }
+
+        if (0 < m_Options.m_StreamWindowRows || 1 < ResolveThreadCount())
+        {
+            LOG_WARNING("Incremental processing is serial; --stream and --threads are ignored");
+        }
+
+        auto startTime = Clock::now();
+
+        MessageFragments<Traits> fragments;
+        CsvParser<Traits> parser;
+        parser.SetFragments(GetFragmentSink(fragments));
+        LoadInputFile(parser, inputFile);
+
+        const std::string cacheFile = outputFile + std::string(CacheFileSuffix);
+        const std::string checkpointFile = outputFile + std::string(CheckpointFileSuffix);
+        const bool validating = m_Options.m_EnableValidation;
+
+        IncrementalCheckpoint checkpoint;
+        const bool resumed = LoadCheckpoint(checkpointFile, inputFile, outputFile, parser, checkpoint);
+        if (true == resumed)
+        {
+            LOG_INFO("Resuming at line", checkpoint.m_InputLine, "after", checkpoint.m_OrderCount, "orders");
+            m_MessageIdCounter = checkpoint.m_NextMessageId;
+        }
+        else
+        {
+            checkpoint = IncrementalCheckpoint{};
+            checkpoint.m_Context = EncodeCache<Traits>::HashContext(parser.GetHeaderLine(), m_Options.m_NumberFormat,
+                                                                    m_Options.m_EnableInterning);
+            checkpoint.m_InputSize = std::filesystem::file_size(inputFile);
+            checkpoint.m_InputModified = std::filesystem::last_write_time(inputFile).time_since_epoch().count();
+            checkpoint.m_InputLine = FirstDataLine;
+            checkpoint.m_NextMessageId = m_MessageIdCounter;
+        }
+
+        OpenValidation(checkpoint.m_RejectsOffset, static_cast<SizeType>(checkpoint.m_RejectCount));
+
+        EncodeCache<Traits> cache;
+        cache.Load(cacheFile, checkpoint.m_Context);
+        cache.BeginWrite(cacheFile, checkpoint.m_Context);
+
+        std::vector<JsonBuilder<Traits>> builders = CreateBuilders(fragments);
+        OutputWriter<Traits> writer = CreateWriter();
+        writer.Open(outputFile, checkpoint.m_OutputOffset);
+
+        OrderValidator<Traits> validator(&m_Instruments, &fragments);
+        const char* current = parser.GetDataBegin() + checkpoint.m_InputOffset;
+        const char* end = parser.GetDataEnd();
+        m_RejectLog.Rebase(current, static_cast<SizeType>(checkpoint.m_InputLine));
+
+        std::vector<CachedRow> rows;
+        OrderVectorType orders;
+        SizeType orderCount = 0;
+        SizeType cachedCount = 0;
+        SizeType blockCount = 0;
+
+        while (current < end)
+        {
+            auto parseStart = Clock::now();
+            const char* blockEnd = CollectRows(current, end, cache, rows);
+
+            // Without validation only the runs of uncached rows are parsed
+            orders.clear();
+            for (SizeType index = 0; index < rows.size(); )
+            {
+                if (false == validating && false == rows[index].m_Body.empty())
+                {
+                    ++index;
+                    continue;
+                }
+
+                const char* runBegin = rows[index].m_Begin;
+                while (index < rows.size() && (true == validating || true == rows[index].m_Body.empty()))
+                {
+                    ++index;
+                }
+                parser.ParseLines(runBegin, index < rows.size() ? rows[index].m_Begin : blockEnd, orders);
+            }
+
+            ValidateOrders(validator, orders, blockEnd);
+            auto buildStart = Clock::now();
+
+            // Rows line up with the orders parsed from them; a row with no
+            // order is blank, malformed or rejected
+            JsonBuilder<Traits>& builder = builders[writer.AcquireSlot()];
+            builder.Reset();
+            SizeType next = 0;
+            SizeType blockOrders = 0;
+
+            for (SizeType index = 0; index < rows.size(); ++index)
+            {
+                const CachedRow& row = rows[index];
+                const char* rowEnd = index + 1 < rows.size() ? rows[index + 1].m_Begin : blockEnd;
+                const bool parsed = next < orders.size() && orders[next].GetRow() < rowEnd;
+
+                if (false == row.m_Body.empty() && (true == parsed || false == validating))
+                {
+                    builder.AppendMessage(m_MessageIdCounter++, row.m_Body);
+                    cachedCount++;
+                }
+                else if (true == parsed)
+                {
+                    const SizeType messageStart = builder.GetBufferPosition();
+                    builder.BuildOrderMessage(orders[next], m_MessageIdCounter++);
+                    cache.Append(row.m_Key, builder.GetMessageBody(messageStart));
+                }
+                else
+                {
+                    continue;
+                }
+
+                next += true == parsed ? 1 : 0;
+                blockOrders++;
+            }
+
+            auto writeStart = Clock::now();
+            writer.Submit(builder.GetView());
+            parser.ReleaseConsumed(blockEnd);
+
+            checkpoint.m_InputLine += rows.size();
+            checkpoint.m_OrderCount += blockOrders;
+            orderCount += blockOrders;
+            current = blockEnd;
+
+            m_ParseTime += std::chrono::duration_cast<std::chrono::microseconds>(buildStart - parseStart);
+            m_BuildTime += std::chrono::duration_cast<std::chrono::microseconds>(writeStart - buildStart);
+            m_WriteTime += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - writeStart);
+
+            if (0 == ++blockCount % Traits::CheckpointBlocks && current < end)
+            {
+                // Everything the checkpoint covers must be in the files first
+                writer.Flush();
+                checkpoint.m_InputOffset = static_cast<uint64_t>(current - parser.GetDataBegin());
+                checkpoint.m_NextMessageId = m_MessageIdCounter;
+                checkpoint.m_OutputOffset = writer.GetBytesWritten();
+                cache.Flush();
+                checkpoint.m_RejectsOffset = true == validating ? m_RejectLog.GetOffset() : 0;
+                checkpoint.m_RejectCount = m_RejectLog.GetCount();
+                checkpoint.Save(checkpointFile);
+            }
+        }
+
+        auto closeStart = Clock::now();
+        writer.Close();
+        // A resumed run did not look up the rows before the checkpoint, so
+        // it cannot tell which records are unused
+        cache.Commit(false == resumed);
+        std::filesystem::remove(checkpointFile);
+        m_WriteTime += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - closeStart);
+
+        m_ProcessedOrderCount = orderCount;
+        m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - startTime);
+        m_Status = ProcessingStatus::Complete;
+
+        LOG_INFO("Processing complete. Orders:", m_ProcessedOrderCount, "from cache:", cachedCount,
+                 "Total time:", m_TotalProcessingTime.count(), "μs");
+    }
+
+    // A checkpoint is used only if it was taken over the same input, header
+    // and encoding, with validation in the same state, and every file it
+    // points into still holds what it recorded
+    template<typename Traits>
+    bool OrderProcessor<Traits>::LoadCheckpoint(const std::string& checkpointFile, const std::string& inputFile,
+                                                const std::string& outputFile,
+                                                const CsvParser<Traits>& parser,
+                                                IncrementalCheckpoint& checkpoint) const
     {
+        if (false == checkpoint.Load(checkpointFile))
+        {
+            return false;
+        }
+
+        const auto SizeOf = [](const std::string& filename)
+        {
+            std::error_code error;
+            const uint64_t size = std::filesystem::file_size(filename, error);
+            return error ? 0 : size;
+        };
+
+        const uint64_t context = EncodeCache<Traits>::HashContext(parser.GetHeaderLine(), m_Options.m_NumberFormat,
+                                                                  m_Options.m_EnableInterning);
+        const bool validating = m_Options.m_EnableValidation;
+
+        if (context != checkpoint.m_Context || SizeOf(inputFile) != checkpoint.m_InputSize ||
+            std::filesystem::last_write_time(inputFile).time_since_epoch().count() != checkpoint.m_InputModified ||
+            static_cast<uint64_t>(parser.GetDataEnd() - parser.GetDataBegin()) < checkpoint.m_InputOffset ||
+            SizeOf(outputFile) < checkpoint.m_OutputOffset ||
+            validating != (0 < checkpoint.m_RejectsOffset) ||
+            (true == validating && SizeOf(m_Options.m_RejectsFile) < checkpoint.m_RejectsOffset))
+        {
+            LOG_INFO("Checkpoint does not match this run; starting over");
+            return false;
+        }
+
+        return true;
+    }
+
+    // Takes up to OutputBlockOrders rows from begin and looks each one up in
+    // the cache; returns where the next block starts
+    template<typename Traits>
+    const char* OrderProcessor<Traits>::CollectRows(const char* begin, const char* end,
+                                                    EncodeCache<Traits>& cache,
+                                                    std::vector<CachedRow>& rows) const
+    {
+        rows.clear();
+        const char* current = begin;
+
+        while (current < end && rows.size() < Traits::OutputBlockOrders)
+        {
+            const char* lineEnd = static_cast<const char*>(
+                std::memchr(current, LineDelimiter, static_cast<SizeType>(end - current)));
+            lineEnd = (nullptr == lineEnd) ? end : lineEnd;
+
+            const RowKey key = EncodeCache<Traits>::HashRow(
+                std::string_view(current, static_cast<SizeType>(lineEnd - current)));
+            rows.push_back(CachedRow{current, key, cache.Find(key)});
+            current = std::min(lineEnd + 1, end);
+        }
+
+        return current;
+    }
+
+    template<typename Traits>
+    void OrderProcessor<Traits>::ProcessOrdersStreaming(const std::string& inputFile,
+                                                        const std::string& outputFile)
+    {
+        using Clock = std::chrono::high_resolution_clock;
+
+        auto startTime = Clock::now();
+        const SizeType windowRows = m_Options.m_StreamWindowRows;
+
+        // The fragment tables span all windows, so each name is interned once
+        MessageFragments<Traits> fragments;
         CsvParser<Traits> parser;
+        parser.SetFragments(GetFragmentSink(fragments));
+        LoadInputFile(parser, inputFile);
+
+        if (false == parser.IsMemoryMapped())
+        {
+            LOG_WARNING("Streaming without a memory-mapped input: the whole file stays resident");
+        }
+
+        // Window buffers are reused, so memory is bounded by the largest window
+        OrderVectorType window;
+        window.reserve(windowRows);
+        std::vector<JsonBuilder<Traits>> builders = CreateBuilders(fragments);
+        OutputWriter<Traits> writer = CreateWriter();
+        writer.Open(outputFile);
+
+        OrderValidator<Traits> validator(&m_Instruments, &fragments);
+        m_RejectLog.Rebase(parser.GetDataBegin(), FirstDataLine);
+
+        const char* current = parser.GetDataBegin();
+        const char* end = parser.GetDataEnd();
+        SizeType orderCount = 0;
+        SizeType windowCount = 0;
+
+        while (current < end)
+        {
+            auto parseStart = Clock::now();
+            window.clear();
+            current = parser.ParseLines(current, end, window, windowRows, GetLatencySink(m_ParseLatency));
+            auto parseEnd = Clock::now();
+
+            ValidateOrders(validator, window, current);
+            auto buildStart = Clock::now();
+
+            const SizeType windowBytes = EncodeAndWrite(window, writer, builders);
+
+            // Consumed input pages are no longer needed once encoded
+            parser.ReleaseConsumed(current);
+            auto writeEnd = Clock::now();
+
+            m_ParseTime += std::chrono::duration_cast<std::chrono::microseconds>(parseEnd - parseStart);
+            m_WriteTime += std::chrono::duration_cast<std::chrono::microseconds>(writeEnd - buildStart);
+
+            m_PeakWindowOrderCount = std::max(m_PeakWindowOrderCount, static_cast<SizeType>(window.size()));
+            m_PeakWindowBytes = std::max(m_PeakWindowBytes, windowBytes);
+            orderCount += static_cast<SizeType>(window.size());
+            windowCount++;
+        }
+
+        auto closeStart = Clock::now();
+        writer.Close();
+
+        // EncodeAndWrite accumulated the encoding share of each window
+        m_WriteTime += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - closeStart);
+        m_WriteTime -= m_BuildTime;
+
+        m_ProcessedOrderCount = orderCount;
+        m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - startTime);
+        m_Status = ProcessingStatus::Complete;
+
+        LOG_INFO("Processing complete. Orders:", m_ProcessedOrderCount,
+                "Windows:", windowCount,
+                "Total time:", m_TotalProcessingTime.count(), "μs");
+    }
+
+    template<typename Traits>
+    void OrderProcessor<Traits>::ProcessOrdersParallel(const std::string& inputFile,
+                                                       const std::string& outputFile,
+                                                       SizeType threadCount)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        // Load and parse the header once; workers only see disjoint,
+        // newline-aligned ranges of the shared read-only buffer
+        auto parseStart = std::chrono::high_resolution_clock::now();
+        CsvParser<Traits> parser;
+        LoadInputFile(parser, inputFile);
+
+        std::vector<Chunk> chunks = SplitIntoChunks(parser.GetDataBegin(), parser.GetDataEnd(),
+                                                    threadCount);
+        const std::string_view headerLine = parser.GetHeaderLine();
+
+        const bool recordLatency = m_Options.m_EnableLatencyHistograms;
+        const bool intern = m_Options.m_EnableInterning;
+
+        RunChunks(chunks, [headerLine, recordLatency, intern](Chunk& chunk)
+        {
+            // Reserved by the worker, so the orders are placed on its node
+            chunk.m_Orders.reserve(CsvParser<Traits>::CountLines(chunk.m_Begin, chunk.m_End));
+
+            // Each worker interns into its chunk's own tables
+            CsvParser<Traits>& worker = chunk.m_Parser;
+            worker.SetFragments(true == intern ? &chunk.m_Fragments : nullptr);
+            worker.ParseHeaders(headerLine.data(), headerLine.data() + headerLine.size());
+            worker.ParseLines(chunk.m_Begin, chunk.m_End, chunk.m_Orders,
+                              std::numeric_limits<SizeType>::max(),
+                              true == recordLatency ? &chunk.m_ParseLatency : nullptr);
+        });
+        auto parseEnd = std::chrono::high_resolution_clock::now();
+
+        // Rejected rows are dropped before message IDs are assigned; the
+        // rejects are logged in chunk order, which is input order
+        if (true == m_Options.m_EnableValidation)
+        {
+            const InstrumentTable<Traits>* instruments = &m_Instruments;
+            RunChunks(chunks, [instruments](Chunk& chunk)
+            {
+                OrderValidator<Traits> validator(instruments, &chunk.m_Fragments);
+                validator.Validate(chunk.m_Orders, chunk.m_Rejects);
+            });
+
+            m_RejectLog.Rebase(parser.GetDataBegin(), FirstDataLine);
+            for (const Chunk& chunk : chunks)
+            {
+                m_RejectLog.Write(chunk.m_Rejects, chunk.m_End);
+            }
+            m_ValidateTime = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - parseEnd);
+        }
+
+        // Exclusive prefix sum of the per-chunk row counts keeps message IDs
+        // contiguous and in input order
+        SizeType orderCount = 0;
+        for (Chunk& chunk : chunks)
+        {
+            chunk.m_FirstMessageId = m_MessageIdCounter + static_cast<MessageIdType>(orderCount);
+            orderCount += static_cast<SizeType>(chunk.m_Orders.size());
+        }
+        m_MessageIdCounter += static_cast<MessageIdType>(orderCount);
+
+        LOG_INFO("Parsed", orderCount, "orders in", chunks.size(), "chunks");
+
+        m_Status = ProcessingStatus::Building;
+        auto buildStart = std::chrono::high_resolution_clock::now();
+        const NumberFormat numberFormat = m_Options.m_NumberFormat;
+        RunChunks(chunks, [numberFormat, recordLatency](Chunk& chunk)
+        {
+            // The whole chunk is encoded into one buffer, sized up front by
+            // a pass over its bounds so it is never grown and copied
+            JsonBuilder<Traits> builder(numberFormat);
+            builder.SetFragments(&chunk.m_Fragments);
+            builder.Reserve(builder.MeasureOrders(chunk.m_Orders));
+            EncodeOrders(builder, chunk.m_Orders, chunk.m_FirstMessageId,
+                         true == recordLatency ? &chunk.m_EncodeLatency : nullptr);
+            chunk.m_Builder = std::move(builder);
+        });
+        auto buildEnd = std::chrono::high_resolution_clock::now();
+
+        if (true == recordLatency)
+        {
+            for (const Chunk& chunk : chunks)
+            {
+                m_ParseLatency.Merge(chunk.m_ParseLatency);
+                m_EncodeLatency.Merge(chunk.m_EncodeLatency);
+            }
+        }
+
+        m_Status = ProcessingStatus::Writing;
+        auto writeStart = std::chrono::high_resolution_clock::now();
+        WriteOutputFile(outputFile, chunks);
+        auto writeEnd = std::chrono::high_resolution_clock::now();
+
+        m_ProcessedOrderCount = orderCount;
+        m_ParseTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            parseEnd - parseStart);
+        m_BuildTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            buildEnd - buildStart);
+        m_WriteTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            writeEnd - writeStart);
+        m_TotalProcessingTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            writeEnd - startTime);
+
+        m_Status = ProcessingStatus::Complete;
+
+        LOG_INFO("Processing complete. Orders:", m_ProcessedOrderCount,
+                "Threads:", chunks.size(),
+                "Total time:", m_TotalProcessingTime.count(), "μs");
+    }
+
+    template<typename Traits>
+    std::vector<typename OrderProcessor<Traits>::Chunk>
+    OrderProcessor<Traits>::SplitIntoChunks(const char* begin, const char* end,
+                                            SizeType threadCount) const
+    {
+        const SizeType size = static_cast<SizeType>(end - begin);
+        const SizeType chunkCount = std::max<SizeType>(
+            1, std::min<SizeType>(threadCount, size / Traits::MinParallelChunkSize));
+
+        std::vector<Chunk> chunks;
+        chunks.reserve(chunkCount);
+
+        const char* chunkBegin = begin;
+        for (SizeType index = 1; index <= chunkCount && chunkBegin < end; ++index)
+        {
+            const char* chunkEnd = end;
+
+            // Move each split point forward to the start of the next line
+            if (index < chunkCount)
+            {
+                const char* target = std::max(chunkBegin, begin + size * index / chunkCount);
+                const char* newline = static_cast<const char*>(
+                    std::memchr(target, LineDelimiter, static_cast<SizeType>(end - target)));
+                chunkEnd = (nullptr == newline) ? end : newline + 1;
+            }
+
+            Chunk chunk;
+            chunk.m_Begin = chunkBegin;
+            chunk.m_End = chunkEnd;
+            chunks.push_back(std::move(chunk));
+
+            chunkBegin = chunkEnd;
+        }
+
+        return chunks;
+    }
+
+    template<typename Traits>
+    template<typename Function>
+    void OrderProcessor<Traits>::RunChunks(std::vector<Chunk>& chunks, Function function) const
+    {
+        std::vector<std::exception_ptr> errors(chunks.size());
+        std::vector<std::thread> workers;
+        workers.reserve(chunks.size());
+
+        const auto RunChunk = [this, &chunks, &errors, &function](SizeType index)
+        {
+            try
+            {
+                // Pinned before the chunk allocates, so its buffers are local
+                m_Placement.PlaceWorker(index);
+                function(chunks[index]);
+            }
+            catch (...)
+            {
+                errors[index] = std::current_exception();
+            }
+        };
+
+        // The calling thread takes the first chunk itself
+        for (SizeType index = 1; index < chunks.size(); ++index)
+        {
+            workers.emplace_back(RunChunk, index);
+        }
+
+        if (false == chunks.empty())
+        {
+            RunChunk(0);
+        }
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        for (const auto& error : errors)
+        {
+            if (nullptr != error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    template<typename Traits>
+    typename OrderProcessor<Traits>::SizeType OrderProcessor<Traits>::ResolveThreadCount() const
+    {
+        if (0 == m_Options.m_ThreadCount)
+        {
+            return std::max<SizeType>(1, std::thread::hardware_concurrency());
+        }
+
+        return m_Options.m_ThreadCount;
+    }
+
+    template<typename Traits>
+    void OrderProcessor<Traits>::OpenValidation(uint64_t rejectsOffset, SizeType rejectCount)
+    {
+        if (false == m_Options.m_EnableValidation)
+        {
+            return;
+        }
+
+        // Rejects are logged with their CSV line and row
+        if (InputFormat::Binary == m_Options.m_InputFormat)
+        {
+            LOG_ERROR("Binary input cannot be validated; validate while converting from CSV instead");
+            throw std::runtime_error("Validation needs CSV input");
+        }
+
+        if (true == m_Options.m_InstrumentFile.empty())
+        {
+            LOG_WARNING("No instrument reference data: instrument, amount, tick and advanced checks are skipped");
+        }
+        else
+        {
+            m_Instruments.Load(m_Options.m_InstrumentFile);
+        }
+
+        m_RejectLog.Open(m_Options.m_RejectsFile, rejectsOffset, rejectCount);
+        LOG_INFO("Rejected orders are written to", m_Options.m_RejectsFile);
+    }
+
+    // Drops the orders that fail validation and logs them; orders must be
+    // the rows up to end that follow the reject log's current position
+    template<typename Traits>
+    void OrderProcessor<Traits>::ValidateOrders(OrderValidator<Traits>& validator, OrderVectorType& orders,
+                                                const char* end)
+    {
+        if (false == m_Options.m_EnableValidation)
+        {
+            return;
+        }
+
+        auto validateStart = std::chrono::high_resolution_clock::now();
+        std::vector<Reject> rejects;
+        validator.Validate(orders, rejects);
+        m_RejectLog.Write(rejects, end);
+        m_ValidateTime += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - validateStart);
+    }
+
+    template<typename Traits>
+    void OrderProcessor<Traits>::LoadInputFile(CsvParser<Traits>& parser,
+                                               const std::string& filename) const
+    {
+        parser.SetMemoryMapping(m_Options.m_EnableMemoryMapping);
+
+        if (false == parser.LoadFile(filename))
+        {
+            LOG_ERROR("Failed to load file:", filename);
+            throw std::runtime_error("Failed to load CSV file");
+        }
+
+        if (false == parser.ParseHeader())
+        {
+            throw std::runtime_error("Failed to parse CSV header");
+        }
+    }
+
+    template<typename Traits>
+    typename OrderProcessor<Traits>::OrderVectorType
+    OrderProcessor<Traits>::ParseOrderFile(CsvParser<Traits>& parser, BinaryOrderFile<Traits>& binaryFile,
+                                           const std::string& filename, OrderArena<Traits>& arena)
+    {
+        if (InputFormat::Binary == m_Options.m_InputFormat)
+        {
+            binaryFile.Open(filename);
+            return binaryFile.ReadOrders(parser.GetFragments(), arena.GetResource());
+        }
+
+        parser.SetMemoryMapping(m_Options.m_EnableMemoryMapping);
 
         if (false == parser.LoadFile(filename))
         {
@@ -91,44 +989,161 @@ namespace fischer::deribit
             throw std::runtime_error("Failed to load CSV file");
         }
 
-        LOG_DEBUG("File loaded. Size:", parser.GetFileSize(), "bytes");
-        return parser.ParseOrders();
+        LOG_DEBUG("File loaded. Size:", parser.GetFileSize(), "bytes",
+                  "Mapped:", parser.IsMemoryMapped());
+
+        // Fails the run like LoadInputFile, so every mode treats a file
+        // without a header the same
+        OrderVectorType orders = parser.ParseOrders(GetLatencySink(m_ParseLatency), arena.GetResource());
+        if (ParserState::Error == parser.GetState())
+        {
+            throw std::runtime_error("Failed to parse CSV header");
+        }
+        return orders;
+    }
+
+    template<typename Traits>
+    std::vector<JsonBuilder<Traits>> OrderProcessor<Traits>::CreateBuilders(
+        const MessageFragments<Traits>& fragments) const
+    {
+        // One encode buffer per writer slot
+        std::vector<JsonBuilder<Traits>> builders;
+        builders.reserve(OutputWriter<Traits>::QueueDepth);
+        for (SizeType index = 0; index < OutputWriter<Traits>::QueueDepth; ++index)
+        {
+            builders.emplace_back(m_Options.m_NumberFormat);
+            builders.back().SetFragments(&fragments);
+        }
+        return builders;
+    }
+
+    template<typename Traits>
+    OutputWriter<Traits> OrderProcessor<Traits>::CreateWriter() const
+    {
+        return OutputWriter<Traits>(m_Options.m_OutputBackend, m_Options.m_SyncPolicy,
+                                    m_Options.m_EnableDirectIo, m_Options.m_WriterCpus);
     }
 
     template<typename Traits>
-    std::string OrderProcessor<Traits>::BuildJsonPayload(const std::vector<OrderType>& orders)
+    typename OrderProcessor<Traits>::SizeType
+    OrderProcessor<Traits>::EncodeAndWrite(std::span<const OrderType> orders, OutputWriter<Traits>& writer,
+                                           std::vector<JsonBuilder<Traits>>& builders)
     {
-        JsonBuilder<Traits> builder;
+        SizeType encodedBytes = 0;
+
+        for (SizeType begin = 0; begin < orders.size(); begin += Traits::OutputBlockOrders)
+        {
+            // Waits only if the disk is more than QueueDepth blocks behind
+            JsonBuilder<Traits>& builder = builders[writer.AcquireSlot()];
+
+            auto encodeStart = std::chrono::high_resolution_clock::now();
+            builder.Reset();
+            m_MessageIdCounter = EncodeOrders(builder,
+                                              orders.subspan(begin, std::min<SizeType>(
+                                                  Traits::OutputBlockOrders, orders.size() - begin)),
+                                              m_MessageIdCounter, GetLatencySink(m_EncodeLatency));
+            m_BuildTime += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - encodeStart);
+
+            encodedBytes += builder.GetBufferPosition();
+            writer.Submit(builder.GetView());
+        }
+
+        return encodedBytes;
+    }
+
+    template<typename Traits>
+    typename OrderProcessor<Traits>::MessageIdType
+    OrderProcessor<Traits>::EncodeOrders(JsonBuilder<Traits>& builder, std::span<const OrderType> orders,
+                                         MessageIdType messageId, HistogramType* latency)
+    {
+        if (nullptr == latency)
+        {
+            for (const auto& order : orders)
+            {
+                builder.BuildOrderMessage(order, messageId++);
+            }
+            return messageId;
+        }
 
         for (const auto& order : orders)
         {
-            builder.BuildOrderMessage(order, m_MessageIdCounter++);
+            const uint64_t encodeStart = TscClock::Now();
+            builder.BuildOrderMessage(order, messageId++);
+            latency->Record(TscClock::Now() - encodeStart);
         }
+        return messageId;
+    }
 
-        return builder.GetResult();
+    template<typename Traits>
+    typename OrderProcessor<Traits>::HistogramType*
+    OrderProcessor<Traits>::GetLatencySink(HistogramType& histogram) const
+    {
+        return true == m_Options.m_EnableLatencyHistograms ? &histogram : nullptr;
     }
 
     template<typename Traits>
-    void OrderProcessor<Traits>::WriteOutputFile(const std::string& filename,
-                                                 const std::string& content)
+    MessageFragments<Traits>* OrderProcessor<Traits>::GetFragmentSink(MessageFragments<Traits>& fragments) const
     {
-        std::ofstream file(filename, std::ios::binary);
+        return true == m_Options.m_EnableInterning ? &fragments : nullptr;
+    }
+
+    template<typename Traits>
+    void OrderProcessor<Traits>::WriteLatencyReport(const std::string& filename) const
+    {
+        const double nanosecondsPerTick = TscClock::GetNanosecondsPerTick();
 
+        std::string report;
+        report.append("{\"ns_per_tick\":");
+        char digits[Traits::MaxDoubleStringLength];
+        report.append(digits, std::to_chars(digits, digits + sizeof(digits), nanosecondsPerTick).ptr);
+        report.append(",\"parse\":");
+        m_ParseLatency.AppendJson(report, nanosecondsPerTick);
+        report.append(",\"encode\":");
+        m_EncodeLatency.AppendJson(report, nanosecondsPerTick);
+
+        if (true == IsPacingEnabled())
+        {
+            // Recorded in nanoseconds rather than ticks
+            report.append(",\"release_lateness\":");
+            m_ReleaseLateness.AppendJson(report, 1.0);
+        }
+
+        if (true == HasResponses())
+        {
+            report.append(",\"round_trip\":");
+            m_Responses.GetRoundTrip().AppendJson(report, nanosecondsPerTick);
+        }
+
+        report.append("}\n");
+
+        std::ofstream file(filename, std::ios::binary);
         if (false == file.is_open())
         {
-            LOG_ERROR("Failed to open output file:", filename);
-            throw std::runtime_error("Failed to open output file");
+            LOG_ERROR("Failed to open latency report file:", filename);
+            throw std::runtime_error("Failed to open latency report file");
         }
 
-        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+        file.write(report.data(), static_cast<std::streamsize>(report.size()));
+        LOG_INFO("Latency report written:", filename);
+    }
+
+    template<typename Traits>
+    void OrderProcessor<Traits>::WriteOutputFile(const std::string& filename,
+                                                 const std::vector<Chunk>& chunks)
+    {
+        OutputWriter<Traits> writer = CreateWriter();
+        writer.Open(filename);
 
-        if (false == file.good())
+        for (const Chunk& chunk : chunks)
         {
-            LOG_ERROR("Failed to write output file:", filename);
+            writer.Submit(chunk.m_Builder.GetView());
         }
 
+        writer.Close();
         LOG_INFO("Output written successfully:", filename);
     }
 
     template class OrderProcessor<DeribitTraits>;
+    template class OrderProcessor<DeribitFixedPointTraits>;
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Macro.h"
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Order.h"
+#include "FSHR_DERIBIT_InternTable.h"
+#include "FSHR_DERIBIT_InstrumentTable.h"
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // A row that failed validation; m_Source is the start of the row in the
+    // input buffer
+    struct Reject
+    {
+        const char* m_Source{nullptr};
+        RejectReason m_Reason{RejectReason::None};
+    };
+
+    // Pre-trade checks for what the exchange would otherwise reject after
+    // spending a rate-limit credit on the request. Orders are gathered in
+    // batches of ValidationBatchOrders into columnar arrays, and the numeric
+    // checks run as branch-free loops over those columns so the compiler can
+    // vectorize them.
+    //
+    // The checks that need reference data - known instrument, minimum and lot
+    // size of the amount, tick size of the price, advanced only on options -
+    // are skipped until an instrument table is loaded.
+    template<typename Traits = DeribitTraits>
+    class OrderValidator
+    {
+    public:
+        using OrderType = Order<Traits>;
+        using OrderVectorType = OrderVector<Traits>;
+        using SizeType = typename Traits::SizeType;
+        using TableType = InstrumentTable<Traits>;
+
+        static constexpr SizeType BatchOrders = Traits::ValidationBatchOrders;
+
+        // fragments are the ones the orders were interned into; an interned
+        // instrument name is then looked up once, not once per order
+        OrderValidator(const TableType* instruments, const MessageFragments<Traits>* fragments);
+        RULE_OF_FIVE_MOVABLE(OrderValidator);
+
+        // Removes the failing orders, keeping the others in input order, and
+        // appends a Reject for each of them
+        void Validate(OrderVectorType& orders, std::vector<Reject>& rejects);
+
+        SizeType GetCheckedCount() const { return m_CheckedCount; }
+        SizeType GetRejectedCount() const { return m_RejectedCount; }
+
+    protected:
+        void Gather(const OrderType& order, const TableType* instruments, SizeType slot);
+        void CheckBatch(SizeType count) noexcept;
+        typename TableType::IndexType ResolveInstrument(const OrderType& order, const TableType& instruments);
+
+        // One bit per RejectReason; the lowest set bit is the one reported
+        static constexpr uint32_t FailureBit(RejectReason reason) noexcept
+        {
+            return uint32_t{1} << (static_cast<uint32_t>(reason) - 1);
+        }
+
+    private:
+        // Instrument index per instrument fragment ID; Unresolved until the
+        // name is first looked up
+        static constexpr uint32_t Unresolved = UINT32_MAX;
+
+        const TableType* m_Instruments;
+        const MessageFragments<Traits>* m_Fragments;
+        std::vector<uint32_t> m_InstrumentByFragment;
+        SizeType m_CheckedCount;
+        SizeType m_RejectedCount;
+
+        // Columns of the current batch
+        alignas(64) double m_Amount[BatchOrders];
+        alignas(64) double m_LotSize[BatchOrders];
+        alignas(64) double m_Price[BatchOrders];
+        alignas(64) double m_TickSize[BatchOrders];
+        alignas(64) uint32_t m_Failures[BatchOrders];
+    };
+
+    // CSV of rejected rows - line number, reason, row as written - numbered
+    // by counting newlines from a position whose line is known. Rejects must
+    // be written in input order.
+    template<typename Traits = DeribitTraits>
+    class RejectLog
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+
+        RejectLog() = default;
+        RULE_OF_FIVE_NONMOVABLE(RejectLog);
+
+        // Truncates the file and writes the header line; a resume offset
+        // keeps that many bytes, holding resumeCount rejects, and appends
+        void Open(const std::string& filename, uint64_t resumeOffset = 0, SizeType resumeCount = 0);
+        void Close();
+
+        // The byte at position starts line number line
+        void Rebase(const char* position, SizeType line) noexcept
+        {
+            m_Cursor = position;
+            m_Line = line;
+        }
+
+        // rejects lie between the current position and end, which becomes the
+        // new position; a buffer that moves afterwards must be rebased
+        void Write(std::span<const Reject> rejects, const char* end);
+
+        bool IsOpen() const { return m_File.is_open(); }
+        SizeType GetLine() const { return m_Line; }
+        SizeType GetCount() const { return m_Count; }
+        uint64_t GetOffset() { return static_cast<uint64_t>(m_File.tellp()); }
+
+    private:
+        std::ofstream m_File;
+        std::string m_Buffer;
+        const char* m_Cursor{nullptr};
+        SizeType m_Line{0};
+        SizeType m_Count{0};
+    };
+}
+
+#include <FSHR_DERIBIT_OrderValidator.hxx>
@@ -0,0 +1,293 @@
+#include "FSHR_DERIBIT_OrderValidator.h"
+#include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_NumberFormat.h"
+#include "FSHR_DERIBIT_Utils.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace fischer::deribit
+{
+    template<typename Traits>
+    OrderValidator<Traits>::OrderValidator(const TableType* instruments,
+                                           const MessageFragments<Traits>* fragments)
+        : m_Instruments{instruments}
+        , m_Fragments{fragments}
+        , m_CheckedCount{0}
+        , m_RejectedCount{0}
+    {
+    }
+
+    template<typename Traits>
+    void OrderValidator<Traits>::Validate(OrderVectorType& orders, std::vector<Reject>& rejects)
+    {
+        const TableType* instruments =
+            (nullptr != m_Instruments && true == m_Instruments->IsLoaded()) ? m_Instruments : nullptr;
+        const SizeType orderCount = static_cast<SizeType>(orders.size());
+        SizeType kept = 0;
+
+        for (SizeType begin = 0; begin < orderCount; begin += BatchOrders)
+        {
+            const SizeType count = std::min<SizeType>(BatchOrders, orderCount - begin);
+
+            for (SizeType index = 0; index < count; ++index)
+            {
+                Gather(orders[begin + index], instruments, index);
+            }
+
+            CheckBatch(count);
+
+            // Accepted orders are compacted in place, so nothing is copied
+            // until the first reject
+            for (SizeType index = 0; index < count; ++index)
+            {
+                const uint32_t failures = m_Failures[index];
+                if (0 == failures)
+                {
+                    if (kept != begin + index)
+                    {
+                        orders[kept] = orders[begin + index];
+                    }
+                    kept++;
+                }
+                else
+                {
+                    rejects.push_back(Reject{orders[begin + index].GetRow(),
+                                             static_cast<RejectReason>(std::countr_zero(failures) + 1)});
+                }
+            }
+        }
+
+        m_CheckedCount += orderCount;
+        m_RejectedCount += orderCount - kept;
+        orders.resize(kept);
+    }
+
+    // The checks that need text comparisons or a table lookup are made here,
+    // one order at a time; the numeric ones only have their operands laid
+    // out in the batch columns
+    template<typename Traits>
+    void OrderValidator<Traits>::Gather(const OrderType& order, const TableType* instruments, SizeType slot)
+    {
+        uint32_t failures = 0;
+
+        const std::string_view direction = order.GetText(order.m_DirectionText);
+        if (MethodBuy != direction && MethodSell != direction)
+        {
+            failures |= FailureBit(RejectReason::InvalidDirection);
+        }
+
+        if (true == order.Has(FieldIndex::Type) &&
+            order.GetText(order.m_TypeText) != utils::OrderTypeToString(order.m_Type))
+        {
+            failures |= FailureBit(RejectReason::InvalidType);
+        }
+
+        const InstrumentSpec* spec = nullptr;
+        if (false == order.Has(FieldIndex::InstrumentName))
+        {
+            failures |= FailureBit(RejectReason::MissingInstrument);
+        }
+        else if (nullptr != instruments)
+        {
+            const auto index = ResolveInstrument(order, *instruments);
+            if (TableType::NoInstrument == index)
+            {
+                failures |= FailureBit(RejectReason::UnknownInstrument);
+            }
+            else
+            {
+                spec = &instruments->GetSpec(index);
+            }
+        }
+
+        // An absent type is a limit order, as on the exchange
+        const deribit::OrderType type = order.m_Type;
+        const bool needsPrice = deribit::OrderType::Limit == type || deribit::OrderType::StopLimit == type ||
+                                deribit::OrderType::TakeLimit == type;
+        const bool needsTriggerPrice = deribit::OrderType::StopLimit == type ||
+                                       deribit::OrderType::StopMarket == type ||
+                                       deribit::OrderType::TakeLimit == type ||
+                                       deribit::OrderType::TakeMarket == type;
+        const bool needsTriggerOffset = deribit::OrderType::TrailingStop == type;
+
+        if (true == needsPrice && false == order.Has(FieldIndex::Price))
+        {
+            failures |= FailureBit(RejectReason::MissingPrice);
+        }
+
+        if ((true == needsTriggerPrice || true == needsTriggerOffset) &&
+            (TriggerType::None == order.m_Trigger ||
+             (true == needsTriggerPrice && false == order.Has(FieldIndex::TriggerPrice)) ||
+             (true == needsTriggerOffset && false == order.Has(FieldIndex::TriggerOffset))))
+        {
+            failures |= FailureBit(RejectReason::InvalidTrigger);
+        }
+
+        if (true == order.Has(FieldIndex::Advanced) && nullptr != spec && InstrumentKind::Option != spec->m_Kind)
+        {
+            failures |= FailureBit(RejectReason::AdvancedNotOption);
+        }
+
+        // The amount is in base units; an order sized in contracts only is
+        // converted with the instrument's contract size
+        double amount = utils::ToDouble(order.m_Amount);
+        if (false == (0.0 < amount) && true == order.Has(FieldIndex::Contracts))
+        {
+            const double contractSize = (nullptr != spec && 0.0 < spec->m_ContractSize) ? spec->m_ContractSize : 1.0;
+            amount = utils::ToDouble(order.m_Contracts) * contractSize;
+        }
+
+        m_Failures[slot] = failures;
+        m_Amount[slot] = amount;
+        m_LotSize[slot] = nullptr != spec ? spec->m_MinTradeAmount : 0.0;
+        m_Price[slot] = true == order.Has(FieldIndex::Price) ? utils::ToDouble(order.m_Price) : 0.0;
+        m_TickSize[slot] = nullptr != spec ? spec->m_TickSize : 0.0;
+    }
+
+    // A lot or tick size of 0 (no reference data) disables its checks. Prices
+    // are checked against the instrument's base tick size only, which never
+    // rejects a price that the coarser tick_size_steps of options allow.
+    template<typename Traits>
+    void OrderValidator<Traits>::CheckBatch(SizeType count) noexcept
+    {
+        constexpr double Tolerance = Traits::ValidationTolerance;
+
+        for (SizeType index = 0; index < count; ++index)
+        {
+            const double amount = m_Amount[index];
+            const double lotSize = m_LotSize[index];
+            const double tickSize = m_TickSize[index];
+            const double lots = amount / (0.0 < lotSize ? lotSize : 1.0);
+            const double ticks = m_Price[index] / (0.0 < tickSize ? tickSize : 1.0);
+
+            const uint32_t missingAmount = !(0.0 < amount);
+            const uint32_t belowMinimum = amount < lotSize;
+            const uint32_t offLot = (0.0 < lotSize) & (std::fabs(lots - std::nearbyint(lots)) > Tolerance * lots);
+            const uint32_t offTick = (0.0 < tickSize) &
+                                     (std::fabs(ticks - std::nearbyint(ticks)) > Tolerance * std::fabs(ticks));
+
+            m_Failures[index] |= (missingAmount * FailureBit(RejectReason::MissingAmount)) |
+                                 (belowMinimum * FailureBit(RejectReason::AmountBelowMinimum)) |
+                                 (offLot * FailureBit(RejectReason::AmountNotMultiple)) |
+                                 (offTick * FailureBit(RejectReason::PriceNotOnTick));
+        }
+    }
+
+    template<typename Traits>
+    typename OrderValidator<Traits>::TableType::IndexType
+    OrderValidator<Traits>::ResolveInstrument(const OrderType& order, const TableType& instruments)
+    {
+        const std::string_view name = order.GetText(order.m_InstrumentName);
+        const uint16_t fragment = order.m_InstrumentFragment;
+
+        if (nullptr == m_Fragments || 0 == fragment)
+        {
+            return instruments.Find(name);
+        }
+
+        if (m_InstrumentByFragment.size() <= fragment)
+        {
+            m_InstrumentByFragment.resize(fragment + 1U, Unresolved);
+        }
+
+        uint32_t& index = m_InstrumentByFragment[fragment];
+        if (Unresolved == index)
+        {
+            index = instruments.Find(name);
+        }
+        return static_cast<typename TableType::IndexType>(index);
+    }
+
+    template<typename Traits>
+    void RejectLog<Traits>::Open(const std::string& filename, uint64_t resumeOffset, SizeType resumeCount)
+    {
+        if (0 < resumeOffset)
+        {
+            std::filesystem::resize_file(filename, resumeOffset);
+            m_File.open(filename, std::ios::binary | std::ios::in | std::ios::out);
+            m_File.seekp(0, std::ios::end);
+        }
+        else
+        {
+            m_File.open(filename, std::ios::binary | std::ios::trunc);
+        }
+
+        if (false == m_File.is_open())
+        {
+            LOG_ERROR("Failed to open rejects file:", filename);
+            throw std::runtime_error("Failed to open rejects file");
+        }
+
+        if (0 == resumeOffset)
+        {
+            m_File.write(RejectsHeader.data(), static_cast<std::streamsize>(RejectsHeader.size()));
+        }
+        m_Count = resumeCount;
+    }
+
+    template<typename Traits>
+    void RejectLog<Traits>::Close()
+    {
+        if (true == m_File.is_open())
+        {
+            m_File.close();
+        }
+    }
+
+    template<typename Traits>
+    void RejectLog<Traits>::Write(std::span<const Reject> rejects, const char* end)
+    {
+        m_Buffer.clear();
+
+        for (const Reject& reject : rejects)
+        {
+            m_Line += static_cast<SizeType>(std::count(m_Cursor, reject.m_Source, LineDelimiter));
+            m_Cursor = reject.m_Source;
+
+            const char* rowEnd = static_cast<const char*>(
+                std::memchr(reject.m_Source, LineDelimiter, static_cast<SizeType>(end - reject.m_Source)));
+            rowEnd = (nullptr == rowEnd) ? end : rowEnd;
+            if (rowEnd > reject.m_Source && CarriageReturn == rowEnd[-1])
+            {
+                --rowEnd;
+            }
+
+            char digits[utils::MaxUInt64Digits];
+            m_Buffer.append(digits, utils::FormatUInt64(digits, m_Line));
+            m_Buffer.push_back(FieldDelimiter);
+            m_Buffer.append(utils::RejectReasonToString(reject.m_Reason));
+            m_Buffer.push_back(FieldDelimiter);
+            m_Buffer.append(reject.m_Source, static_cast<SizeType>(rowEnd - reject.m_Source));
+            m_Buffer.push_back(LineDelimiter);
+        }
+
+        m_Line += static_cast<SizeType>(std::count(m_Cursor, end, LineDelimiter));
+        m_Cursor = end;
+        m_Count += static_cast<SizeType>(rejects.size());
+
+        if (false == m_Buffer.empty())
+        {
+            // Flushed per call, so a resident process's rejects appear as
+            // they happen
+            m_File.write(m_Buffer.data(), static_cast<std::streamsize>(m_Buffer.size()));
+            m_File.flush();
+        }
+
+        if (false == m_File.good())
+        {
+            LOG_ERROR("Failed to write rejects file");
+            throw std::runtime_error("Failed to write rejects file");
+        }
+    }
+
+    template class OrderValidator<DeribitTraits>;
+    template class OrderValidator<DeribitFixedPointTraits>;
+    template class RejectLog<DeribitTraits>;
+    template class RejectLog<DeribitFixedPointTraits>;
+}
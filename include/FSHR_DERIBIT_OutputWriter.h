@@ -0,0 +1,591 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_IoUring.h"
+#include "FSHR_DERIBIT_ThreadPlacement.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_Utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fischer::deribit
+{
+    // Writes a file as a sequence of encoded blocks while the caller encodes
+    // the next one. Blocks rotate through QueueDepth slots: AcquireSlot waits
+    // until the write last submitted from the next slot has completed and
+    // returns its index, so a caller keeping one encode buffer per slot never
+    // overwrites bytes that are still being written. Data passed to Submit
+    // must stay valid until its slot is acquired again or Close returns.
+    //
+    // With direct I/O, blocks are copied into aligned staging buffers and only
+    // whole alignment units are written; the tail is carried into the next
+    // block, and Close writes the padded last unit and truncates the padding.
+    template<typename Traits = DeribitTraits>
+    class OutputWriter
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+
+        static constexpr SizeType QueueDepth = Traits::OutputQueueDepth;
+        static constexpr SizeType Alignment = Traits::DirectIoAlignment;
+
+        // Writes run on cpus where given: the writer thread is pinned to
+        // them, as are the kernel workers of the io_uring ring
+        explicit OutputWriter(OutputBackend backend = Traits::DefaultOutputBackend,
+                              SyncPolicy syncPolicy = Traits::DefaultSyncPolicy,
+                              bool directIo = false,
+                              std::vector<int> cpus = {})
+            : m_Backend{backend}
+            , m_SyncPolicy{syncPolicy}
+            , m_DirectIo{directIo}
+            , m_Cpus{std::move(cpus)}
+        {
+        }
+
+        OutputWriter(const OutputWriter&) = delete;
+        OutputWriter& operator=(const OutputWriter&) = delete;
+
+        ~OutputWriter() noexcept
+        {
+            try
+            {
+                Close();
+            }
+            catch (const std::exception&)
+            {
+                // Already logged where the write failed
+            }
+        }
+
+        // A resume offset keeps that many bytes of an existing file and
+        // continues after them; it is not combined with direct I/O
+        void Open(const std::string& filename, uint64_t resumeOffset = 0)
+        {
+            Close();
+
+            const int Flags = O_WRONLY | O_CREAT | O_CLOEXEC | (0 == resumeOffset ? O_TRUNC : 0);
+            constexpr mode_t Mode = 0644;
+
+            if (true == m_DirectIo && 0 < resumeOffset)
+            {
+                LOG_WARNING("Resuming output without O_DIRECT");
+                m_DirectIo = false;
+            }
+
+            if (true == m_DirectIo)
+            {
+                m_Descriptor = ::open(filename.c_str(), Flags | O_DIRECT, Mode);
+                if (0 > m_Descriptor && EINVAL == errno)
+                {
+                    LOG_WARNING("O_DIRECT is not supported for", filename, "- using buffered writes");
+                    m_DirectIo = false;
+                }
+            }
+
+            if (0 > m_Descriptor)
+            {
+                m_Descriptor = ::open(filename.c_str(), Flags, Mode);
+            }
+
+            if (0 > m_Descriptor)
+            {
+                LOG_ERROR("Failed to open output file:", filename, std::strerror(errno));
+                throw std::runtime_error("Failed to open output file");
+            }
+
+            if (0 < resumeOffset && 0 != ::ftruncate(m_Descriptor, static_cast<off_t>(resumeOffset)))
+            {
+                LOG_ERROR("Failed to truncate output file:", filename, std::strerror(errno));
+                ::close(m_Descriptor);
+                m_Descriptor = -1;
+                throw std::runtime_error("Failed to open output file");
+            }
+
+            m_Filename = filename;
+            m_NextSlot = 0;
+            m_FileOffset = resumeOffset;
+            m_BytesWritten = resumeOffset;
+            m_CarrySize = 0;
+            m_SubmittedCount = 0;
+            m_CompletedCount = 0;
+            m_Error = 0;
+            m_ErrorReported = false;
+
+            if (OutputBackend::IoUring == m_Backend &&
+                false == m_Ring.Open(static_cast<uint32_t>(QueueDepth * 2)))
+            {
+                LOG_WARNING("io_uring is unavailable - writing from a writer thread");
+                m_Backend = OutputBackend::Thread;
+            }
+
+            if (OutputBackend::IoUring == m_Backend && false == m_Cpus.empty() &&
+                false == m_Ring.SetWorkerAffinity(m_Cpus))
+            {
+                LOG_DEBUG("io_uring worker affinity is not supported by this kernel");
+            }
+
+            if (OutputBackend::Thread == m_Backend)
+            {
+                m_Thread = std::jthread([this](std::stop_token stopToken)
+                {
+                    if (false == m_Cpus.empty() && false == ThreadPlacement::PinCurrentThread(m_Cpus))
+                    {
+                        LOG_WARNING("Failed to pin the writer thread");
+                    }
+                    RunWriter(stopToken);
+                });
+            }
+
+            LOG_DEBUG("Output writer opened:", filename, "backend:", utils::OutputBackendToString(m_Backend),
+                      "direct:", m_DirectIo);
+        }
+
+        // Blocks until the slot the next Submit will use is free again
+        SizeType AcquireSlot()
+        {
+            if (OutputBackend::IoUring == m_Backend)
+            {
+                while (0 < m_Slots[m_NextSlot].m_Pending)
+                {
+                    ReapCompletions(true);
+                }
+            }
+            else if (OutputBackend::Thread == m_Backend)
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this] { return m_SubmittedCount - m_CompletedCount < QueueDepth; });
+            }
+
+            ThrowOnError();
+            return m_NextSlot;
+        }
+
+        // Queues data for writing after everything submitted before it
+        void Submit(std::string_view data)
+        {
+            const SizeType slotIndex = AcquireSlot();
+            Slot& slot = m_Slots[slotIndex];
+
+            const char* bytes = data.data();
+            SizeType size = static_cast<SizeType>(data.size());
+            m_BytesWritten += data.size();
+
+            if (true == m_DirectIo)
+            {
+                const SizeType total = m_CarrySize + size;
+                char* staging = slot.ReserveStaging(total);
+                std::memcpy(staging, m_Carry.data(), m_CarrySize);
+                std::memcpy(staging + m_CarrySize, data.data(), data.size());
+
+                size = total & ~(Alignment - 1);
+                m_CarrySize = total - size;
+                std::memcpy(m_Carry.data(), staging + size, m_CarrySize);
+                bytes = staging;
+            }
+
+            if (0 == size)
+            {
+                return;
+            }
+
+            slot.m_Data = bytes;
+            slot.m_Size = size;
+            slot.m_Offset = m_FileOffset;
+            m_FileOffset += size;
+            m_NextSlot = (m_NextSlot + 1) % QueueDepth;
+
+            Dispatch(slotIndex);
+        }
+
+        // Waits until everything submitted is in the file, short of the
+        // carried direct I/O tail; throws if a write failed
+        void Flush()
+        {
+            if (0 <= m_Descriptor)
+            {
+                WaitForWrites();
+            }
+
+            ThrowOnError();
+        }
+
+        // Waits for every write, completes direct I/O, applies the sync
+        // policy and closes the file; throws if any write failed
+        void Close()
+        {
+            if (0 > m_Descriptor)
+            {
+                return;
+            }
+
+            WaitForWrites();
+            if (OutputBackend::Thread == m_Backend)
+            {
+                m_Thread.request_stop();
+                m_Thread.join();
+            }
+
+            if (true == m_DirectIo && 0 < m_CarrySize && 0 == m_Error)
+            {
+                // The last partial unit is written padded, then cut back
+                char* staging = m_Slots[m_NextSlot].ReserveStaging(Alignment);
+                std::memcpy(staging, m_Carry.data(), m_CarrySize);
+                std::memset(staging + m_CarrySize, 0, Alignment - m_CarrySize);
+
+                iovec vector{staging, Alignment};
+                SetError(WriteFully(m_Descriptor, &vector, 1, m_FileOffset));
+                if (0 == m_Error && 0 != ::ftruncate(m_Descriptor, static_cast<off_t>(m_BytesWritten)))
+                {
+                    SetError(errno);
+                }
+            }
+
+            if (SyncPolicy::None != m_SyncPolicy && 0 == m_Error && 0 != ::fdatasync(m_Descriptor))
+            {
+                SetError(errno);
+            }
+
+            if (0 != ::close(m_Descriptor))
+            {
+                SetError(errno);
+            }
+
+            m_Descriptor = -1;
+            m_Ring.Close();
+
+            ThrowOnError();
+            LOG_DEBUG("Output writer closed:", m_Filename, "bytes:", m_BytesWritten);
+        }
+
+        OutputBackend GetBackend() const { return m_Backend; }
+        bool IsDirectIo() const { return m_DirectIo; }
+        uint64_t GetBytesWritten() const { return m_BytesWritten; }
+
+    private:
+        struct FreeDeleter
+        {
+            void operator()(char* buffer) const noexcept { std::free(buffer); }
+        };
+
+        struct Slot
+        {
+            const char* m_Data{nullptr};
+            SizeType m_Size{0};
+            uint64_t m_Offset{0};
+            SizeType m_Pending{0};          // io_uring operations in flight
+            std::unique_ptr<char, FreeDeleter> m_Staging;
+            SizeType m_StagingCapacity{0};
+
+            char* ReserveStaging(SizeType size)
+            {
+                if (size > m_StagingCapacity)
+                {
+                    const SizeType capacity = (size + Alignment - 1) & ~(Alignment - 1);
+                    char* buffer = static_cast<char*>(std::aligned_alloc(Alignment, capacity));
+                    if (nullptr == buffer)
+                    {
+                        throw std::bad_alloc();
+                    }
+                    m_Staging.reset(buffer);
+                    m_StagingCapacity = capacity;
+                }
+                return m_Staging.get();
+            }
+        };
+
+        // io_uring writes are capped so the length fits the 32-bit field;
+        // the remainder is resubmitted like any short write
+        static constexpr SizeType MaxRingWriteSize = SizeType{1} << 30;
+        static constexpr uint64_t DataSyncTag = uint64_t{1} << 63;
+
+        void Dispatch(SizeType slotIndex)
+        {
+            Slot& slot = m_Slots[slotIndex];
+
+            switch (m_Backend)
+            {
+            case OutputBackend::IoUring:
+                QueueRingWrite(slotIndex);
+                SubmitRing();
+                break;
+
+            case OutputBackend::Thread:
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_SubmittedCount++;
+                m_Condition.notify_all();
+                break;
+            }
+
+            default:
+            {
+                iovec vector{const_cast<char*>(slot.m_Data), slot.m_Size};
+                int error = WriteFully(m_Descriptor, &vector, 1, slot.m_Offset);
+                if (0 == error && SyncPolicy::EveryWrite == m_SyncPolicy && 0 != ::fdatasync(m_Descriptor))
+                {
+                    error = errno;
+                }
+                SetError(error);
+                ThrowOnError();
+                break;
+            }
+            }
+        }
+
+        void QueueRingWrite(SizeType slotIndex)
+        {
+            Slot& slot = m_Slots[slotIndex];
+            const auto length = static_cast<uint32_t>(std::min(slot.m_Size, MaxRingWriteSize));
+
+            if (true == m_Ring.PrepareWrite(m_Descriptor, slot.m_Data, length, slot.m_Offset, slotIndex))
+            {
+                slot.m_Pending++;
+                return;
+            }
+
+            // The ring holds two entries per slot, so this is not expected
+            WriteSlotSynchronously(slot);
+        }
+
+        void SubmitRing()
+        {
+            const int result = m_Ring.Submit(0);
+            if (0 > result)
+            {
+                SetError(-result);
+            }
+        }
+
+        void ReapCompletions(bool wait)
+        {
+            if (true == wait)
+            {
+                const int result = m_Ring.Submit(1);
+                if (0 > result)
+                {
+                    // Nothing will complete: give up on the writes in flight
+                    SetError(-result);
+                    for (Slot& slot : m_Slots)
+                    {
+                        slot.m_Pending = 0;
+                    }
+                    return;
+                }
+            }
+
+            uint64_t userData = 0;
+            int32_t result = 0;
+            bool queued = false;
+
+            while (true == m_Ring.PopCompletion(userData, result))
+            {
+                Slot& slot = m_Slots[userData & ~DataSyncTag];
+                slot.m_Pending--;
+
+                if (0 != (userData & DataSyncTag))
+                {
+                    SetError(0 > result ? -result : 0);
+                    continue;
+                }
+
+                if (0 >= result)
+                {
+                    // Retried once on this thread, e.g. on kernels without
+                    // IORING_OP_WRITE
+                    WriteSlotSynchronously(slot);
+                    continue;
+                }
+
+                slot.m_Data += result;
+                slot.m_Size -= static_cast<SizeType>(result);
+                slot.m_Offset += static_cast<uint64_t>(result);
+
+                if (0 < slot.m_Size)
+                {
+                    QueueRingWrite(static_cast<SizeType>(userData));
+                    queued = true;
+                }
+                else if (SyncPolicy::EveryWrite == m_SyncPolicy &&
+                         true == m_Ring.PrepareDataSync(m_Descriptor, userData | DataSyncTag))
+                {
+                    slot.m_Pending++;
+                    queued = true;
+                }
+            }
+
+            if (true == queued)
+            {
+                SubmitRing();
+            }
+        }
+
+        void WriteSlotSynchronously(Slot& slot)
+        {
+            iovec vector{const_cast<char*>(slot.m_Data), slot.m_Size};
+            SetError(WriteFully(m_Descriptor, &vector, 1, slot.m_Offset));
+            slot.m_Size = 0;
+        }
+
+        void WaitForWrites()
+        {
+            if (OutputBackend::IoUring == m_Backend)
+            {
+                for (const Slot& slot : m_Slots)
+                {
+                    while (0 < slot.m_Pending)
+                    {
+                        ReapCompletions(true);
+                    }
+                }
+            }
+            else if (OutputBackend::Thread == m_Backend)
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Condition.wait(lock, [this] { return m_CompletedCount == m_SubmittedCount; });
+            }
+        }
+
+        // Consecutive blocks are contiguous in the file, so the writer thread
+        // hands everything queued since its last pass to one pwritev
+        void RunWriter(std::stop_token stopToken)
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+
+            while (true == m_Condition.wait(lock, stopToken,
+                                            [this] { return m_CompletedCount < m_SubmittedCount; }))
+            {
+                const uint64_t first = m_CompletedCount;
+                const uint64_t last = m_SubmittedCount;
+                lock.unlock();
+
+                std::array<iovec, QueueDepth> vectors;
+                int count = 0;
+                for (uint64_t sequence = first; sequence < last; ++sequence)
+                {
+                    const Slot& slot = m_Slots[sequence % QueueDepth];
+                    vectors[count++] = iovec{const_cast<char*>(slot.m_Data), slot.m_Size};
+                }
+
+                int error = WriteFully(m_Descriptor, vectors.data(), count, m_Slots[first % QueueDepth].m_Offset);
+                if (0 == error && SyncPolicy::EveryWrite == m_SyncPolicy && 0 != ::fdatasync(m_Descriptor))
+                {
+                    error = errno;
+                }
+
+                lock.lock();
+                if (0 == m_Error)
+                {
+                    m_Error = error;
+                }
+                m_CompletedCount = last;
+                m_Condition.notify_all();
+            }
+        }
+
+        // Writes every byte of the vectors, retrying short writes; returns 0
+        // or an errno
+        static int WriteFully(int descriptor, iovec* vectors, int count, uint64_t offset) noexcept
+        {
+            while (0 < count)
+            {
+                const ssize_t written = ::pwritev(descriptor, vectors, count, static_cast<off_t>(offset));
+                if (0 > written)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+                    return errno;
+                }
+
+                offset += static_cast<uint64_t>(written);
+                size_t remaining = static_cast<size_t>(written);
+                while (0 < count && remaining >= vectors->iov_len)
+                {
+                    remaining -= vectors->iov_len;
+                    ++vectors;
+                    --count;
+                }
+
+                if (0 < count)
+                {
+                    if (0 == written)
+                    {
+                        return EIO;
+                    }
+                    vectors->iov_base = static_cast<char*>(vectors->iov_base) + remaining;
+                    vectors->iov_len -= remaining;
+                }
+            }
+            return 0;
+        }
+
+        void SetError(int error)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (0 == m_Error)
+            {
+                m_Error = error;
+            }
+        }
+
+        void ThrowOnError()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (0 != m_Error)
+            {
+                if (false == m_ErrorReported)
+                {
+                    LOG_ERROR("Failed to write output file:", m_Filename, std::strerror(m_Error));
+                    m_ErrorReported = true;
+                }
+                throw std::runtime_error("Failed to write output file");
+            }
+        }
+
+    private:
+        OutputBackend m_Backend;
+        SyncPolicy m_SyncPolicy;
+        bool m_DirectIo;
+        int m_Descriptor{-1};
+        std::string m_Filename;
+
+        std::array<Slot, QueueDepth> m_Slots;
+        SizeType m_NextSlot{0};
+        uint64_t m_FileOffset{0};           // where the next block lands
+        uint64_t m_BytesWritten{0};         // logical size, excluding padding
+        std::array<char, Alignment> m_Carry{};
+        SizeType m_CarrySize{0};
+
+        std::vector<int> m_Cpus;
+        IoUring m_Ring;
+
+        // Writer thread handoff; m_Error is shared by all backends
+        std::mutex m_Mutex;
+        std::condition_variable_any m_Condition;
+        uint64_t m_SubmittedCount{0};
+        uint64_t m_CompletedCount{0};
+        int m_Error{0};
+        bool m_ErrorReported{false};
+        std::jthread m_Thread;
+    };
+}
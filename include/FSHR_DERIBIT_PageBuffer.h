@@ -0,0 +1,225 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_ThreadPlacement.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fischer::deribit
+{
+    // Byte buffer for file contents and encoded output. Buffers smaller than
+    // HugePageSize are ordinary heap arrays. Larger ones are anonymous
+    // mappings, so a buffer spanning megabytes can be backed by 2 MiB pages
+    // instead of 4 KiB ones and take a few hundred times fewer TLB entries:
+    //
+    //   Off          heap arrays at every size
+    //   Transparent  mappings aligned to HugePageSize and advised with
+    //                MADV_HUGEPAGE, for transparent huge pages
+    //   Explicit     MAP_HUGETLB pages from the reserved hugetlbfs pool,
+    //                Transparent when the pool cannot cover the buffer
+    //
+    // A mapping made by a thread placed with memory binding is bound to the
+    // thread's NUMA node before any page is touched. Mapped buffers do not
+    // go through operator new, so AllocationCounter does not see them.
+    class PageBuffer
+    {
+    public:
+        static constexpr size_t HugePageSize = 2 * 1024 * 1024;
+
+        PageBuffer() = default;
+
+        // The contents are left uninitialized, like make_unique_for_overwrite
+        explicit PageBuffer(size_t size)
+        {
+            const HugePages hugePages = GetHugePages();
+            if (HugePages::Off != hugePages && HugePageSize <= size &&
+                true == Map(size, HugePages::Explicit == hugePages))
+            {
+                return;
+            }
+
+            m_Heap = std::make_unique_for_overwrite<char[]>(size);
+            m_Data = m_Heap.get();
+        }
+
+        PageBuffer(const PageBuffer&) = delete;
+        PageBuffer& operator=(const PageBuffer&) = delete;
+
+        PageBuffer(PageBuffer&& other) noexcept
+            : m_Heap{std::move(other.m_Heap)}
+            , m_Data{std::exchange(other.m_Data, nullptr)}
+            , m_MappedSize{std::exchange(other.m_MappedSize, 0)}
+        {
+        }
+
+        PageBuffer& operator=(PageBuffer&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                m_Heap = std::move(other.m_Heap);
+                m_Data = std::exchange(other.m_Data, nullptr);
+                m_MappedSize = std::exchange(other.m_MappedSize, 0);
+            }
+            return *this;
+        }
+
+        ~PageBuffer() noexcept
+        {
+            Reset();
+        }
+
+        void Reset() noexcept
+        {
+            if (0 < m_MappedSize)
+            {
+                ::munmap(m_Data, m_MappedSize);
+            }
+
+            m_Heap.reset();
+            m_Data = nullptr;
+            m_MappedSize = 0;
+        }
+
+        char* Get() const noexcept { return m_Data; }
+        bool IsMapped() const noexcept { return 0 < m_MappedSize; }
+
+        // Process-wide; applies to buffers allocated afterwards
+        static void SetHugePages(HugePages hugePages) noexcept
+        {
+            s_HugePages.store(hugePages, std::memory_order_relaxed);
+        }
+
+        static HugePages GetHugePages() noexcept { return s_HugePages.load(std::memory_order_relaxed); }
+
+    protected:
+        static size_t RoundUp(size_t size) noexcept
+        {
+            return (size + HugePageSize - 1) / HugePageSize * HugePageSize;
+        }
+
+        bool Map(size_t size, bool explicitPages) noexcept
+        {
+            const size_t mappedSize = RoundUp(size);
+            constexpr int Protection = PROT_READ | PROT_WRITE;
+            constexpr int Flags = MAP_PRIVATE | MAP_ANONYMOUS;
+            void* address = MAP_FAILED;
+
+            if (true == explicitPages)
+            {
+                // Reserves the pages up front, so an empty pool fails here
+                // rather than faulting later
+                address = ::mmap(nullptr, mappedSize, Protection, Flags | MAP_HUGETLB, -1, 0);
+            }
+
+            if (MAP_FAILED == address)
+            {
+                // Over-map by a huge page and trim both ends to alignment
+                void* reserved = ::mmap(nullptr, mappedSize + HugePageSize, Protection, Flags, -1, 0);
+                if (MAP_FAILED == reserved)
+                {
+                    return false;
+                }
+
+                char* const begin = static_cast<char*>(reserved);
+                char* const aligned = begin + (HugePageSize - reinterpret_cast<uintptr_t>(begin) % HugePageSize) %
+                                              HugePageSize;
+                if (begin < aligned)
+                {
+                    ::munmap(begin, static_cast<size_t>(aligned - begin));
+                }
+                ::munmap(aligned + mappedSize, static_cast<size_t>(begin + HugePageSize - aligned));
+
+                address = aligned;
+#ifdef MADV_HUGEPAGE
+                ::madvise(address, mappedSize, MADV_HUGEPAGE);
+#endif
+            }
+
+            // Advice only - a failed binding leaves the pages to first touch
+            const int node = ThreadPlacement::GetMemoryNode();
+            if (0 <= node && node < static_cast<int>(sizeof(unsigned long) * 8))
+            {
+                const unsigned long nodeMask = 1UL << node;
+                ::syscall(__NR_mbind, address, mappedSize, MPOL_PREFERRED, &nodeMask, sizeof(nodeMask) * 8 + 1, 0);
+            }
+
+            m_Data = static_cast<char*>(address);
+            m_MappedSize = mappedSize;
+            return true;
+        }
+
+    private:
+        std::unique_ptr<char[]> m_Heap;
+        char* m_Data{nullptr};
+        size_t m_MappedSize{0};
+
+        static inline std::atomic<HugePages> s_HugePages{DeribitTraits::DefaultHugePages};
+    };
+
+    // Memory resource that hands out a PageBuffer for every request of at
+    // least HugePageSize, so the order arenas' large blocks get huge pages
+    // and node binding too; smaller requests go to the default resource
+    class PageResource : public std::pmr::memory_resource
+    {
+    public:
+        PageResource() = default;
+
+        PageResource(const PageResource&) = delete;
+        PageResource& operator=(const PageResource&) = delete;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            if (PageBuffer::HugePageSize <= bytes && PageBuffer::HugePageSize >= alignment &&
+                HugePages::Off != PageBuffer::GetHugePages())
+            {
+                // Mappings are huge-page aligned; a heap fallback may not be
+                PageBuffer buffer(bytes);
+                if (true == buffer.IsMapped())
+                {
+                    return m_Buffers.emplace_back(std::move(buffer)).Get();
+                }
+            }
+
+            return std::pmr::get_default_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void* pointer, size_t bytes, size_t alignment) override
+        {
+            const auto buffer = std::find_if(m_Buffers.begin(), m_Buffers.end(), [pointer](const PageBuffer& candidate)
+            {
+                return pointer == candidate.Get();
+            });
+
+            if (m_Buffers.end() == buffer)
+            {
+                std::pmr::get_default_resource()->deallocate(pointer, bytes, alignment);
+                return;
+            }
+
+            m_Buffers.erase(buffer);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+
+    private:
+        std::vector<PageBuffer> m_Buffers;
+    };
+}
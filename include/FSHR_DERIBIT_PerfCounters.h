@@ -0,0 +1,121 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fischer::deribit
+{
+    // Hardware event counts of the process from perf_event_open(2): data TLB
+    // lookups and misses, and memory loads by the node serving them. The
+    // counters are inherited by threads started after Open, so opening them
+    // before a run counts its workers too. Only user-space events are
+    // counted, which perf_event_paranoid 2 still allows. An event the
+    // kernel, the CPU or the hypervisor does not provide stays unavailable.
+    class PerfCounters
+    {
+    public:
+        static constexpr size_t EventCount = static_cast<size_t>(PerfEvent::MaxEvents);
+
+        PerfCounters()
+        {
+            m_Descriptors.fill(-1);
+        }
+
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        ~PerfCounters() noexcept
+        {
+            for (const int descriptor : m_Descriptors)
+            {
+                if (0 <= descriptor)
+                {
+                    ::close(descriptor);
+                }
+            }
+        }
+
+        // Opens and starts every available counter; returns how many opened
+        size_t Open()
+        {
+            size_t opened = 0;
+
+            for (size_t event = 0; event < EventCount; ++event)
+            {
+                perf_event_attr attributes{};
+                attributes.type = PERF_TYPE_HW_CACHE;
+                attributes.size = sizeof(attributes);
+                attributes.config = GetConfig(static_cast<PerfEvent>(event));
+                attributes.disabled = 1;
+                attributes.inherit = 1;
+                attributes.exclude_kernel = 1;
+                attributes.exclude_hv = 1;
+
+                m_Descriptors[event] = static_cast<int>(::syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+                if (0 <= m_Descriptors[event])
+                {
+                    ::ioctl(m_Descriptors[event], PERF_EVENT_IOC_ENABLE, 0);
+                    ++opened;
+                }
+            }
+
+            return opened;
+        }
+
+        void Stop()
+        {
+            for (const int descriptor : m_Descriptors)
+            {
+                if (0 <= descriptor)
+                {
+                    ::ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+                }
+            }
+        }
+
+        // Includes the threads that have exited since Open
+        std::optional<uint64_t> Read(PerfEvent event) const
+        {
+            const int descriptor = m_Descriptors[static_cast<size_t>(event)];
+            uint64_t value = 0;
+
+            if (0 > descriptor || static_cast<ssize_t>(sizeof(value)) != ::read(descriptor, &value, sizeof(value)))
+            {
+                return std::nullopt;
+            }
+
+            return value;
+        }
+
+    protected:
+        static constexpr uint64_t GetConfig(PerfEvent event) noexcept
+        {
+            constexpr uint64_t Load = PERF_COUNT_HW_CACHE_OP_READ << 8;
+            constexpr uint64_t Access = PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16;
+            constexpr uint64_t Miss = PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+
+            switch (event)
+            {
+            case PerfEvent::TlbLoads:
+                return PERF_COUNT_HW_CACHE_DTLB | Load | Access;
+            case PerfEvent::TlbLoadMisses:
+                return PERF_COUNT_HW_CACHE_DTLB | Load | Miss;
+            case PerfEvent::NodeLoads:
+                return PERF_COUNT_HW_CACHE_NODE | Load | Access;
+            default:
+                return PERF_COUNT_HW_CACHE_NODE | Load | Miss;
+            }
+        }
+
+    private:
+        std::array<int, EventCount> m_Descriptors;
+    };
+}
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_Decimal.h"
+
 #include <cstdint>
 #include <cstddef>
+#include <memory_resource>
 #include <string_view>
 #include <type_traits>
 
@@ -28,6 +32,7 @@ namespace fischer::deribit
         static constexpr SizeType MaxDoubleStringLength = 32;
         static constexpr SizeType MaxInt64StringLength = 20;
         static constexpr int DoublePrecision = 10;
+        static constexpr NumberFormat DefaultNumberFormat = NumberFormat::Compatible;
 
         // Protocol Configuration
         static constexpr std::string_view ProtocolName = "Deribit";
@@ -35,15 +40,101 @@ namespace fischer::deribit
         static constexpr MessageIdType InitialMessageId = 5275;
 
         // Performance Tuning
-        static constexpr bool EnableMemoryMapping = false;  // Can be enabled later
+        static constexpr bool EnableMemoryMapping = true;   // Falls back to read() if mmap fails
         static constexpr bool EnableVectorReserve = true;
         static constexpr bool EnableBufferPreallocation = true;
 
+        // Allocation: order vectors allocate through AllocatorType, and each
+        // parse batch reserves its rows from one OrderArena that is released
+        // in one shot; without the arena they use the default resource
+        template<typename T>
+        using AllocatorType = std::pmr::polymorphic_allocator<T>;
+        static constexpr bool EnableOrderArena = true;
+        static constexpr bool EnableAllocationCounters = true;   // with COUNT_GLOBAL_ALLOCATIONS()
+
+        // Interning: distinct instrument names and directions per table; the
+        // JSON fragment of each is rendered once and copied into every message
+        static constexpr bool EnableInterning = true;
+        static constexpr SizeType InternTableCapacity = 4096;
+
+        // Pre-trade Validation: off unless requested; orders are checked in
+        // columnar batches, and tick and lot multiples are accepted within a
+        // relative tolerance of the floating-point reference data
+        static constexpr bool EnableValidation = false;
+        static constexpr SizeType ValidationBatchOrders = 256;
+        static constexpr SizeType InstrumentTableCapacity = 32768;
+        static constexpr double ValidationTolerance = 1e-9;
+
+        // Incremental Processing: encoded bodies are cached per row content,
+        // and a checkpoint is saved every CheckpointBlocks output blocks
+        static constexpr bool EnableIncremental = false;
+        static constexpr SizeType CheckpointBlocks = 8;
+        static constexpr SizeType CacheWriteBufferSize = 1 << 20;
+
+        // Parallel Processing (a thread count of 0 means one per hardware thread)
+        static constexpr SizeType DefaultThreadCount = 1;
+        static constexpr SizeType MinParallelChunkSize = 256 * 1024;
+
+        // Batch: input files are split or packed into tasks of about equal
+        // size, BatchTasksPerWorker per worker where the input allows and at
+        // most BatchTaskBytes each; per-file ID ranges are DefaultIdRangeSize
+        // IDs long
+        static constexpr SizeType BatchTaskBytes = 8 * 1024 * 1024;
+        static constexpr SizeType BatchTasksPerWorker = 4;
+        static constexpr SizeType DefaultIdRangeSize = 1000000000;
+
+        // Memory: buffers of at least HugePageSize are mapped, backed by huge
+        // pages as DefaultHugePages says (see PageBuffer)
+        static constexpr HugePages DefaultHugePages = HugePages::Transparent;
+
+        // Streaming: rows parsed, encoded and written per window
+        static constexpr SizeType DefaultStreamWindowRows = 65536;
+
+        // Output: encoded blocks are handed to the writer while the next block
+        // is encoded, rotating through OutputQueueDepth buffers. O_DIRECT
+        // writes are staged in buffers aligned to DirectIoAlignment.
+        static constexpr OutputBackend DefaultOutputBackend = OutputBackend::IoUring;
+        static constexpr SyncPolicy DefaultSyncPolicy = SyncPolicy::None;
+        static constexpr SizeType OutputQueueDepth = 2;
+        static constexpr SizeType OutputBlockOrders = 8192;
+        static constexpr SizeType DirectIoAlignment = 4096;
+
+        // Daemon: bytes requested per read of a continuous input stream
+        static constexpr SizeType DaemonReadSize = 64 * 1024;
+
+        // WebSocket: frames handed to the socket per sendmsg (at most IOV_MAX),
+        // and how long connecting and the closing handshake may take
+        static constexpr SizeType WebSocketBatchFrames = 512;
+        static constexpr int WebSocketTimeoutMilliseconds = 5000;
+
+        // Pacing: paced output is released under a token bucket holding
+        // DefaultPacingBurst messages unless configured; waits sleep until
+        // PacingSpinNanoseconds before the release time and spin the rest
+        static constexpr SizeType DefaultPacingBurst = 1;
+        static constexpr int64_t PacingSpinNanoseconds = 200000;
+
+        // Latency Instrumentation: per-order histograms, off unless requested;
+        // 2^6 sub-buckets per power of two keep values within ~1.6%
+        static constexpr bool EnableLatencyHistograms = false;
+        static constexpr uint32_t LatencySubBucketBits = 6;
+
         // Logger Configuration
         static constexpr SizeType MaxLogMessageLength = 1024;
         static constexpr SizeType LogBufferSize = 8192;
         static constexpr bool EnableFileLogging = true;
         static constexpr bool EnableConsoleLogging = true;
+#if defined(DEBUG)
+        static constexpr LogLevel MinCompiledLogLevel = LogLevel::Debug;
+#else
+        static constexpr LogLevel MinCompiledLogLevel = LogLevel::Info;
+#endif
+
+        // Asynchronous Logging: per-thread rings of fixed-size records drained
+        // by a background thread
+        static constexpr bool EnableAsyncLogging = true;
+        static constexpr SizeType AsyncLogRingCapacity = 1024;
+        static constexpr SizeType AsyncLogRecordSize = 256;
+        static constexpr SizeType AsyncLogPollMicroseconds = 1000;
 
         // CSV Parser Configuration
         static constexpr char FieldDelimiter = ',';
@@ -56,6 +147,20 @@ namespace fischer::deribit
         static_assert(BufferGrowthFactor >= 2, "Growth factor must be at least 2");
         static_assert(MaxOrderCount > 0, "Max order count must be positive");
         static_assert(DoublePrecision > 0 && DoublePrecision <= 17, "Invalid double precision");
+        static_assert(OutputQueueDepth > 0 && OutputBlockOrders > 0, "Output pipeline must not be empty");
+        static_assert(0 == (DirectIoAlignment & (DirectIoAlignment - 1)), "Alignment must be a power of two");
+        static_assert(ValidationBatchOrders > 0, "Validation batch must not be empty");
+        static_assert(WebSocketBatchFrames > 0 && WebSocketBatchFrames <= 1024, "Batch must fit in IOV_MAX");
+        static_assert(CheckpointBlocks > 0, "Checkpoints need a positive interval");
+    };
+
+    // Prices and amounts as exact scaled integers: parsed straight from the CSV
+    // text into mantissa and scale and emitted by integer-to-text, with no
+    // floating point on either side
+    struct DeribitFixedPointTraits : DeribitTraits
+    {
+        using AmountType = Decimal;
+        using PriceType = Decimal;
     };
 
     template<typename Traits>
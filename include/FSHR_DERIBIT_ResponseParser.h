@@ -0,0 +1,317 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_Utils.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace fischer::deribit
+{
+    // Reads the few members of a Deribit JSON-RPC response that the ingest
+    // needs - id, result.order.order_state, result.order.order_id and
+    // error.code/message - in one pass over the text, without building a
+    // document or allocating. Only the objects on those paths are entered;
+    // every other value, nested or not, is skipped by matching brackets
+    // and jumping over strings with memchr. A result that is itself an
+    // order, as cancel and get_order_state return, is read the same way.
+    //
+    // The scan checks the structure it walks through, not full JSON syntax.
+    // String values are returned as raw views into the text, escapes left
+    // undecoded; Deribit's states, order IDs and error messages have none.
+    template<typename Traits = DeribitTraits>
+    class ResponseParser
+    {
+    public:
+        using MessageIdType = typename Traits::MessageIdType;
+
+        struct Response
+        {
+            MessageIdType m_Id{0};
+            bool m_HasId{false};            // false for a notification or a non-numeric id
+            bool m_IsError{false};
+            OrderState m_State{OrderState::Unknown};
+            std::string_view m_OrderId;
+            int64_t m_ErrorCode{0};
+            std::string_view m_ErrorMessage;
+        };
+
+        // False if text is not an object or is cut short
+        static bool Parse(std::string_view text, Response& response) noexcept
+        {
+            response = Response{};
+
+            const char* const end = text.data() + text.size();
+            const char* position = SkipSpace(text.data(), end);
+            if (end == position || '{' != *position)
+            {
+                return false;
+            }
+
+            return nullptr != ParseObject(position + 1, end, Scope::Root, response);
+        }
+
+    protected:
+        enum class Scope : uint8_t
+        {
+            Root,
+            Result,
+            Order,
+            Error
+        };
+
+        enum class Member : uint8_t
+        {
+            Other,
+            Id,
+            Result,
+            Error,
+            Order,
+            State,
+            OrderId,
+            Code,
+            Message
+        };
+
+        static Member Classify(Scope scope, std::string_view key) noexcept
+        {
+            switch (scope)
+            {
+            case Scope::Root:
+                if ("id" == key) return Member::Id;
+                if ("result" == key) return Member::Result;
+                if ("error" == key) return Member::Error;
+                break;
+            case Scope::Result:
+                if ("order" == key) return Member::Order;
+                [[fallthrough]];
+            case Scope::Order:
+                if ("order_state" == key) return Member::State;
+                if ("order_id" == key) return Member::OrderId;
+                break;
+            case Scope::Error:
+                if ("code" == key) return Member::Code;
+                if ("message" == key) return Member::Message;
+                break;
+            }
+            return Member::Other;
+        }
+
+        // Parses the members of an object whose opening brace was consumed;
+        // returns the position after its closing brace, or nullptr
+        static const char* ParseObject(const char* position, const char* end, Scope scope,
+                                       Response& response) noexcept
+        {
+            position = SkipSpace(position, end);
+            if (end != position && '}' == *position)
+            {
+                return position + 1;
+            }
+
+            while (end != position && '"' == *position)
+            {
+                const char* keyEnd = FindQuote(position + 1, end);
+                if (nullptr == keyEnd)
+                {
+                    return nullptr;
+                }
+
+                const std::string_view key(position + 1, static_cast<size_t>(keyEnd - position - 1));
+                position = SkipSpace(keyEnd + 1, end);
+                if (end == position || ':' != *position)
+                {
+                    return nullptr;
+                }
+
+                position = SkipSpace(position + 1, end);
+                if (end == position)
+                {
+                    return nullptr;
+                }
+
+                position = ParseMember(position, end, Classify(scope, key), response);
+                position = nullptr == position ? nullptr : SkipSpace(position, end);
+                if (nullptr == position || end == position)
+                {
+                    return nullptr;
+                }
+
+                if ('}' == *position)
+                {
+                    return position + 1;
+                }
+                if (',' != *position)
+                {
+                    return nullptr;
+                }
+                position = SkipSpace(position + 1, end);
+            }
+
+            return nullptr;
+        }
+
+        // Reads or skips the value at position; returns the position after it
+        static const char* ParseMember(const char* position, const char* end, Member member,
+                                       Response& response) noexcept
+        {
+            switch (member)
+            {
+            case Member::Id:
+                return ParseInteger(position, end, response.m_Id, response.m_HasId);
+            case Member::Code:
+            {
+                bool parsed = false;
+                return ParseInteger(position, end, response.m_ErrorCode, parsed);
+            }
+            case Member::Result:
+            case Member::Order:
+                if ('{' == *position)
+                {
+                    return ParseObject(position + 1, end, Member::Result == member ? Scope::Result : Scope::Order,
+                                       response);
+                }
+                break;
+            case Member::Error:
+                response.m_IsError = true;
+                if ('{' == *position)
+                {
+                    return ParseObject(position + 1, end, Scope::Error, response);
+                }
+                break;
+            case Member::State:
+            case Member::OrderId:
+            case Member::Message:
+                if ('"' == *position)
+                {
+                    const char* close = FindQuote(position + 1, end);
+                    if (nullptr == close)
+                    {
+                        return nullptr;
+                    }
+
+                    const std::string_view value(position + 1, static_cast<size_t>(close - position - 1));
+                    if (Member::State == member)
+                    {
+                        response.m_State = utils::StringToOrderState(value);
+                    }
+                    else if (Member::OrderId == member)
+                    {
+                        response.m_OrderId = value;
+                    }
+                    else
+                    {
+                        response.m_ErrorMessage = value;
+                    }
+                    return close + 1;
+                }
+                break;
+            case Member::Other:
+                break;
+            }
+
+            return SkipValue(position, end);
+        }
+
+        // A value that is not an integer, such as null, is skipped
+        template<typename Integer>
+        static const char* ParseInteger(const char* position, const char* end, Integer& value, bool& parsed) noexcept
+        {
+            const std::from_chars_result result = std::from_chars(position, end, value);
+            parsed = std::errc{} == result.ec && (end == result.ptr || false == IsScalarByte(*result.ptr));
+            return true == parsed ? result.ptr : SkipValue(position, end);
+        }
+
+        static const char* SkipValue(const char* position, const char* end) noexcept
+        {
+            if ('"' == *position)
+            {
+                const char* close = FindQuote(position + 1, end);
+                return nullptr == close ? nullptr : close + 1;
+            }
+
+            if ('{' == *position || '[' == *position)
+            {
+                size_t depth = 0;
+                for (; end != position; ++position)
+                {
+                    switch (*position)
+                    {
+                    case '"':
+                        position = FindQuote(position + 1, end);
+                        if (nullptr == position)
+                        {
+                            return nullptr;
+                        }
+                        break;
+                    case '{':
+                    case '[':
+                        depth++;
+                        break;
+                    case '}':
+                    case ']':
+                        if (0 == --depth)
+                        {
+                            return position + 1;
+                        }
+                        break;
+                    default:
+                        break;
+                    }
+                }
+                return nullptr;
+            }
+
+            // Numbers and literals run up to the next delimiter
+            const char* const start = position;
+            while (end != position && true == IsScalarByte(*position))
+            {
+                ++position;
+            }
+            return start == position ? nullptr : position;
+        }
+
+        // The closing quote of a string whose opening quote precedes begin;
+        // a quote is escaped if an odd run of backslashes precedes it
+        static const char* FindQuote(const char* begin, const char* end) noexcept
+        {
+            for (const char* position = begin; end != position;)
+            {
+                const char* quote = static_cast<const char*>(
+                    std::memchr(position, '"', static_cast<size_t>(end - position)));
+                if (nullptr == quote)
+                {
+                    return nullptr;
+                }
+
+                const char* run = quote;
+                while ('\\' == run[-1])
+                {
+                    --run;
+                }
+                if (0 == (quote - run) % 2)
+                {
+                    return quote;
+                }
+                position = quote + 1;
+            }
+            return nullptr;
+        }
+
+        static bool IsScalarByte(char c) noexcept
+        {
+            return ',' != c && '}' != c && ']' != c && ' ' != c && '\n' != c && '\r' != c && '\t' != c;
+        }
+
+        static const char* SkipSpace(const char* position, const char* end) noexcept
+        {
+            while (end != position && (' ' == *position || '\n' == *position || '\r' == *position || '\t' == *position))
+            {
+                ++position;
+            }
+            return position;
+        }
+    };
+}
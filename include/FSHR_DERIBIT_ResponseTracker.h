@@ -0,0 +1,116 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Enums.h"
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_LatencyHistogram.h"
+#include "FSHR_DERIBIT_ResponseParser.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Matches responses to the requests of a run and records each round
+    // trip. A run's message IDs are consecutive from the first one sent, so
+    // a request's send time is kept at its ID's offset from it and a
+    // response finds its request with one subtraction. A matched entry is
+    // cleared, so an answer to a request already answered, or to an ID
+    // never sent, counts as unmatched. Times are TscClock ticks.
+    template<typename Traits = DeribitTraits>
+    class ResponseTracker
+    {
+    public:
+        using MessageIdType = typename Traits::MessageIdType;
+        using SizeType = typename Traits::SizeType;
+        using HistogramType = LatencyHistogram<Traits>;
+        using ParserType = ResponseParser<Traits>;
+
+        static constexpr size_t StateCount = static_cast<size_t>(OrderState::MaxStates);
+
+        // Requests are numbered from firstId in the order they are sent
+        void Start(MessageIdType firstId, SizeType expectedCount)
+        {
+            m_FirstId = firstId;
+            m_SentTicks.clear();
+            m_SentTicks.reserve(expectedCount);
+            m_MatchedCount = 0;
+            m_ErrorCount = 0;
+            m_UnmatchedCount = 0;
+            m_UnrecognizedCount = 0;
+            m_StateCounts.fill(0);
+            m_FirstError.clear();
+            m_RoundTrip.Reset();
+        }
+
+        // The next count requests were handed to the transport at ticks
+        void OnSent(SizeType count, uint64_t ticks)
+        {
+            m_SentTicks.insert(m_SentTicks.end(), count, ticks);
+        }
+
+        // Parses a message from the peer received at ticks and, if it answers
+        // an outstanding request, records the round trip; false otherwise
+        bool OnMessage(std::string_view text, uint64_t ticks)
+        {
+            typename ParserType::Response response;
+            if (false == ParserType::Parse(text, response) || false == response.m_HasId)
+            {
+                m_UnrecognizedCount++;
+                return false;
+            }
+
+            if (response.m_Id < m_FirstId || static_cast<uint64_t>(response.m_Id - m_FirstId) >= m_SentTicks.size() ||
+                0 == m_SentTicks[static_cast<size_t>(response.m_Id - m_FirstId)])
+            {
+                m_UnmatchedCount++;
+                return false;
+            }
+
+            uint64_t& sentTicks = m_SentTicks[static_cast<size_t>(response.m_Id - m_FirstId)];
+            m_RoundTrip.Record(ticks - sentTicks);
+            sentTicks = 0;
+            m_MatchedCount++;
+
+            if (true == response.m_IsError)
+            {
+                if (0 == m_ErrorCount++)
+                {
+                    m_FirstError.assign(std::to_string(response.m_ErrorCode)).append(" ").append(
+                        response.m_ErrorMessage);
+                }
+            }
+            else
+            {
+                m_StateCounts[static_cast<size_t>(response.m_State)]++;
+            }
+            return true;
+        }
+
+        uint64_t GetSentCount() const { return m_SentTicks.size(); }
+        uint64_t GetMatchedCount() const { return m_MatchedCount; }
+        uint64_t GetOutstandingCount() const { return m_SentTicks.size() - m_MatchedCount; }
+        uint64_t GetErrorCount() const { return m_ErrorCount; }
+        uint64_t GetUnmatchedCount() const { return m_UnmatchedCount; }
+        uint64_t GetUnrecognizedCount() const { return m_UnrecognizedCount; }    // not a response with an ID
+        uint64_t GetStateCount(OrderState state) const { return m_StateCounts[static_cast<size_t>(state)]; }
+
+        // "code message" of the first error response; empty if none
+        const std::string& GetFirstError() const { return m_FirstError; }
+
+        const HistogramType& GetRoundTrip() const { return m_RoundTrip; }
+
+    private:
+        MessageIdType m_FirstId{Traits::InitialMessageId};
+        std::vector<uint64_t> m_SentTicks;      // 0 once answered
+        uint64_t m_MatchedCount{0};
+        uint64_t m_ErrorCount{0};
+        uint64_t m_UnmatchedCount{0};
+        uint64_t m_UnrecognizedCount{0};
+        std::array<uint64_t, StateCount> m_StateCounts{};
+        std::string m_FirstError;
+        HistogramType m_RoundTrip;
+    };
+}
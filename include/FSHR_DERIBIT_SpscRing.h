@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace fischer::deribit
+{
+    // Bounded lock-free single-producer/single-consumer ring. The producer
+    // fills a slot in place between TryAcquire and Publish, so records are
+    // never copied on the hot side. Each index is cached on the opposite
+    // side to avoid touching the other thread's cache line on every call.
+    template<typename Record, size_t Capacity>
+    class SpscRing
+    {
+    public:
+        static_assert(0 != Capacity && 0 == (Capacity & (Capacity - 1)), "Capacity must be a power of two");
+
+        SpscRing() = default;
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        // Producer: returns the next free slot, or nullptr when the ring is full
+        Record* TryAcquire() noexcept
+        {
+            const size_t tail = m_Tail.load(std::memory_order_relaxed);
+            if (tail - m_CachedHead == Capacity)
+            {
+                m_CachedHead = m_Head.load(std::memory_order_acquire);
+                if (tail - m_CachedHead == Capacity)
+                {
+                    return nullptr;
+                }
+            }
+            return &m_Records[tail & (Capacity - 1)];
+        }
+
+        // Producer: makes the slot returned by TryAcquire visible to the consumer
+        void Publish() noexcept
+        {
+            m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer: returns the oldest record, or nullptr when the ring is empty
+        const Record* Front() noexcept
+        {
+            const size_t head = m_Head.load(std::memory_order_relaxed);
+            if (head == m_CachedTail)
+            {
+                m_CachedTail = m_Tail.load(std::memory_order_acquire);
+                if (head == m_CachedTail)
+                {
+                    return nullptr;
+                }
+            }
+            return &m_Records[head & (Capacity - 1)];
+        }
+
+        // Consumer: releases the record returned by Front
+        void Pop() noexcept
+        {
+            m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        bool IsEmpty() const noexcept
+        {
+            return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+        }
+
+    private:
+        alignas(64) std::atomic<size_t> m_Head{0};
+        size_t m_CachedTail{0};
+        alignas(64) std::atomic<size_t> m_Tail{0};
+        size_t m_CachedHead{0};
+        alignas(64) std::array<Record, Capacity> m_Records{};
+    };
+}
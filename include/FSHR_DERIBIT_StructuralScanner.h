@@ -0,0 +1,158 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace fischer::deribit
+{
+    // Delimiter bitmasks for one 64-byte block: bit i is set when byte i of the
+    // block is a field or line delimiter respectively
+    struct StructuralMasks
+    {
+        uint64_t m_Field{0};
+        uint64_t m_Line{0};
+    };
+
+    // Walks a buffer block by block and yields the position of every field and
+    // line delimiter in order. The buffer does not need to be NUL-terminated or
+    // padded; the final partial block is scanned from a zero-filled copy.
+    template<typename Traits = DeribitTraits>
+    class StructuralScanner
+    {
+    public:
+        static constexpr size_t BlockSize = 64;
+
+        // Scans exactly BlockSize readable bytes
+        static StructuralMasks ScanBlock(const char* block) noexcept
+        {
+            StructuralMasks masks;
+
+#if defined(__AVX2__)
+            const __m256i fieldDelimiter = _mm256_set1_epi8(Traits::FieldDelimiter);
+            const __m256i lineDelimiter = _mm256_set1_epi8(Traits::LineDelimiter);
+
+            const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+            const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+            const auto MoveMask = [](__m256i value) noexcept
+            {
+                return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(value)));
+            };
+
+            masks.m_Field = MoveMask(_mm256_cmpeq_epi8(low, fieldDelimiter)) |
+                            (MoveMask(_mm256_cmpeq_epi8(high, fieldDelimiter)) << 32);
+            masks.m_Line = MoveMask(_mm256_cmpeq_epi8(low, lineDelimiter)) |
+                           (MoveMask(_mm256_cmpeq_epi8(high, lineDelimiter)) << 32);
+#elif defined(__SSE2__)
+            const __m128i fieldDelimiter = _mm_set1_epi8(Traits::FieldDelimiter);
+            const __m128i lineDelimiter = _mm_set1_epi8(Traits::LineDelimiter);
+
+            for (size_t lane = 0; lane < 4; ++lane)
+            {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + lane * 16));
+                const size_t shift = lane * 16;
+
+                masks.m_Field |= static_cast<uint64_t>(static_cast<uint16_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, fieldDelimiter)))) << shift;
+                masks.m_Line |= static_cast<uint64_t>(static_cast<uint16_t>(
+                    _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lineDelimiter)))) << shift;
+            }
+#else
+            for (size_t i = 0; i < BlockSize; ++i)
+            {
+                masks.m_Field |= static_cast<uint64_t>(Traits::FieldDelimiter == block[i]) << i;
+                masks.m_Line |= static_cast<uint64_t>(Traits::LineDelimiter == block[i]) << i;
+            }
+#endif
+
+            return masks;
+        }
+
+        StructuralScanner(const char* begin, const char* end) noexcept
+            : m_Begin{begin}
+            , m_Size{static_cast<size_t>(end - begin)}
+            , m_BlockOffset{0}
+            , m_Pending{0}
+            , m_LineMask{0}
+        {
+            LoadBlock();
+        }
+
+        // Next delimiter at or after the scan position, or the end of the buffer
+        const char* Next() noexcept
+        {
+            while (0 == m_Pending)
+            {
+                m_BlockOffset += BlockSize;
+                if (m_BlockOffset >= m_Size)
+                {
+                    m_BlockOffset = m_Size;
+                    return m_Begin + m_Size;
+                }
+                LoadBlock();
+            }
+
+            const unsigned bit = static_cast<unsigned>(std::countr_zero(m_Pending));
+            m_Pending &= m_Pending - 1;
+            return m_Begin + m_BlockOffset + bit;
+        }
+
+        // Whether a position returned by Next() terminates the line
+        bool IsLineEnd(const char* position) const noexcept
+        {
+            const size_t offset = static_cast<size_t>(position - m_Begin);
+            if (offset >= m_Size)
+            {
+                return true;
+            }
+            return 0 != ((m_LineMask >> (offset - m_BlockOffset)) & 1U);
+        }
+
+        // Drops any remaining delimiters up to and including the next line end
+        const char* SkipLine() noexcept
+        {
+            const char* position = Next();
+            while (false == IsLineEnd(position))
+            {
+                position = Next();
+            }
+            return position;
+        }
+
+    private:
+        void LoadBlock() noexcept
+        {
+            const size_t remaining = m_Size - m_BlockOffset;
+            StructuralMasks masks;
+
+            if (remaining >= BlockSize)
+            {
+                masks = ScanBlock(m_Begin + m_BlockOffset);
+            }
+            else if (0 < remaining)
+            {
+                alignas(BlockSize) char padded[BlockSize] = {};
+                std::memcpy(padded, m_Begin + m_BlockOffset, remaining);
+                masks = ScanBlock(padded);
+            }
+
+            m_Pending = masks.m_Field | masks.m_Line;
+            m_LineMask = masks.m_Line;
+        }
+
+    private:
+        const char* m_Begin;
+        size_t m_Size;
+        size_t m_BlockOffset;
+        uint64_t m_Pending;
+        uint64_t m_LineMask;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "FSHR_DERIBIT_Logger.h"
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace fischer::deribit
+{
+    // Where worker and writer threads run, and where worker buffers live.
+    // Worker w is pinned to the worker CPU at w modulo the list, so workers
+    // wrap around when there are more of them than CPUs; writer threads are
+    // allowed the whole writer CPU set. With memory binding, the large
+    // buffers a pinned worker allocates (PageBuffer) are bound to its CPU's
+    // NUMA node before their first touch. Other memory is left to the
+    // kernel's first-touch placement, which puts each page on the node of
+    // the thread that first writes it - the pinned worker, for the orders
+    // and output it produces.
+    class ThreadPlacement
+    {
+    public:
+        ThreadPlacement() = default;
+
+        ThreadPlacement(std::vector<int> workerCpus, std::vector<int> writerCpus, bool bindMemory)
+            : m_WorkerCpus{std::move(workerCpus)}
+            , m_WriterCpus{std::move(writerCpus)}
+            , m_BindMemory{bindMemory}
+        {
+        }
+
+        bool IsEnabled() const { return false == m_WorkerCpus.empty(); }
+        const std::vector<int>& GetWriterCpus() const { return m_WriterCpus; }
+
+        // Pins the calling thread as worker; a no-op without worker CPUs
+        void PlaceWorker(size_t worker) const
+        {
+            if (true == m_WorkerCpus.empty())
+            {
+                return;
+            }
+
+            const int cpu = m_WorkerCpus[worker % m_WorkerCpus.size()];
+            if (false == PinCurrentThread({cpu}))
+            {
+                LOG_WARNING("Failed to pin worker", worker, "to CPU", cpu);
+                return;
+            }
+
+            s_MemoryNode = true == m_BindMemory ? GetNodeOfCpu(cpu) : -1;
+        }
+
+        // The NUMA node the calling thread's large buffers are bound to, or
+        // -1 to leave them to first touch
+        static int GetMemoryNode() noexcept { return s_MemoryNode; }
+
+        // Parses a CPU list as /sys and taskset write them ("0-3,8,10-11");
+        // returns false if it is malformed or empty
+        static bool ParseCpuList(std::string_view text, std::vector<int>& cpus)
+        {
+            cpus.clear();
+
+            while (false == text.empty())
+            {
+                const std::string_view range = text.substr(0, text.find(','));
+                text.remove_prefix(std::min(text.size(), range.size() + 1));
+
+                int first = 0;
+                const char* const end = range.data() + range.size();
+                std::from_chars_result result = std::from_chars(range.data(), end, first);
+                int last = first;
+
+                if (std::errc{} == result.ec && end != result.ptr && '-' == *result.ptr)
+                {
+                    result = std::from_chars(result.ptr + 1, end, last);
+                }
+
+                if (std::errc{} != result.ec || end != result.ptr || 0 > first || first > last || CPU_SETSIZE <= last)
+                {
+                    return false;
+                }
+
+                for (int cpu = first; cpu <= last; ++cpu)
+                {
+                    cpus.push_back(cpu);
+                }
+            }
+
+            return false == cpus.empty();
+        }
+
+        // True if the process may run on every CPU of cpus
+        static bool IsAllowed(const std::vector<int>& cpus)
+        {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (0 != ::sched_getaffinity(0, sizeof(allowed), &allowed))
+            {
+                return false;
+            }
+
+            return std::all_of(cpus.begin(), cpus.end(), [&allowed](int cpu) { return CPU_ISSET(cpu, &allowed); });
+        }
+
+        // Restricts the calling thread to cpus; false if the kernel refuses,
+        // as it does for CPUs outside the process's cgroup
+        static bool PinCurrentThread(const std::vector<int>& cpus)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : cpus)
+            {
+                CPU_SET(cpu, &set);
+            }
+
+            return 0 == ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+        }
+
+        // The NUMA node of a CPU, from the nodeN link sysfs keeps under the
+        // CPU; 0 where the kernel has no NUMA support
+        static int GetNodeOfCpu(int cpu)
+        {
+            std::error_code error;
+            const std::filesystem::path directory = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+
+            for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+            {
+                const std::string name = entry.path().filename().string();
+                int node = 0;
+
+                if (true == name.starts_with("node") &&
+                    std::errc{} == std::from_chars(name.data() + 4, name.data() + name.size(), node).ec)
+                {
+                    return node;
+                }
+            }
+
+            return 0;
+        }
+
+    private:
+        std::vector<int> m_WorkerCpus;
+        std::vector<int> m_WriterCpus;
+        bool m_BindMemory{false};
+
+        static inline thread_local int s_MemoryNode{-1};
+    };
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace fischer::deribit
+{
+    // Raw timestamp counter for per-order latency. Now() is a single rdtsc on
+    // x86 (steady_clock nanoseconds elsewhere); ticks are converted to
+    // nanoseconds only when results are reported, using a rate calibrated once
+    // against steady_clock. Assumes an invariant TSC, as on every x86 CPU of
+    // the last decade.
+    class TscClock
+    {
+    public:
+        static constexpr std::chrono::milliseconds CalibrationPeriod{20};
+
+        static uint64_t Now() noexcept
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        // Calibrated on first use; blocks the caller for CalibrationPeriod
+        static double GetNanosecondsPerTick()
+        {
+            static const double nanosecondsPerTick = Calibrate();
+            return nanosecondsPerTick;
+        }
+
+        static double ToNanoseconds(uint64_t ticks)
+        {
+            return static_cast<double>(ticks) * GetNanosecondsPerTick();
+        }
+
+    private:
+        static double Calibrate()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            const auto steadyStart = std::chrono::steady_clock::now();
+            const uint64_t tickStart = Now();
+
+            std::this_thread::sleep_for(CalibrationPeriod);
+
+            const uint64_t tickEnd = Now();
+            const auto steadyEnd = std::chrono::steady_clock::now();
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(steadyEnd - steadyStart);
+            if (tickEnd <= tickStart)
+            {
+                return 1.0;
+            }
+            return static_cast<double>(elapsed.count()) / static_cast<double>(tickEnd - tickStart);
+#else
+            return 1.0;
+#endif
+        }
+    };
+}
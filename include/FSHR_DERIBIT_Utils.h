@@ -1,15 +1,100 @@
 #pragma once
 
 #include "FSHR_DERIBIT_Enums.h"
+#include <cstddef>
+#include <cstring>
 #include <string_view>
+#include <charconv>
 
 namespace fischer::deribit::utils
 {
+    // Longest escape of one byte, \u00XX
+    constexpr size_t MaxJsonEscapeLength = 6;
+
+    constexpr bool NeedsJsonEscape(char c) noexcept
+    {
+        return '"' == c || '\\' == c || 0x20 > static_cast<unsigned char>(c);
+    }
+
+    // Writes text escaped for a JSON string, without the quotes, to out,
+    // which has room for MaxJsonEscapeLength bytes a character; returns the
+    // bytes written. The runs between escapes are copied whole, so text
+    // needing none is one scan and one copy
+    inline size_t EscapeJsonString(char* out, std::string_view text) noexcept
+    {
+        static constexpr char HexDigits[] = "0123456789abcdef";
+        char* const start = out;
+        size_t copied = 0;
+
+        for (size_t index = 0; index < text.size(); ++index)
+        {
+            const char c = text[index];
+            if (false == NeedsJsonEscape(c)) [[likely]]
+            {
+                continue;
+            }
+
+            std::memcpy(out, text.data() + copied, index - copied);
+            out += index - copied;
+            copied = index + 1;
+
+            if ('"' == c || '\\' == c)
+            {
+                *out++ = '\\';
+                *out++ = c;
+            }
+            else
+            {
+                const auto byte = static_cast<unsigned char>(c);
+                std::memcpy(out, "\\u00", 4);
+                out[4] = HexDigits[byte >> 4];
+                out[5] = HexDigits[byte & 0x0F];
+                out += MaxJsonEscapeLength;
+            }
+        }
+
+        std::memcpy(out, text.data() + copied, text.size() - copied);
+        out += text.size() - copied;
+        return static_cast<size_t>(out - start);
+    }
+
     inline constexpr bool ParseBool(char c) noexcept
     {
         return 't' == c || 'T' == c || '1' == c;
     }
 
+    // Bounded replacement for strtod: never reads past last, so it is safe on
+    // buffers that are not NUL-terminated (e.g. memory-mapped input)
+    inline double ParseDouble(const char* first, const char* last) noexcept
+    {
+        if (first < last && '+' == *first)
+        {
+            ++first;
+        }
+
+        double value = 0.0;
+        std::from_chars(first, last, value);
+        return value;
+    }
+
+    // Overloads shared with FSHR_DERIBIT_Decimal.h so parser and builder code
+    // is independent of the traits' AmountType/PriceType
+    inline bool ParseNumber(const char* first, const char* last, double& value) noexcept
+    {
+        value = ParseDouble(first, last);
+        return true;
+    }
+
+    constexpr bool IsPositive(double value) noexcept
+    {
+        return 0.0 < value;
+    }
+
+    constexpr double ToDouble(double value) noexcept
+    {
+        return value;
+    }
+
     constexpr std::string_view OrderDirectionToString(OrderDirection direction)
     {
         switch (direction)
@@ -166,6 +251,174 @@ namespace fischer::deribit::utils
         }
     }
 
+    constexpr std::string_view NumberFormatToString(NumberFormat format)
+    {
+        switch (format)
+        {
+        case NumberFormat::Printf:
+            return "printf";
+        case NumberFormat::Compatible:
+            return "compat";
+        case NumberFormat::Shortest:
+            return "shortest";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view OutputBackendToString(OutputBackend backend)
+    {
+        switch (backend)
+        {
+        case OutputBackend::Synchronous:
+            return "sync";
+        case OutputBackend::Thread:
+            return "pwritev";
+        case OutputBackend::IoUring:
+            return "io_uring";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view SyncPolicyToString(SyncPolicy policy)
+    {
+        switch (policy)
+        {
+        case SyncPolicy::None:
+            return "none";
+        case SyncPolicy::OnClose:
+            return "close";
+        case SyncPolicy::EveryWrite:
+            return "write";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view InputFormatToString(InputFormat format)
+    {
+        switch (format)
+        {
+        case InputFormat::Csv:
+            return "csv";
+        case InputFormat::Binary:
+            return "bin";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view OutputFormatToString(OutputFormat format)
+    {
+        switch (format)
+        {
+        case OutputFormat::Json:
+            return "json";
+        case OutputFormat::Binary:
+            return "bin";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view MessageIdAllocationToString(MessageIdAllocation allocation)
+    {
+        switch (allocation)
+        {
+        case MessageIdAllocation::Global:
+            return "global";
+        case MessageIdAllocation::PerFile:
+            return "per-file";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view HugePagesToString(HugePages hugePages)
+    {
+        switch (hugePages)
+        {
+        case HugePages::Off:
+            return "off";
+        case HugePages::Transparent:
+            return "thp";
+        case HugePages::Explicit:
+            return "hugetlb";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view PerfEventToString(PerfEvent event)
+    {
+        switch (event)
+        {
+        case PerfEvent::TlbLoads:
+            return "dTLB-loads";
+        case PerfEvent::TlbLoadMisses:
+            return "dTLB-load-misses";
+        case PerfEvent::NodeLoads:
+            return "node-loads";
+        case PerfEvent::RemoteNodeLoads:
+            return "node-load-misses";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view InstrumentKindToString(InstrumentKind kind)
+    {
+        switch (kind)
+        {
+        case InstrumentKind::Future:
+            return "future";
+        case InstrumentKind::Option:
+            return "option";
+        case InstrumentKind::Spot:
+            return "spot";
+        case InstrumentKind::FutureCombo:
+            return "future_combo";
+        case InstrumentKind::OptionCombo:
+            return "option_combo";
+        default:
+            return "unknown";
+        }
+    }
+
+    constexpr std::string_view RejectReasonToString(RejectReason reason)
+    {
+        switch (reason)
+        {
+        case RejectReason::None:
+            return "none";
+        case RejectReason::InvalidDirection:
+            return "invalid_direction";
+        case RejectReason::InvalidType:
+            return "invalid_type";
+        case RejectReason::MissingInstrument:
+            return "missing_instrument";
+        case RejectReason::UnknownInstrument:
+            return "unknown_instrument";
+        case RejectReason::MissingAmount:
+            return "missing_amount";
+        case RejectReason::AmountBelowMinimum:
+            return "amount_below_minimum";
+        case RejectReason::AmountNotMultiple:
+            return "amount_not_multiple";
+        case RejectReason::MissingPrice:
+            return "missing_price";
+        case RejectReason::PriceNotOnTick:
+            return "price_not_on_tick";
+        case RejectReason::InvalidTrigger:
+            return "invalid_trigger";
+        case RejectReason::AdvancedNotOption:
+            return "advanced_not_option";
+        default:
+            return "unknown";
+        }
+    }
+
     constexpr OrderType StringToOrderType(std::string_view str)
     {
         if ("limit" == str) return OrderType::Limit;
@@ -225,4 +478,78 @@ namespace fischer::deribit::utils
         if ("incremental" == str) return TriggerFillCondition::Incremental;
         return TriggerFillCondition::FirstHit;
     }
+
+    constexpr OrderState StringToOrderState(std::string_view str)
+    {
+        if ("open" == str) return OrderState::Open;
+        if ("filled" == str) return OrderState::Filled;
+        if ("rejected" == str) return OrderState::Rejected;
+        if ("cancelled" == str) return OrderState::Cancelled;
+        if ("untriggered" == str) return OrderState::Untriggered;
+        if ("archive" == str) return OrderState::Archive;
+        return OrderState::Unknown;
+    }
+
+    constexpr InputFormat StringToInputFormat(std::string_view str)
+    {
+        if ("csv" == str) return InputFormat::Csv;
+        if ("bin" == str) return InputFormat::Binary;
+        return InputFormat::Csv;
+    }
+
+    constexpr OutputFormat StringToOutputFormat(std::string_view str)
+    {
+        if ("json" == str) return OutputFormat::Json;
+        if ("bin" == str) return OutputFormat::Binary;
+        return OutputFormat::Json;
+    }
+
+    constexpr MessageIdAllocation StringToMessageIdAllocation(std::string_view str)
+    {
+        if ("global" == str) return MessageIdAllocation::Global;
+        if ("per-file" == str) return MessageIdAllocation::PerFile;
+        return MessageIdAllocation::Global;
+    }
+
+    constexpr HugePages StringToHugePages(std::string_view str)
+    {
+        if ("off" == str) return HugePages::Off;
+        if ("thp" == str) return HugePages::Transparent;
+        if ("hugetlb" == str) return HugePages::Explicit;
+        return HugePages::Transparent;
+    }
+
+    constexpr InstrumentKind StringToInstrumentKind(std::string_view str)
+    {
+        if ("future" == str) return InstrumentKind::Future;
+        if ("option" == str) return InstrumentKind::Option;
+        if ("spot" == str) return InstrumentKind::Spot;
+        if ("future_combo" == str) return InstrumentKind::FutureCombo;
+        if ("option_combo" == str) return InstrumentKind::OptionCombo;
+        return InstrumentKind::Future;
+    }
+
+    constexpr NumberFormat StringToNumberFormat(std::string_view str)
+    {
+        if ("printf" == str) return NumberFormat::Printf;
+        if ("compat" == str) return NumberFormat::Compatible;
+        if ("shortest" == str) return NumberFormat::Shortest;
+        return NumberFormat::Compatible;
+    }
+
+    constexpr OutputBackend StringToOutputBackend(std::string_view str)
+    {
+        if ("sync" == str) return OutputBackend::Synchronous;
+        if ("pwritev" == str) return OutputBackend::Thread;
+        if ("io_uring" == str) return OutputBackend::IoUring;
+        return OutputBackend::IoUring;
+    }
+
+    constexpr SyncPolicy StringToSyncPolicy(std::string_view str)
+    {
+        if ("none" == str) return SyncPolicy::None;
+        if ("close" == str) return SyncPolicy::OnClose;
+        if ("write" == str) return SyncPolicy::EveryWrite;
+        return SyncPolicy::None;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace fischer::deribit::websocket
+{
+    // RFC 6455 framing pieces shared by the sender and the local echo server
+
+    enum class Opcode : uint8_t
+    {
+        Continuation = 0x0,
+        Text = 0x1,
+        Binary = 0x2,
+        Close = 0x8,
+        Ping = 0x9,
+        Pong = 0xA
+    };
+
+    constexpr uint8_t FinalFragment = 0x80;
+    constexpr uint8_t MaskBit = 0x80;
+    constexpr size_t MaxClientHeaderSize = 14;      // 2 + 8-byte length + 4-byte mask
+    constexpr uint16_t NormalClosure = 1000;
+    constexpr std::string_view AcceptGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC11B85";
+
+    constexpr size_t GetHeaderSize(uint64_t payloadLength, bool masked) noexcept
+    {
+        const size_t lengthSize = payloadLength < 126 ? 0 : (payloadLength <= UINT16_MAX ? 2 : 8);
+        return 2 + lengthSize + (true == masked ? 4 : 0);
+    }
+
+    // Writes a final frame header so that it ends exactly at payload, into
+    // room the caller reserved in front of it, and returns where it starts
+    inline char* WriteHeaderBefore(char* payload, uint64_t payloadLength, Opcode opcode,
+                                   bool masked, uint32_t maskKey) noexcept
+    {
+        char* header = payload - GetHeaderSize(payloadLength, masked);
+        char* out = header;
+
+        *out++ = static_cast<char>(FinalFragment | static_cast<uint8_t>(opcode));
+        const uint8_t maskBit = true == masked ? MaskBit : 0;
+
+        if (payloadLength < 126)
+        {
+            *out++ = static_cast<char>(maskBit | payloadLength);
+        }
+        else if (payloadLength <= UINT16_MAX)
+        {
+            *out++ = static_cast<char>(maskBit | 126);
+            *out++ = static_cast<char>(payloadLength >> 8);
+            *out++ = static_cast<char>(payloadLength);
+        }
+        else
+        {
+            *out++ = static_cast<char>(maskBit | 127);
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                *out++ = static_cast<char>(payloadLength >> shift);
+            }
+        }
+
+        if (true == masked)
+        {
+            // The key goes on the wire in the byte order it is applied in
+            std::memcpy(out, &maskKey, sizeof(maskKey));
+        }
+
+        return header;
+    }
+
+    // XORs the payload with the repeating 4-byte key, eight bytes at a time
+    inline void ApplyMask(char* payload, size_t length, uint32_t maskKey) noexcept
+    {
+        const uint64_t wideKey = (static_cast<uint64_t>(maskKey) << 32) | maskKey;
+        size_t offset = 0;
+
+        for (; offset + sizeof(uint64_t) <= length; offset += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, payload + offset, sizeof(word));
+            word ^= wideKey;
+            std::memcpy(payload + offset, &word, sizeof(word));
+        }
+
+        const auto* keyBytes = reinterpret_cast<const uint8_t*>(&maskKey);
+        for (; offset < length; ++offset)
+        {
+            payload[offset] = static_cast<char>(payload[offset] ^ keyBytes[offset % 4]);
+        }
+    }
+
+    // A complete frame at the start of a byte range
+    struct Frame
+    {
+        Opcode m_Opcode{Opcode::Text};
+        bool m_Final{true};
+        size_t m_HeaderSize{0};
+        uint64_t m_PayloadLength{0};
+        bool m_Masked{false};
+        uint32_t m_MaskKey{0};
+    };
+
+    // Returns false until the whole header and payload are available
+    inline bool ParseFrame(const char* data, size_t size, Frame& frame) noexcept
+    {
+        if (size < 2)
+        {
+            return false;
+        }
+
+        const auto first = static_cast<uint8_t>(data[0]);
+        const auto second = static_cast<uint8_t>(data[1]);
+        frame.m_Final = 0 != (first & FinalFragment);
+        frame.m_Opcode = static_cast<Opcode>(first & 0x0F);
+        frame.m_Masked = 0 != (second & MaskBit);
+
+        size_t position = 2;
+        uint64_t length = second & 0x7F;
+        const size_t lengthSize = 126 == length ? 2 : (127 == length ? 8 : 0);
+
+        if (size < position + lengthSize + (true == frame.m_Masked ? 4 : 0))
+        {
+            return false;
+        }
+
+        if (0 < lengthSize)
+        {
+            length = 0;
+            for (size_t index = 0; index < lengthSize; ++index)
+            {
+                length = (length << 8) | static_cast<uint8_t>(data[position++]);
+            }
+        }
+
+        if (true == frame.m_Masked)
+        {
+            std::memcpy(&frame.m_MaskKey, data + position, sizeof(frame.m_MaskKey));
+            position += sizeof(frame.m_MaskKey);
+        }
+
+        frame.m_HeaderSize = position;
+        frame.m_PayloadLength = length;
+        return size - position >= length;
+    }
+
+    // SHA-1 (FIPS 180-4), needed only for the Sec-WebSocket-Accept handshake
+    inline std::array<uint8_t, 20> Sha1(std::string_view input) noexcept
+    {
+        uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+        const auto ProcessBlock = [&state](const uint8_t* block) noexcept
+        {
+            uint32_t words[80];
+            for (int index = 0; index < 16; ++index)
+            {
+                words[index] = (uint32_t{block[index * 4]} << 24) | (uint32_t{block[index * 4 + 1]} << 16) |
+                               (uint32_t{block[index * 4 + 2]} << 8) | uint32_t{block[index * 4 + 3]};
+            }
+            for (int index = 16; index < 80; ++index)
+            {
+                words[index] = std::rotl(words[index - 3] ^ words[index - 8] ^ words[index - 14] ^
+                                         words[index - 16], 1);
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+            for (int index = 0; index < 80; ++index)
+            {
+                uint32_t f;
+                uint32_t k;
+                if (index < 20)
+                {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                }
+                else if (index < 40)
+                {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                }
+                else if (index < 60)
+                {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                }
+                else
+                {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+
+                const uint32_t next = std::rotl(a, 5) + f + e + k + words[index];
+                e = d;
+                d = c;
+                c = std::rotl(b, 30);
+                b = a;
+                a = next;
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+        };
+
+        const auto* bytes = reinterpret_cast<const uint8_t*>(input.data());
+        size_t offset = 0;
+        for (; offset + 64 <= input.size(); offset += 64)
+        {
+            ProcessBlock(bytes + offset);
+        }
+
+        // Padding: 0x80, zeros, then the message length in bits
+        uint8_t tail[128] = {};
+        const size_t remaining = input.size() - offset;
+        std::memcpy(tail, bytes + offset, remaining);
+        tail[remaining] = 0x80;
+
+        const size_t tailSize = remaining < 56 ? 64 : 128;
+        const uint64_t bitLength = static_cast<uint64_t>(input.size()) * 8;
+        for (int index = 0; index < 8; ++index)
+        {
+            tail[tailSize - 1 - index] = static_cast<uint8_t>(bitLength >> (index * 8));
+        }
+
+        ProcessBlock(tail);
+        if (128 == tailSize)
+        {
+            ProcessBlock(tail + 64);
+        }
+
+        std::array<uint8_t, 20> digest{};
+        for (int index = 0; index < 20; ++index)
+        {
+            digest[index] = static_cast<uint8_t>(state[index / 4] >> (24 - (index % 4) * 8));
+        }
+        return digest;
+    }
+
+    inline std::string EncodeBase64(const uint8_t* data, size_t size)
+    {
+        static constexpr std::string_view Alphabet =
+            "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string out;
+        out.reserve((size + 2) / 3 * 4);
+
+        for (size_t offset = 0; offset < size; offset += 3)
+        {
+            const uint32_t group = (uint32_t{data[offset]} << 16) |
+                                   (offset + 1 < size ? uint32_t{data[offset + 1]} << 8 : 0) |
+                                   (offset + 2 < size ? uint32_t{data[offset + 2]} : 0);
+
+            out.push_back(Alphabet[(group >> 18) & 0x3F]);
+            out.push_back(Alphabet[(group >> 12) & 0x3F]);
+            out.push_back(offset + 1 < size ? Alphabet[(group >> 6) & 0x3F] : '=');
+            out.push_back(offset + 2 < size ? Alphabet[group & 0x3F] : '=');
+        }
+
+        return out;
+    }
+
+    // Sec-WebSocket-Accept for a Sec-WebSocket-Key
+    inline std::string ComputeAcceptKey(std::string_view key)
+    {
+        std::string input(key);
+        input.append(AcceptGuid);
+        const std::array<uint8_t, 20> digest = Sha1(input);
+        return EncodeBase64(digest.data(), digest.size());
+    }
+
+    // Value of an HTTP header in a raw request or response, matched
+    // case-insensitively; empty if absent
+    inline std::string_view FindHttpHeader(std::string_view message, std::string_view name)
+    {
+        size_t lineStart = message.find("\r\n");
+        while (std::string_view::npos != lineStart && lineStart + 2 < message.size())
+        {
+            lineStart += 2;
+            const size_t lineEnd = message.find("\r\n", lineStart);
+            const std::string_view line = message.substr(lineStart, lineEnd - lineStart);
+
+            if (line.size() > name.size() && ':' == line[name.size()])
+            {
+                bool matches = true;
+                for (size_t index = 0; index < name.size() && true == matches; ++index)
+                {
+                    matches = (line[index] | 0x20) == (name[index] | 0x20);
+                }
+
+                if (true == matches)
+                {
+                    std::string_view value = line.substr(name.size() + 1);
+                    while (false == value.empty() && ' ' == value.front())
+                    {
+                        value.remove_prefix(1);
+                    }
+                    while (false == value.empty() && ' ' == value.back())
+                    {
+                        value.remove_suffix(1);
+                    }
+                    return value;
+                }
+            }
+
+            lineStart = lineEnd;
+        }
+
+        return {};
+    }
+}
@@ -0,0 +1,570 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_JSONBuilder.h"
+#include "FSHR_DERIBIT_Logger.h"
+#include "FSHR_DERIBIT_WebSocket.h"
+#include "FSHR_DERIBIT_ResponseTracker.h"
+#include "FSHR_DERIBIT_TscClock.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fischer::deribit
+{
+    // Sends encoded orders as WebSocket text frames over plain TCP (ws://).
+    // Frames are assembled in the builder's own buffer: every message was
+    // encoded behind HeaderReserve bytes of room, so the header is written
+    // directly in front of the payload, the payload is masked in place, and
+    // a batch of frames reaches the socket as one sendmsg with an iovec per
+    // frame. No byte is copied between encoding and the kernel.
+    //
+    // The socket is non-blocking: while the send buffer is full, whatever the
+    // peer sent back is drained, so a peer that answers every message cannot
+    // deadlock the sender.
+    //
+    // With a ResponseTracker, each batch is stamped as it is handed to the
+    // socket, replies are read after every batch, and every text frame from
+    // the peer goes to the tracker stamped with the time it was read.
+    template<typename Traits = DeribitTraits>
+    class WebSocketSender
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+
+        static constexpr SizeType HeaderReserve = websocket::MaxClientHeaderSize;
+        static constexpr SizeType BatchFrames = Traits::WebSocketBatchFrames;
+
+        WebSocketSender() = default;
+
+        WebSocketSender(const WebSocketSender&) = delete;
+        WebSocketSender& operator=(const WebSocketSender&) = delete;
+
+        ~WebSocketSender() noexcept
+        {
+            Disconnect();
+        }
+
+        // url is ws://host[:port][/path]
+        void Connect(const std::string& url)
+        {
+            Disconnect();
+
+            std::string host;
+            std::string port;
+            std::string path;
+            ParseUrl(url, host, port, path);
+
+            OpenSocket(host, port);
+            Handshake(host, port, path);
+
+            ::fcntl(m_Socket, F_SETFL, ::fcntl(m_Socket, F_GETFL) | O_NONBLOCK);
+            LOG_INFO("WebSocket connected:", url);
+        }
+
+        // Sends are stamped and replies handed to tracker from now on
+        void SetResponseTracker(ResponseTracker<Traits>* tracker) { m_Tracker = tracker; }
+
+        // Frames and sends every message the builder recorded since its last
+        // Reset. The payloads are masked in place, so the builder's contents
+        // are consumed.
+        void Send(JsonBuilder<Traits>& builder)
+        {
+            Send(builder, 0, builder.GetMessages().size());
+        }
+
+        // Frames and sends messageCount messages starting at first, as
+        // recorded by the builder; a paced sender hands over each release
+        // this way
+        void Send(JsonBuilder<Traits>& builder, SizeType first, SizeType messageCount)
+        {
+            const auto& messages = builder.GetMessages();
+            char* buffer = builder.GetMutableData();
+            const SizeType end = std::min<SizeType>(first + messageCount, messages.size());
+
+            std::array<iovec, BatchFrames> vectors;
+            std::array<uint32_t, BatchFrames> maskKeys;
+
+            for (SizeType begin = first; begin < end; begin += BatchFrames)
+            {
+                const SizeType count = std::min<SizeType>(BatchFrames, end - begin);
+                FillRandom(maskKeys.data(), count * sizeof(uint32_t));
+
+                for (SizeType index = 0; index < count; ++index)
+                {
+                    const auto& message = messages[begin + index];
+                    char* payload = buffer + message.m_Offset;
+
+                    websocket::ApplyMask(payload, message.m_Length, maskKeys[index]);
+                    char* header = websocket::WriteHeaderBefore(payload, message.m_Length, websocket::Opcode::Text,
+                                                                true, maskKeys[index]);
+
+                    vectors[index].iov_base = header;
+                    vectors[index].iov_len = static_cast<size_t>(payload + message.m_Length - header);
+                    m_BytesSent += vectors[index].iov_len;
+                }
+
+                if (nullptr != m_Tracker)
+                {
+                    m_Tracker->OnSent(count, TscClock::Now());
+                }
+
+                SendVectors(vectors.data(), count);
+                m_FramesSent += count;
+
+                if (nullptr != m_Tracker && false == ReceiveAvailable())
+                {
+                    LOG_ERROR("WebSocket peer closed the connection while replies were expected");
+                    throw std::runtime_error("WebSocket peer closed the connection");
+                }
+
+                // Control frames go out only between whole data frames
+                SendPendingPong();
+            }
+        }
+
+        // Handles whatever the peer sends until deadline, so replies are read
+        // as they arrive while the caller has nothing to send
+        void ReceiveUntil(std::chrono::steady_clock::time_point deadline)
+        {
+            for (;;)
+            {
+                const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+                if (0 >= remaining)
+                {
+                    return;
+                }
+
+                const timespec timeout{static_cast<time_t>(remaining / 1000000000),
+                                       static_cast<long>(remaining % 1000000000)};
+                pollfd descriptor{m_Socket, POLLIN, 0};
+                const int result = ::ppoll(&descriptor, 1, &timeout, nullptr);
+
+                if (0 > result && EINTR != errno)
+                {
+                    LOG_ERROR("Failed to wait for WebSocket peer:", std::strerror(errno));
+                    throw std::runtime_error("Failed to wait for WebSocket peer");
+                }
+
+                if (0 < result && false == ReceiveAvailable())
+                {
+                    LOG_ERROR("WebSocket peer closed the connection while replies were expected");
+                    throw std::runtime_error("WebSocket peer closed the connection");
+                }
+            }
+        }
+
+        // Closing handshake: sends a close frame and reads until the peer
+        // answers with its own, counting whatever it sent before that
+        void Close()
+        {
+            if (0 > m_Socket)
+            {
+                return;
+            }
+
+            SendPendingPong();
+
+            const char status[2] = {static_cast<char>(websocket::NormalClosure >> 8),
+                                    static_cast<char>(websocket::NormalClosure & 0xFF)};
+            SendControl(websocket::Opcode::Close, std::string_view(status, sizeof(status)));
+
+            const auto deadline = std::chrono::steady_clock::now() +
+                                  std::chrono::milliseconds(Traits::WebSocketTimeoutMilliseconds);
+
+            while (false == m_CloseReceived)
+            {
+                const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count();
+
+                if (0 >= remaining)
+                {
+                    LOG_WARNING("WebSocket peer did not answer the close frame");
+                    break;
+                }
+
+                if (0 != WaitSocket(POLLIN, static_cast<int>(remaining)) && false == ReceiveAvailable())
+                {
+                    break;
+                }
+            }
+
+            LOG_DEBUG("WebSocket closed. Frames sent:", m_FramesSent, "received:", m_FramesReceived);
+            Disconnect();
+        }
+
+        uint64_t GetFramesSent() const { return m_FramesSent; }
+        uint64_t GetBytesSent() const { return m_BytesSent; }
+        uint64_t GetFramesReceived() const { return m_FramesReceived; }
+
+    private:
+        static constexpr SizeType ReceiveSize = 64 * 1024;
+
+        static void ParseUrl(const std::string& url, std::string& host, std::string& port, std::string& path)
+        {
+            constexpr std::string_view Scheme = "ws://";
+
+            if (false == url.starts_with(Scheme))
+            {
+                if (true == url.starts_with("wss://"))
+                {
+                    LOG_ERROR("TLS endpoints are not supported, connect through a local TLS terminator:", url);
+                }
+                else
+                {
+                    LOG_ERROR("Invalid WebSocket URL:", url);
+                }
+                throw std::runtime_error("Invalid WebSocket URL");
+            }
+
+            const std::string_view rest = std::string_view(url).substr(Scheme.size());
+            const size_t slash = rest.find('/');
+            const std::string_view authority = rest.substr(0, slash);
+            path = std::string_view::npos == slash ? std::string("/") : std::string(rest.substr(slash));
+
+            const size_t colon = authority.rfind(':');
+            host = std::string(authority.substr(0, colon));
+            port = std::string_view::npos == colon ? std::string("80") : std::string(authority.substr(colon + 1));
+
+            if (true == host.empty() || true == port.empty())
+            {
+                LOG_ERROR("Invalid WebSocket URL:", url);
+                throw std::runtime_error("Invalid WebSocket URL");
+            }
+        }
+
+        void OpenSocket(const std::string& host, const std::string& port)
+        {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+
+            addrinfo* addresses = nullptr;
+            const int result = ::getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+            if (0 != result)
+            {
+                LOG_ERROR("Failed to resolve WebSocket host:", host, ::gai_strerror(result));
+                throw std::runtime_error("Failed to resolve WebSocket host");
+            }
+
+            int error = 0;
+            for (const addrinfo* address = addresses; nullptr != address && 0 > m_Socket; address = address->ai_next)
+            {
+                m_Socket = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+                if (0 <= m_Socket && 0 != ::connect(m_Socket, address->ai_addr, address->ai_addrlen))
+                {
+                    error = errno;
+                    ::close(m_Socket);
+                    m_Socket = -1;
+                }
+            }
+            ::freeaddrinfo(addresses);
+
+            if (0 > m_Socket)
+            {
+                LOG_ERROR("Failed to connect to WebSocket endpoint:", host + ":" + port, std::strerror(error));
+                throw std::runtime_error("Failed to connect to WebSocket endpoint");
+            }
+
+            // A batch is handed over whole, so there is nothing to coalesce
+            const int enable = 1;
+            ::setsockopt(m_Socket, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        }
+
+        void Handshake(const std::string& host, const std::string& port, const std::string& path)
+        {
+            std::array<uint8_t, 16> nonce;
+            FillRandom(nonce.data(), nonce.size());
+            const std::string key = websocket::EncodeBase64(nonce.data(), nonce.size());
+
+            std::string request;
+            request.append("GET ").append(path).append(" HTTP/1.1\r\n");
+            request.append("Host: ").append(host).append(":").append(port).append("\r\n");
+            request.append("Upgrade: websocket\r\nConnection: Upgrade\r\n");
+            request.append("Sec-WebSocket-Key: ").append(key).append("\r\n");
+            request.append("Sec-WebSocket-Version: 13\r\n\r\n");
+
+            iovec vector{request.data(), request.size()};
+            SendVectors(&vector, 1);
+
+            // The response header ends with an empty line; frames may follow it
+            // in the same read
+            constexpr std::string_view HeaderEnd = "\r\n\r\n";
+            size_t headerEnd = std::string_view::npos;
+
+            while (std::string_view::npos == headerEnd)
+            {
+                if (0 == WaitSocket(POLLIN, Traits::WebSocketTimeoutMilliseconds) || false == ReceiveRaw())
+                {
+                    LOG_ERROR("WebSocket handshake got no response from", host + ":" + port);
+                    throw std::runtime_error("WebSocket handshake failed");
+                }
+                headerEnd = std::string_view(m_Inbound.data(), m_InboundSize).find(HeaderEnd);
+            }
+
+            const std::string_view response(m_Inbound.data(), headerEnd + HeaderEnd.size());
+            if (false == response.starts_with("HTTP/1.1 101") ||
+                websocket::ComputeAcceptKey(key) != websocket::FindHttpHeader(response, "Sec-WebSocket-Accept"))
+            {
+                LOG_ERROR("WebSocket upgrade refused:", response.substr(0, response.find("\r\n")));
+                throw std::runtime_error("WebSocket handshake failed");
+            }
+
+            m_InboundSize -= response.size();
+            std::memmove(m_Inbound.data(), m_Inbound.data() + response.size(), m_InboundSize);
+            ParseInbound();
+        }
+
+        // Hands the vectors to the socket, draining the peer whenever the
+        // send buffer is full
+        void SendVectors(iovec* vectors, SizeType count)
+        {
+            msghdr message{};
+            message.msg_iov = vectors;
+            message.msg_iovlen = count;
+
+            while (0 < message.msg_iovlen)
+            {
+                const ssize_t sent = ::sendmsg(m_Socket, &message, MSG_NOSIGNAL);
+                if (0 > sent)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+                    if (EAGAIN == errno || EWOULDBLOCK == errno)
+                    {
+                        if (0 != (WaitSocket(POLLOUT | POLLIN, -1) & POLLIN) && false == ReceiveAvailable())
+                        {
+                            LOG_ERROR("WebSocket peer closed the connection while frames were pending");
+                            throw std::runtime_error("WebSocket peer closed the connection");
+                        }
+                        continue;
+                    }
+
+                    LOG_ERROR("Failed to send WebSocket frames:", std::strerror(errno));
+                    throw std::runtime_error("Failed to send WebSocket frames");
+                }
+
+                // Skip the vectors sent whole and trim a partly sent one
+                size_t remaining = static_cast<size_t>(sent);
+                while (0 < message.msg_iovlen && remaining >= message.msg_iov->iov_len)
+                {
+                    remaining -= message.msg_iov->iov_len;
+                    message.msg_iov++;
+                    message.msg_iovlen--;
+                }
+                if (0 < message.msg_iovlen)
+                {
+                    message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + remaining;
+                    message.msg_iov->iov_len -= remaining;
+                }
+            }
+        }
+
+        // Control payloads are at most 125 bytes, so they are copied into a
+        // frame of their own
+        void SendControl(websocket::Opcode opcode, std::string_view payload)
+        {
+            char frame[HeaderReserve + 125];
+            char* body = frame + HeaderReserve;
+            const SizeType length = std::min<SizeType>(payload.size(), 125);
+            std::memcpy(body, payload.data(), length);
+
+            uint32_t maskKey;
+            FillRandom(&maskKey, sizeof(maskKey));
+            websocket::ApplyMask(body, length, maskKey);
+            char* header = websocket::WriteHeaderBefore(body, length, opcode, true, maskKey);
+
+            iovec vector{header, static_cast<size_t>(body + length - header)};
+            SendVectors(&vector, 1);
+        }
+
+        void SendPendingPong()
+        {
+            if (true == m_PongPending)
+            {
+                m_PongPending = false;
+                SendControl(websocket::Opcode::Pong, m_PongPayload);
+            }
+        }
+
+        // Reads whatever the peer has sent without blocking; false once it
+        // has closed the connection
+        bool ReceiveAvailable()
+        {
+            for (;;)
+            {
+                const ssize_t before = static_cast<ssize_t>(m_InboundSize);
+                if (false == ReceiveRaw())
+                {
+                    ParseInbound();
+                    return false;
+                }
+                if (before == static_cast<ssize_t>(m_InboundSize))
+                {
+                    return true;
+                }
+                ParseInbound();
+            }
+        }
+
+        // One non-blocking read into the inbound buffer; false on end of stream
+        bool ReceiveRaw()
+        {
+            if (m_Inbound.size() - m_InboundSize < ReceiveSize)
+            {
+                m_Inbound.resize(m_InboundSize + ReceiveSize);
+            }
+
+            for (;;)
+            {
+                const ssize_t count = ::recv(m_Socket, m_Inbound.data() + m_InboundSize,
+                                             m_Inbound.size() - m_InboundSize, MSG_DONTWAIT);
+                if (0 < count)
+                {
+                    m_InboundSize += static_cast<SizeType>(count);
+                    return true;
+                }
+                if (0 == count)
+                {
+                    return false;
+                }
+                if (EAGAIN == errno || EWOULDBLOCK == errno)
+                {
+                    return true;
+                }
+                if (EINTR != errno)
+                {
+                    LOG_ERROR("Failed to receive from WebSocket peer:", std::strerror(errno));
+                    throw std::runtime_error("Failed to receive from WebSocket peer");
+                }
+            }
+        }
+
+        // Consumes every complete frame at the front of the inbound buffer
+        void ParseInbound()
+        {
+            SizeType offset = 0;
+            websocket::Frame frame;
+            const uint64_t receiveTicks = nullptr != m_Tracker ? TscClock::Now() : 0;
+
+            while (true == websocket::ParseFrame(m_Inbound.data() + offset, m_InboundSize - offset, frame))
+            {
+                const char* payload = m_Inbound.data() + offset + frame.m_HeaderSize;
+                const SizeType length = static_cast<SizeType>(frame.m_PayloadLength);
+
+                if (websocket::Opcode::Close == frame.m_Opcode)
+                {
+                    m_CloseReceived = true;
+                }
+                else if (websocket::Opcode::Ping == frame.m_Opcode)
+                {
+                    m_PongPayload.assign(payload, length);
+                    m_PongPending = true;
+                }
+                else if (websocket::Opcode::Pong != frame.m_Opcode && true == frame.m_Final)
+                {
+                    m_FramesReceived++;
+
+                    // Replies are single text frames; fragmented ones are only counted
+                    if (nullptr != m_Tracker && websocket::Opcode::Text == frame.m_Opcode)
+                    {
+                        m_Tracker->OnMessage(std::string_view(payload, length), receiveTicks);
+                    }
+                }
+
+                offset += frame.m_HeaderSize + length;
+            }
+
+            m_InboundSize -= offset;
+            std::memmove(m_Inbound.data(), m_Inbound.data() + offset, m_InboundSize);
+        }
+
+        // Returns the events that occurred, 0 on timeout
+        short WaitSocket(short events, int timeoutMilliseconds) const
+        {
+            pollfd descriptor{m_Socket, events, 0};
+
+            for (;;)
+            {
+                const int result = ::poll(&descriptor, 1, timeoutMilliseconds);
+                if (0 <= result)
+                {
+                    return 0 == result ? 0 : descriptor.revents;
+                }
+                if (EINTR != errno)
+                {
+                    LOG_ERROR("Failed to wait for WebSocket peer:", std::strerror(errno));
+                    throw std::runtime_error("Failed to wait for WebSocket peer");
+                }
+            }
+        }
+
+        // Mask keys and the handshake nonce must be unpredictable to the peer
+        static void FillRandom(void* data, SizeType size)
+        {
+            auto* bytes = static_cast<char*>(data);
+            while (0 < size)
+            {
+                const ssize_t count = ::getrandom(bytes, size, 0);
+                if (0 > count)
+                {
+                    if (EINTR == errno)
+                    {
+                        continue;
+                    }
+                    LOG_ERROR("Failed to generate WebSocket mask keys:", std::strerror(errno));
+                    throw std::runtime_error("Failed to generate WebSocket mask keys");
+                }
+                bytes += count;
+                size -= static_cast<SizeType>(count);
+            }
+        }
+
+        void Disconnect() noexcept
+        {
+            if (0 <= m_Socket)
+            {
+                ::close(m_Socket);
+            }
+
+            m_Socket = -1;
+            m_InboundSize = 0;
+            m_CloseReceived = false;
+            m_PongPending = false;
+        }
+
+    private:
+        int m_Socket{-1};
+        ResponseTracker<Traits>* m_Tracker{nullptr};
+        std::vector<char> m_Inbound;
+        SizeType m_InboundSize{0};
+        std::string m_PongPayload;
+        bool m_PongPending{false};
+        bool m_CloseReceived{false};
+        uint64_t m_FramesSent{0};
+        uint64_t m_BytesSent{0};
+        uint64_t m_FramesReceived{0};
+    };
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "FSHR_DERIBIT_ProtocolTraits.h"
+#include "FSHR_DERIBIT_ThreadPlacement.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fischer::deribit
+{
+    // Fixed pool of workers that run a known set of tasks per Run call. The
+    // tasks are dealt round-robin, so worker w owns tasks w, w + W, w + 2W...
+    // and runs them front to back; a worker whose own tasks are gone steals
+    // from the back of another's. With tasks ordered largest first, every
+    // worker starts on big ones and the small ones at the back even out the
+    // finish. Queues are one packed head/tail word each, so taking a task is
+    // one compare-and-swap. The threads live as long as the pool.
+    template<typename Traits = DeribitTraits>
+    class WorkStealingPool
+    {
+    public:
+        using SizeType = typename Traits::SizeType;
+
+        // Starts workerCount - 1 threads; the thread calling Run is worker 0.
+        // Every worker, the caller included, is placed by placement if given.
+        explicit WorkStealingPool(SizeType workerCount, const ThreadPlacement* placement = nullptr)
+            : m_WorkerCount{std::max<SizeType>(1, workerCount)}
+            , m_Queues{std::make_unique<Queue[]>(m_WorkerCount)}
+            , m_Errors(m_WorkerCount)
+        {
+            if (nullptr != placement)
+            {
+                placement->PlaceWorker(0);
+            }
+
+            m_Threads.reserve(m_WorkerCount - 1);
+            for (SizeType worker = 1; worker < m_WorkerCount; ++worker)
+            {
+                m_Threads.emplace_back([this, worker, placement]
+                {
+                    if (nullptr != placement)
+                    {
+                        placement->PlaceWorker(worker);
+                    }
+                    RunWorker(worker);
+                });
+            }
+        }
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        ~WorkStealingPool() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stopping = true;
+            }
+            m_Start.notify_all();
+
+            for (std::thread& thread : m_Threads)
+            {
+                thread.join();
+            }
+        }
+
+        // Calls function(worker, task) for every task in [0, taskCount) and
+        // returns once all have run. A task that throws does not stop the
+        // others; the first exception is rethrown at the end.
+        template<typename Function>
+        void Run(SizeType taskCount, Function& function)
+        {
+            m_Context = &function;
+            m_Invoke = [](void* context, SizeType worker, SizeType task)
+            {
+                (*static_cast<Function*>(context))(worker, task);
+            };
+
+            for (SizeType worker = 0; worker < m_WorkerCount; ++worker)
+            {
+                const SizeType owned = worker < taskCount ? (taskCount - worker + m_WorkerCount - 1) / m_WorkerCount
+                                                          : 0;
+                m_Queues[worker].m_Range.store(Pack(0, owned), std::memory_order_relaxed);
+                m_Errors[worker] = nullptr;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Running = m_WorkerCount - 1;
+                ++m_Generation;
+            }
+            m_Start.notify_all();
+
+            RunTasks(0);
+
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Finished.wait(lock, [this] { return 0 == m_Running; });
+            }
+
+            for (const std::exception_ptr& error : m_Errors)
+            {
+                if (nullptr != error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
+        SizeType GetWorkerCount() const { return m_WorkerCount; }
+
+        // Tasks run by a worker they were not dealt to, over every Run
+        uint64_t GetStealCount() const { return m_StealCount.load(std::memory_order_relaxed); }
+
+    protected:
+        // Indices into the owner's task sequence: head is taken by the owner,
+        // tail by thieves
+        struct alignas(64) Queue
+        {
+            std::atomic<uint64_t> m_Range{0};
+        };
+
+        static uint64_t Pack(uint64_t head, uint64_t tail) noexcept { return head | (tail << 32); }
+        static uint64_t GetHead(uint64_t range) noexcept { return range & 0xFFFFFFFFu; }
+        static uint64_t GetTail(uint64_t range) noexcept { return range >> 32; }
+
+        void RunWorker(SizeType worker)
+        {
+            uint64_t generation = 0;
+
+            while (true)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_Mutex);
+                    m_Start.wait(lock, [this, generation] { return true == m_Stopping || generation != m_Generation; });
+                    if (true == m_Stopping)
+                    {
+                        return;
+                    }
+                    generation = m_Generation;
+                }
+
+                RunTasks(worker);
+
+                {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    --m_Running;
+                }
+                m_Finished.notify_one();
+            }
+        }
+
+        void RunTasks(SizeType worker)
+        {
+            SizeType task = 0;
+            while (true == TakeOwn(worker, task) || true == Steal(worker, task))
+            {
+                try
+                {
+                    m_Invoke(m_Context, worker, task);
+                }
+                catch (...)
+                {
+                    if (nullptr == m_Errors[worker])
+                    {
+                        m_Errors[worker] = std::current_exception();
+                    }
+                }
+            }
+        }
+
+        bool TakeOwn(SizeType worker, SizeType& task)
+        {
+            std::atomic<uint64_t>& range = m_Queues[worker].m_Range;
+            uint64_t current = range.load(std::memory_order_acquire);
+
+            while (GetHead(current) < GetTail(current))
+            {
+                if (true == range.compare_exchange_weak(current, Pack(GetHead(current) + 1, GetTail(current)),
+                                                        std::memory_order_acq_rel))
+                {
+                    task = worker + static_cast<SizeType>(GetHead(current)) * m_WorkerCount;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool Steal(SizeType worker, SizeType& task)
+        {
+            for (SizeType offset = 1; offset < m_WorkerCount; ++offset)
+            {
+                const SizeType victim = (worker + offset) % m_WorkerCount;
+                std::atomic<uint64_t>& range = m_Queues[victim].m_Range;
+                uint64_t current = range.load(std::memory_order_acquire);
+
+                while (GetHead(current) < GetTail(current))
+                {
+                    if (true == range.compare_exchange_weak(current, Pack(GetHead(current), GetTail(current) - 1),
+                                                            std::memory_order_acq_rel))
+                    {
+                        task = victim + static_cast<SizeType>(GetTail(current) - 1) * m_WorkerCount;
+                        m_StealCount.fetch_add(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+    private:
+        SizeType m_WorkerCount;
+        std::unique_ptr<Queue[]> m_Queues;
+        std::vector<std::exception_ptr> m_Errors;      // one per worker, so no lock is needed
+        std::vector<std::thread> m_Threads;
+        void* m_Context{nullptr};
+        void (*m_Invoke)(void*, SizeType, SizeType){nullptr};
+        std::mutex m_Mutex;
+        std::condition_variable m_Start;
+        std::condition_variable m_Finished;
+        uint64_t m_Generation{0};
+        SizeType m_Running{0};
+        bool m_Stopping{false};
+        std::atomic<uint64_t> m_StealCount{0};
+    };
+}
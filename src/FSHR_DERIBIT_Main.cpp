@@ -1,18 +1,101 @@
 #include "FSHR_DERIBIT_OrderProcessor.h"
+#include "FSHR_DERIBIT_OrderDaemon.h"
+#include "FSHR_DERIBIT_OrderBatch.h"
 #include "FSHR_DERIBIT_Logger.h"
 #include "FSHR_DERIBIT_Constants.h"
+#include "FSHR_DERIBIT_Utils.h"
+#include "FSHR_DERIBIT_TscClock.h"
+#include "FSHR_DERIBIT_AllocationCounter.h"
+#include "FSHR_DERIBIT_PageBuffer.h"
+#include "FSHR_DERIBIT_PerfCounters.h"
+#include "FSHR_DERIBIT_ThreadPlacement.h"
 
 #include <iomanip>
 #include <stdexcept>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <optional>
+
+#include <sys/signalfd.h>
+#include <unistd.h>
 
 using namespace fischer::deribit;
 
-void PrintPerformanceMetrics(const OrderProcessor<DeribitTraits>& processor)
+COUNT_GLOBAL_ALLOCATIONS();
+
+// Histograms hold TscClock ticks unless nanosecondsPerTick says otherwise
+template<typename Traits>
+void PrintLatency(std::string_view stage, const LatencyHistogram<Traits>& histogram,
+                  double nanosecondsPerTick = TscClock::GetNanosecondsPerTick())
+{
+    const auto Nanoseconds = [nanosecondsPerTick](uint64_t ticks)
+    {
+        return static_cast<uint64_t>(std::llround(static_cast<double>(ticks) * nanosecondsPerTick));
+    };
+
+    LOG_INFO(stage, "p50", Nanoseconds(histogram.GetPercentile(0.5)),
+             "p99", Nanoseconds(histogram.GetPercentile(0.99)),
+             "p99.9", Nanoseconds(histogram.GetPercentile(0.999)),
+             "max", Nanoseconds(histogram.GetMax()),
+             "orders", histogram.GetCount());
+}
+
+template<typename Traits>
+void PrintResponses(const ResponseTracker<Traits>& responses)
+{
+    LOG_INFO("  Responses:", responses.GetMatchedCount(), "of", responses.GetSentCount(), "requests answered,",
+             responses.GetErrorCount(), "errors,", responses.GetUnmatchedCount(), "unmatched,",
+             responses.GetUnrecognizedCount(), "unrecognized");
+
+    std::string states;
+    for (size_t index = 0; index < ResponseTracker<Traits>::StateCount; ++index)
+    {
+        const OrderState state = static_cast<OrderState>(index);
+        if (0 < responses.GetStateCount(state))
+        {
+            states.append(" ").append(utils::OrderStateToString(state)).append(" ").append(
+                std::to_string(responses.GetStateCount(state)));
+        }
+    }
+
+    if (false == states.empty())
+    {
+        LOG_INFO("  Order states:" + states);
+    }
+
+    if (false == responses.GetFirstError().empty())
+    {
+        LOG_WARNING("  First error:", responses.GetFirstError());
+    }
+
+    if (0 < responses.GetRoundTrip().GetCount())
+    {
+        PrintLatency("  Round-trip latency (ns):", responses.GetRoundTrip());
+    }
+}
+
+template<typename Traits>
+void PrintPerformanceMetrics(const OrderProcessor<Traits>& processor)
 {
     LOG_INFO("Performance Metrics:");
     LOG_INFO("  Orders processed:", processor.GetProcessedOrderCount());
+
+    if (true == processor.IsValidationEnabled())
+    {
+        LOG_INFO("  Orders rejected:", processor.GetRejectedOrderCount());
+    }
+
     LOG_INFO("  Total time:", processor.GetTotalProcessingTime().count(), "μs");
     LOG_INFO("  Parse time:", processor.GetParseTime().count(), "μs");
+
+    if (true == processor.IsValidationEnabled())
+    {
+        LOG_INFO("  Validate time:", processor.GetValidateTime().count(), "μs");
+    }
+
     LOG_INFO("  Build time:", processor.GetBuildTime().count(), "μs");
     LOG_INFO("  Write time:", processor.GetWriteTime().count(), "μs");
 
@@ -25,41 +108,617 @@ void PrintPerformanceMetrics(const OrderProcessor<DeribitTraits>& processor)
     }
 
     LOG_INFO("  Throughput:", static_cast<int>(throughput), "orders/sec");
+
+    if (0 < processor.GetPeakWindowOrderCount())
+    {
+        LOG_INFO("  Peak window:", processor.GetPeakWindowOrderCount(), "orders,",
+                 processor.GetPeakWindowBytes(), "bytes");
+    }
+
+    if (true == AllocationCounter::IsInstalled())
+    {
+        LOG_INFO("  Heap allocations:", processor.GetAllocations().m_Allocations, "calls,",
+                 processor.GetAllocations().m_Bytes, "bytes");
+    }
+
+    if (true == processor.IsLatencyEnabled())
+    {
+        PrintLatency("  Parse latency (ns):", processor.GetParseLatency());
+        PrintLatency("  Encode latency (ns):", processor.GetEncodeLatency());
+    }
+
+    if (true == processor.IsPacingEnabled())
+    {
+        LOG_INFO("  Pacing:", static_cast<int64_t>(std::llround(processor.GetAchievedRate())),
+                 "messages/sec achieved, target", static_cast<int64_t>(std::llround(processor.GetTargetRate())));
+        PrintLatency("  Release lateness (ns):", processor.GetReleaseLateness(), 1.0);
+    }
+
+    if (true == processor.HasResponses())
+    {
+        PrintResponses(processor.GetResponses());
+    }
+}
+
+// Process-wide settings of a run, applied before its buffers are allocated
+// and its threads started
+template<typename Traits>
+void ApplyRunOptions(const ProcessorOptions<Traits>& options, PerfCounters& counters)
+{
+    PageBuffer::SetHugePages(options.m_HugePages);
+
+    if (true == options.m_EnablePerfCounters && 0 == counters.Open())
+    {
+        LOG_WARNING("No hardware counters are available (perf_event_paranoid, or a virtual machine)");
+    }
+}
+
+void PrintPerfCounters(PerfCounters& counters)
+{
+    counters.Stop();
+
+    for (size_t index = 0; index < PerfCounters::EventCount; ++index)
+    {
+        const PerfEvent event = static_cast<PerfEvent>(index);
+        if (const std::optional<uint64_t> count = counters.Read(event))
+        {
+            LOG_INFO("  " + std::string(utils::PerfEventToString(event)) + ":", *count);
+        }
+    }
+}
+
+// Parses the numeric value of a "--name=value" option
+bool ParseCount(std::string_view argument, size_t& count)
+{
+    const std::string_view value = argument.substr(argument.find('=') + 1);
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+
+    if (std::errc{} != error || value.data() + value.size() != end)
+    {
+        LOG_ERROR("Invalid value for option:", argument);
+        return false;
+    }
+
+    return true;
+}
+
+// Parses a positive "--name=value" rate of at most MaxRate per second
+bool ParseRate(std::string_view argument, double& rate)
+{
+    constexpr double MaxRate = 1e9;
+    const std::string_view value = argument.substr(argument.find('=') + 1);
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), rate);
+
+    if (std::errc{} != error || value.data() + value.size() != end || false == (0.0 < rate && rate <= MaxRate))
+    {
+        LOG_ERROR("Invalid rate:", argument, "(expected messages per second, above 0 and at most 1e9)");
+        return false;
+    }
+
+    return true;
+}
+
+// Positional arguments are collected in order, [input] [output] except in
+// batch mode; options start with "--"
+template<typename Traits>
+bool ParseCommandLine(int argc, char* argv[], std::vector<std::string>& positionals,
+                      ProcessorOptions<Traits>& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument(argv[i]);
+
+        if ("--decimal" == argument || "--sync-log" == argument || "--daemon" == argument ||
+            "--batch" == argument)
+        {
+            // Select the traits, the logger mode and the run mode; handled in main
+        }
+        else if ("--mmap" == argument)
+        {
+            options.m_EnableMemoryMapping = true;
+        }
+        else if ("--no-mmap" == argument)
+        {
+            options.m_EnableMemoryMapping = false;
+        }
+        else if (true == argument.starts_with("--threads="))
+        {
+            if (false == ParseCount(argument, options.m_ThreadCount))
+            {
+                return false;
+            }
+        }
+        else if ("--intern" == argument)
+        {
+            options.m_EnableInterning = true;
+        }
+        else if ("--no-intern" == argument)
+        {
+            options.m_EnableInterning = false;
+        }
+        else if ("--validate" == argument)
+        {
+            options.m_EnableValidation = true;
+        }
+        else if ("--no-validate" == argument)
+        {
+            options.m_EnableValidation = false;
+        }
+        else if (true == argument.starts_with("--instruments="))
+        {
+            options.m_EnableValidation = true;
+            options.m_InstrumentFile = std::string(argument.substr(argument.find('=') + 1));
+        }
+        else if (true == argument.starts_with("--rejects="))
+        {
+            options.m_EnableValidation = true;
+            options.m_RejectsFile = std::string(argument.substr(argument.find('=') + 1));
+        }
+        else if ("--incremental" == argument)
+        {
+            options.m_EnableIncremental = true;
+        }
+        else if ("--no-incremental" == argument)
+        {
+            options.m_EnableIncremental = false;
+        }
+        else if ("--latency" == argument)
+        {
+            options.m_EnableLatencyHistograms = true;
+        }
+        else if (true == argument.starts_with("--latency-json="))
+        {
+            options.m_EnableLatencyHistograms = true;
+            options.m_LatencyReportFile = std::string(argument.substr(argument.find('=') + 1));
+        }
+        else if ("--stream" == argument)
+        {
+            options.m_StreamWindowRows = Traits::DefaultStreamWindowRows;
+        }
+        else if (true == argument.starts_with("--stream="))
+        {
+            if (false == ParseCount(argument, options.m_StreamWindowRows))
+            {
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--number-format="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_NumberFormat = utils::StringToNumberFormat(value);
+
+            if (value != utils::NumberFormatToString(options.m_NumberFormat))
+            {
+                LOG_ERROR("Invalid number format:", value, "(expected printf, compat or shortest)");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--writer="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_OutputBackend = utils::StringToOutputBackend(value);
+
+            if (value != utils::OutputBackendToString(options.m_OutputBackend))
+            {
+                LOG_ERROR("Invalid writer:", value, "(expected io_uring, pwritev or sync)");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--fdatasync="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_SyncPolicy = utils::StringToSyncPolicy(value);
+
+            if (value != utils::SyncPolicyToString(options.m_SyncPolicy))
+            {
+                LOG_ERROR("Invalid fdatasync policy:", value, "(expected none, close or write)");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--input-format="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_InputFormat = utils::StringToInputFormat(value);
+
+            if (value != utils::InputFormatToString(options.m_InputFormat))
+            {
+                LOG_ERROR("Invalid input format:", value, "(expected csv or bin)");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--output-format="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_OutputFormat = utils::StringToOutputFormat(value);
+
+            if (value != utils::OutputFormatToString(options.m_OutputFormat))
+            {
+                LOG_ERROR("Invalid output format:", value, "(expected json or bin)");
+                return false;
+            }
+        }
+        else if ("--direct-io" == argument)
+        {
+            options.m_EnableDirectIo = true;
+        }
+        else if (true == argument.starts_with("--websocket="))
+        {
+            options.m_WebSocketUrl = std::string(argument.substr(argument.find('=') + 1));
+        }
+        else if (true == argument.starts_with("--rate="))
+        {
+            if (false == ParseRate(argument, options.m_PacingRate))
+            {
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--burst="))
+        {
+            if (false == ParseCount(argument, options.m_PacingBurst))
+            {
+                return false;
+            }
+
+            if (0 == options.m_PacingBurst)
+            {
+                LOG_ERROR("The pacing burst must hold at least one message");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--ids="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_IdAllocation = utils::StringToMessageIdAllocation(value);
+
+            if (value != utils::MessageIdAllocationToString(options.m_IdAllocation))
+            {
+                LOG_ERROR("Invalid message ID allocation:", value, "(expected global or per-file)");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--id-range="))
+        {
+            if (false == ParseCount(argument, options.m_IdRangeSize))
+            {
+                return false;
+            }
+
+            if (0 == options.m_IdRangeSize)
+            {
+                LOG_ERROR("The message ID range must not be empty");
+                return false;
+            }
+        }
+        else if (true == argument.starts_with("--output-dir="))
+        {
+            options.m_OutputDirectory = std::string(argument.substr(argument.find('=') + 1));
+        }
+        else if (true == argument.starts_with("--cpus=") || true == argument.starts_with("--writer-cpus="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            std::vector<int>& cpus = true == argument.starts_with("--cpus=") ? options.m_WorkerCpus
+                                                                             : options.m_WriterCpus;
+
+            if (false == ThreadPlacement::ParseCpuList(value, cpus))
+            {
+                LOG_ERROR("Invalid CPU list:", value, "(expected e.g. 0-3,8)");
+                return false;
+            }
+
+            if (false == ThreadPlacement::IsAllowed(cpus))
+            {
+                LOG_ERROR("CPU list", value, "names CPUs this process may not run on");
+                return false;
+            }
+        }
+        else if ("--numa" == argument)
+        {
+            options.m_BindMemory = true;
+        }
+        else if (true == argument.starts_with("--huge-pages="))
+        {
+            const std::string_view value = argument.substr(argument.find('=') + 1);
+            options.m_HugePages = utils::StringToHugePages(value);
+
+            if (value != utils::HugePagesToString(options.m_HugePages))
+            {
+                LOG_ERROR("Invalid huge page mode:", value, "(expected off, thp or hugetlb)");
+                return false;
+            }
+        }
+        else if ("--perf-counters" == argument)
+        {
+            options.m_EnablePerfCounters = true;
+        }
+        else if (true == argument.starts_with("--"))
+        {
+            LOG_ERROR("Unknown option:", argument);
+            return false;
+        }
+        else
+        {
+            positionals.emplace_back(argument);
+        }
+    }
+
+    if (true == options.m_BindMemory && true == options.m_WorkerCpus.empty())
+    {
+        LOG_WARNING("--numa binds the buffers of pinned workers only; it has no effect without --cpus");
+    }
+
+    if (0.0 == options.m_PacingRate && Traits::DefaultPacingBurst != options.m_PacingBurst)
+    {
+        LOG_WARNING("--burst sizes the pacing token bucket; it has no effect without --rate");
+    }
+
+    return true;
+}
+
+// The first positional is the input and any later one the output
+void GetInputOutput(const std::vector<std::string>& positionals, std::string& inputFile, std::string& outputFile)
+{
+    if (0 < positionals.size())
+    {
+        inputFile = positionals.front();
+    }
+
+    if (1 < positionals.size())
+    {
+        outputFile = positionals.back();
+    }
+}
+
+// Options that take effect before the processor options are parsed
+bool HasOption(int argc, char* argv[], std::string_view option)
+{
+    return std::any_of(argv + 1, argv + argc, [option](const char* argument)
+    {
+        return option == argument;
+    });
+}
+
+template<typename Traits>
+int RunProcessor(int argc, char* argv[])
+{
+    std::string inputFile(DefaultInputFile);
+    std::string outputFile(DefaultOutputFile);
+
+    ProcessorOptions<Traits> options;
+    std::vector<std::string> positionals;
+
+    if (false == ParseCommandLine(argc, argv, positionals, options))
+    {
+        return 1;
+    }
+
+    GetInputOutput(positionals, inputFile, outputFile);
+
+    LOG_INFO("Input:", inputFile);
+    LOG_INFO("Output:", true == options.m_WebSocketUrl.empty() ? outputFile : options.m_WebSocketUrl);
+
+    PerfCounters counters;
+    ApplyRunOptions(options, counters);
+
+    OrderProcessor<Traits> processor(options);
+    processor.ProcessOrders(inputFile, outputFile);
+
+    PrintPerformanceMetrics(processor);
+    PrintPerfCounters(counters);
+
+    if (false == options.m_LatencyReportFile.empty())
+    {
+        processor.WriteLatencyReport(options.m_LatencyReportFile);
+    }
+
+    LOG_INFO("Processing complete!");
+    return 0;
+}
+
+// Daemon mode: input and output default to stdin and stdout, and the daemon
+// runs until its input ends or SIGINT/SIGTERM arrives on stopDescriptor
+template<typename Traits>
+int RunDaemon(int argc, char* argv[], int stopDescriptor)
+{
+    std::string inputFile(StandardStreamName);
+    std::string outputFile(StandardStreamName);
+
+    ProcessorOptions<Traits> options;
+    std::vector<std::string> positionals;
+
+    if (false == ParseCommandLine(argc, argv, positionals, options))
+    {
+        return 1;
+    }
+
+    GetInputOutput(positionals, inputFile, outputFile);
+
+    if (InputFormat::Csv != options.m_InputFormat || OutputFormat::Json != options.m_OutputFormat)
+    {
+        LOG_ERROR("The daemon reads CSV rows and writes JSON only");
+        return 1;
+    }
+
+    if (0.0 < options.m_PacingRate)
+    {
+        LOG_WARNING("Pacing applies to single-file runs; --rate is ignored by the daemon");
+    }
+
+    LOG_INFO("Daemon input:", inputFile);
+    LOG_INFO("Daemon output:", outputFile);
+
+    PerfCounters counters;
+    ApplyRunOptions(options, counters);
+
+    OrderDaemon<Traits> daemon(options);
+    daemon.Run(inputFile, outputFile, stopDescriptor);
+
+    LOG_INFO("Daemon stopped. Orders:", daemon.GetProcessedOrderCount(), "Streams:", daemon.GetStreamCount());
+
+    if (true == daemon.IsValidationEnabled())
+    {
+        LOG_INFO("  Orders rejected:", daemon.GetRejectedOrderCount());
+    }
+
+    if (true == daemon.IsLatencyEnabled())
+    {
+        PrintLatency("  Parse latency (ns):", daemon.GetParseLatency());
+        PrintLatency("  Encode latency (ns):", daemon.GetEncodeLatency());
+    }
+
+    PrintPerfCounters(counters);
+    return 0;
+}
+
+// Batch mode: every positional is an input file or glob pattern, each
+// written to its own JSON file in the output directory
+template<typename Traits>
+int RunBatch(int argc, char* argv[])
+{
+    ProcessorOptions<Traits> options;
+    std::vector<std::string> positionals;
+
+    if (false == ParseCommandLine(argc, argv, positionals, options))
+    {
+        return 1;
+    }
+
+    if (true == positionals.empty())
+    {
+        LOG_ERROR("Batch mode needs at least one input file or pattern");
+        return 1;
+    }
+
+    if (0.0 < options.m_PacingRate)
+    {
+        LOG_WARNING("Pacing applies to single-file runs; --rate is ignored in batch mode");
+    }
+
+    const std::vector<std::string> inputFiles = OrderBatch<Traits>::ExpandInputs(positionals);
+
+    LOG_INFO("Batch inputs:", inputFiles.size(), "files");
+    LOG_INFO("Batch output directory:", options.m_OutputDirectory);
+    LOG_INFO("Message IDs:", utils::MessageIdAllocationToString(options.m_IdAllocation));
+
+    PerfCounters counters;
+    ApplyRunOptions(options, counters);
+
+    OrderBatch<Traits> batch(options);
+    batch.ProcessFiles(inputFiles);
+
+    LOG_INFO("Performance Metrics:");
+    LOG_INFO("  Files processed:", batch.GetFileCount());
+    LOG_INFO("  Orders processed:", batch.GetProcessedOrderCount());
+    LOG_INFO("  Input bytes:", batch.GetInputBytes());
+    LOG_INFO("  Workers:", batch.GetWorkerCount(), "Tasks:", batch.GetTaskCount(), "Steals:", batch.GetStealCount());
+    LOG_INFO("  Total time:", batch.GetTotalProcessingTime().count(), "μs");
+    LOG_INFO("  Load time:", batch.GetLoadTime().count(), "μs");
+    LOG_INFO("  Parse time:", batch.GetParseTime().count(), "μs");
+    LOG_INFO("  Build and write time:", batch.GetWriteTime().count(), "μs");
+
+    double throughput = 0.0;
+    double bandwidth = 0.0;
+    if (0 < batch.GetTotalProcessingTime().count())
+    {
+        const double seconds = static_cast<double>(batch.GetTotalProcessingTime().count()) / MicrosecondsToSeconds;
+        throughput = static_cast<double>(batch.GetProcessedOrderCount()) / seconds;
+        bandwidth = static_cast<double>(batch.GetInputBytes()) / BytesPerMegabyte / seconds;
+    }
+
+    LOG_INFO("  Throughput:", static_cast<int>(throughput), "orders/sec,", static_cast<int>(bandwidth), "MB/sec");
+
+    if (true == AllocationCounter::IsInstalled())
+    {
+        LOG_INFO("  Heap allocations:", batch.GetAllocations().m_Allocations, "calls,",
+                 batch.GetAllocations().m_Bytes, "bytes");
+    }
+
+    PrintPerfCounters(counters);
+    LOG_INFO("Processing complete!");
+    return 0;
+}
+
+// Blocks SIGINT and SIGTERM in every thread and returns a descriptor that
+// becomes readable when one arrives. Must run before any thread is started,
+// since threads inherit the signal mask.
+int CreateStopDescriptor()
+{
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+
+    if (0 != pthread_sigmask(SIG_BLOCK, &signals, nullptr))
+    {
+        return -1;
+    }
+
+    const int descriptor = signalfd(-1, &signals, SFD_CLOEXEC);
+    if (0 > descriptor)
+    {
+        pthread_sigmask(SIG_UNBLOCK, &signals, nullptr);
+        return -1;
+    }
+
+    // A closed output pipe surfaces as EPIPE from write() instead
+    std::signal(SIGPIPE, SIG_IGN);
+    return descriptor;
+}
+
+template<typename Traits>
+int Run(int argc, char* argv[], int stopDescriptor)
+{
+    if (true == HasOption(argc, argv, "--daemon"))
+    {
+        return RunDaemon<Traits>(argc, argv, stopDescriptor);
+    }
+
+    if (true == HasOption(argc, argv, "--batch"))
+    {
+        return RunBatch<Traits>(argc, argv);
+    }
+
+    return RunProcessor<Traits>(argc, argv);
 }
 
 int main(int argc, char* argv[])
 {
+    int result = 0;
+
     try
     {
-        // Initialize logger
+        const bool daemonMode = HasOption(argc, argv, "--daemon");
+        const int stopDescriptor = true == daemonMode ? CreateStopDescriptor() : -1;
+
+        // Initialize logger; a daemon may be writing its output to stdout,
+        // so it logs to the file only
         std::string logFile = std::string(DefaultLogFile);
-        Logger<DeribitTraits>::GetInstance().Initialize(logFile, LogLevel::Info, true, true);
+        const bool asynchronousLog = false == HasOption(argc, argv, "--sync-log");
+        Logger<DeribitTraits>::GetInstance().Initialize(logFile, LogLevel::Info, false == daemonMode, true,
+                                                        asynchronousLog);
 
         LOG_INFO("Fischer Framework - Deribit Order Processor");
         LOG_INFO("============================================");
 
-        std::string inputFile(DefaultInputFile);
-        std::string outputFile(DefaultOutputFile);
-
-        if (1 < argc)
+        if (true == daemonMode && 0 > stopDescriptor)
         {
-            inputFile = argv[1];
+            LOG_WARNING("Failed to install the stop signal handler; the daemon stops only at end of input");
         }
 
-        if (2 < argc)
+        // Fixed-point prices and amounts select a different traits instantiation
+        if (true == HasOption(argc, argv, "--decimal"))
         {
-            outputFile = argv[2];
+            LOG_INFO("Using fixed-point decimal prices and amounts");
+            result = Run<DeribitFixedPointTraits>(argc, argv, stopDescriptor);
+        }
+        else
+        {
+            result = Run<DeribitTraits>(argc, argv, stopDescriptor);
         }
 
-        LOG_INFO("Input:", inputFile);
-        LOG_INFO("Output:", outputFile);
-
-        OrderProcessor<DeribitTraits> processor;
-        processor.ProcessOrders(inputFile, outputFile);
-
-        PrintPerformanceMetrics(processor);
-
-        LOG_INFO("Processing complete!");
+        if (0 <= stopDescriptor)
+        {
+            ::close(stopDescriptor);
+        }
 
         // Shutdown logger
         Logger<DeribitTraits>::GetInstance().Shutdown();
@@ -70,5 +729,5 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    return 0;
+    return result;
 }
\ No newline at end of file